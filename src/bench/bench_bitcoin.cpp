@@ -16,7 +16,9 @@
 
 #include <bench/bench.h>
 
+#include <crypto/chacha20.h>
 #include <crypto/sha256.h>
+#include <crypto/siphash.h>
 #include <util/strencodings.h>
 #include <util/system.h>
 
@@ -53,6 +55,8 @@ int main(int argc, char** argv)
     ArgsManager argsman;
     SetupBenchArgs(argsman);
     SHA256AutoDetect();
+    ChaCha20AutoDetect();
+    SipHashAutoDetect();
     std::string error;
     if (!argsman.ParseParameters(argc, argv, error)) {
         tfm::format(std::cerr, "Error parsing command line arguments: %s\n", error);
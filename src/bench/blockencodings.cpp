@@ -0,0 +1,68 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <amount.h>
+#include <bench/bench.h>
+#include <blockencodings.h>
+#include <primitives/block.h>
+#include <script/script.h>
+#include <test/util/setup_common.h>
+#include <txmempool.h>
+
+#include <vector>
+
+static CTransactionRef MakeTx(uint64_t i)
+{
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].scriptSig = CScript() << i;
+    tx.vin[0].scriptWitness.stack.push_back(std::vector<unsigned char>(1, i & 0xff));
+    tx.vout.resize(1);
+    tx.vout[0].scriptPubKey = CScript() << OP_TRUE;
+    tx.vout[0].nValue = COIN;
+    return MakeTransactionRef(tx);
+}
+
+// Reconstruct a compact block of 3000 transactions, most of them already in a
+// mempool of 50000 transactions
+static void CompactBlockReconstruction(benchmark::Bench& bench)
+{
+    const auto testing_setup = MakeNoLogFileContext<const TestingSetup>(CBaseChainParams::MAIN);
+    CTxMemPool pool;
+    CBlock block;
+    block.nBits = 0x207fffff;
+    block.vtx.push_back(MakeTx(0));
+    {
+        LOCK2(cs_main, pool.cs);
+        LockPoints lp;
+        for (uint64_t i = 1; i <= 50000; ++i) {
+            CTransactionRef tx = MakeTx(i);
+            pool.addUnchecked(CTxMemPoolEntry(tx, 1000, 0, 1, false, 4, lp));
+            if (i % 17 == 0 && block.vtx.size() < 3000) block.vtx.push_back(tx);
+        }
+        for (uint64_t i = 0; block.vtx.size() < 3000; ++i) block.vtx.push_back(MakeTx(100000 + i));
+    }
+    const CBlockHeaderAndShortTxIDs cmpctblock{block, /* fUseWTXID */ true};
+    const std::vector<std::pair<uint256, CTransactionRef>> extra_txn;
+
+    bench.minEpochIterations(10).run([&] {
+        PartiallyDownloadedBlock partial_block(&pool);
+        const ReadStatus status = partial_block.InitData(cmpctblock, extra_txn);
+        assert(status == READ_STATUS_OK);
+    });
+}
+
+BENCHMARK(CompactBlockReconstruction);
@@ -38,14 +38,8 @@ struct Available {
     Available(CTransactionRef& ref, size_t tx_count) : ref(ref), tx_count(tx_count){}
 };
 
-static void ComplexMemPool(benchmark::Bench& bench)
+static std::vector<CTransactionRef> CreateOrderedCoins(FastRandomContext& det_rand, int childTxs)
 {
-    int childTxs = 800;
-    if (bench.complexityN() > 1) {
-        childTxs = static_cast<int>(bench.complexityN());
-    }
-
-    FastRandomContext det_rand{true};
     std::vector<Available> available_coins;
     std::vector<CTransactionRef> ordered_coins;
     // Create some base transactions
@@ -91,6 +85,18 @@ static void ComplexMemPool(benchmark::Bench& bench)
         ordered_coins.emplace_back(MakeTransactionRef(tx));
         available_coins.emplace_back(ordered_coins.back(), tx_counter++);
     }
+    return ordered_coins;
+}
+
+static void ComplexMemPool(benchmark::Bench& bench)
+{
+    int childTxs = 800;
+    if (bench.complexityN() > 1) {
+        childTxs = static_cast<int>(bench.complexityN());
+    }
+
+    FastRandomContext det_rand{true};
+    std::vector<CTransactionRef> ordered_coins = CreateOrderedCoins(det_rand, childTxs);
     const auto testing_setup = MakeNoLogFileContext<const TestingSetup>(CBaseChainParams::MAIN);
     CTxMemPool pool;
     LOCK2(cs_main, pool.cs);
@@ -103,4 +109,29 @@ static void ComplexMemPool(benchmark::Bench& bench)
     });
 }
 
+static void MempoolAncestors(benchmark::Bench& bench)
+{
+    FastRandomContext det_rand{true};
+    std::vector<CTransactionRef> ordered_coins = CreateOrderedCoins(det_rand, 800);
+    const auto testing_setup = MakeNoLogFileContext<const TestingSetup>(CBaseChainParams::MAIN);
+    CTxMemPool pool;
+    LOCK2(cs_main, pool.cs);
+    for (auto& tx : ordered_coins) {
+        AddTx(tx, pool);
+    }
+    std::vector<CTxMemPool::txiter> entries;
+    for (auto& tx : ordered_coins) {
+        entries.push_back(*pool.GetIter(tx->GetHash()));
+    }
+    const uint64_t no_limit = std::numeric_limits<uint64_t>::max();
+    bench.run([&]() NO_THREAD_SAFETY_ANALYSIS {
+        for (CTxMemPool::txiter it : entries) {
+            CTxMemPool::setEntries ancestors;
+            std::string dummy;
+            pool.CalculateMemPoolAncestors(*it, ancestors, no_limit, no_limit, no_limit, no_limit, dummy, false);
+        }
+    });
+}
+
 BENCHMARK(ComplexMemPool);
+BENCHMARK(MempoolAncestors);
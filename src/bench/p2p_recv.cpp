@@ -0,0 +1,71 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chainparams.h>
+#include <hash.h>
+#include <net.h>
+#include <protocol.h>
+#include <random.h>
+#include <streams.h>
+
+#include <cassert>
+#include <cstring>
+#include <optional>
+#include <vector>
+
+// Receiving a flood of inv messages, the bulk of the message traffic on a
+// well-connected node: splitting the byte stream into messages and decoding
+// their payloads.
+static void DeserializeInvFlood(benchmark::Bench& bench)
+{
+    ArgsManager bench_args;
+    const auto chain_params = CreateChainParams(bench_args, CBaseChainParams::MAIN);
+
+    constexpr int NUM_MESSAGES{1000};
+    FastRandomContext rng{/* fDeterministic */ true};
+    std::vector<uint8_t> wire;
+    for (int i = 0; i < NUM_MESSAGES; ++i) {
+        // Mostly single announcements, with the occasional large batch
+        std::vector<CInv> invs(i % 50 == 0 ? 1000 : 1 + rng.randrange(8));
+        for (auto& inv : invs) inv = CInv{MSG_WTX, rng.rand256()};
+        std::vector<unsigned char> payload;
+        CVectorWriter{SER_NETWORK, PROTOCOL_VERSION, payload, 0, invs};
+
+        CMessageHeader hdr{chain_params->MessageStart(), NetMsgType::INV, static_cast<unsigned int>(payload.size())};
+        const uint256 hash{Hash(payload)};
+        std::memcpy(hdr.pchChecksum, hash.begin(), CMessageHeader::CHECKSUM_SIZE);
+        CVectorWriter{SER_NETWORK, INIT_PROTO_VERSION, wire, wire.size(), hdr};
+        wire.insert(wire.end(), payload.begin(), payload.end());
+    }
+
+    V1TransportDeserializer deserializer{*chain_params, /* node_id */ 0, SER_NETWORK, INIT_PROTO_VERSION};
+    bench.batch(NUM_MESSAGES).unit("message").run([&] {
+        Span<const uint8_t> bytes{wire};
+        while (!bytes.empty()) {
+            const int handled{deserializer.Read(bytes)};
+            assert(handled >= 0);
+            if (!deserializer.Complete()) continue;
+            uint32_t out_err_raw_size{0};
+            std::optional<CNetMessage> msg{deserializer.GetMessage(std::chrono::microseconds{0}, out_err_raw_size)};
+            assert(msg);
+            std::vector<CInv> invs;
+            msg->m_recv >> invs;
+        }
+    });
+}
+
+BENCHMARK(DeserializeInvFlood);
@@ -18,6 +18,7 @@
 #include <bench/data.h>
 
 #include <rpc/blockchain.h>
+#include <rpc/jsonwriter.h>
 #include <streams.h>
 #include <test/util/setup_common.h>
 #include <validation.h>
@@ -52,7 +53,7 @@ static void BlockToJsonVerbose(benchmark::Bench& bench)
 {
     TestBlockAndIndex data;
     bench.run([&] {
-        auto univalue = blockToJSON(data.block, &data.blockindex, &data.blockindex, /*verbose*/ true);
+        auto univalue = blockToJSON(data.block, &data.blockindex, &data.blockindex, TxVerbosity::SHOW_DETAILS);
         ankerl::nanobench::doNotOptimizeAway(univalue);
     });
 }
@@ -62,7 +63,7 @@ BENCHMARK(BlockToJsonVerbose);
 static void BlockToJsonVerboseWrite(benchmark::Bench& bench)
 {
     TestBlockAndIndex data;
-    auto univalue = blockToJSON(data.block, &data.blockindex, &data.blockindex, /*verbose*/ true);
+    auto univalue = blockToJSON(data.block, &data.blockindex, &data.blockindex, TxVerbosity::SHOW_DETAILS);
     bench.run([&] {
         auto str = univalue.write();
         ankerl::nanobench::doNotOptimizeAway(str);
@@ -70,3 +71,34 @@ static void BlockToJsonVerboseWrite(benchmark::Bench& bench)
 }
 
 BENCHMARK(BlockToJsonVerboseWrite);
+
+static void BlockToJsonVerboseStream(benchmark::Bench& bench)
+{
+    TestBlockAndIndex data;
+    bench.run([&] {
+        size_t size{0};
+        JSONWriter writer{1 << 20, [&](std::string& chunk) {
+            size += chunk.size();
+            chunk.clear();
+        }};
+        blockToJSON(writer, data.block, &data.blockindex, &data.blockindex, TxVerbosity::SHOW_DETAILS);
+        size += writer.Release().size();
+        ankerl::nanobench::doNotOptimizeAway(size);
+    });
+}
+
+BENCHMARK(BlockToJsonVerboseStream);
+
+static void BlockToJsonVerboseRead(benchmark::Bench& bench)
+{
+    TestBlockAndIndex data;
+    const std::string json = blockToJSON(data.block, &data.blockindex, &data.blockindex, TxVerbosity::SHOW_DETAILS).write();
+    bench.run([&] {
+        UniValue univalue;
+        bool ok = univalue.read(json);
+        assert(ok);
+        ankerl::nanobench::doNotOptimizeAway(univalue);
+    });
+}
+
+BENCHMARK(BlockToJsonVerboseRead);
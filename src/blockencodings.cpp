@@ -26,8 +26,13 @@
 #include <validation.h>
 #include <util/system.h>
 
+#include <bitset>
 #include <unordered_map>
 
+/** Number of bits in the filter of short IDs checked before the hash map lookup
+ *  when matching mempool transactions; 8 KiB, which stays in L1 cache */
+static constexpr size_t SHORTID_FILTER_SIZE = 1 << 16;
+
 CBlockHeaderAndShortTxIDs::CBlockHeaderAndShortTxIDs(const CBlock& block, bool fUseWTXID) :
         nonce(GetRand(std::numeric_limits<uint64_t>::max())),
         shorttxids(block.vtx.size() - 1), prefilledtxn(1), header(block) {
@@ -56,6 +61,11 @@ uint64_t CBlockHeaderAndShortTxIDs::GetShortID(const uint256& txhash) const {
     return SipHashUint256(shorttxidk0, shorttxidk1, txhash) & 0xffffffffffffL;
 }
 
+void CBlockHeaderAndShortTxIDs::GetShortIDs(const uint256* const txhashes[4], uint64_t shortids[4]) const {
+    SipHashUint256_4way(shorttxidk0, shorttxidk1, txhashes, shortids);
+    for (int i = 0; i < 4; ++i) shortids[i] &= 0xffffffffffffL;
+}
+
 
 
 ReadStatus PartiallyDownloadedBlock::InitData(const CBlockHeaderAndShortTxIDs& cmpctblock, const std::vector<std::pair<uint256, CTransactionRef>>& extra_txn) {
@@ -114,11 +124,29 @@ ReadStatus PartiallyDownloadedBlock::InitData(const CBlockHeaderAndShortTxIDs& c
     if (shorttxids.size() != cmpctblock.shorttxids.size())
         return READ_STATUS_FAILED; // Short ID collision
 
+    // Nearly all mempool transactions are not in the block. Short IDs are
+    // uniformly distributed, so a bitmap of their low bits rejects most of
+    // those without a hash map lookup.
+    std::bitset<SHORTID_FILTER_SIZE> shortid_filter;
+    for (const uint64_t shortid : cmpctblock.shorttxids) {
+        shortid_filter.set(shortid % SHORTID_FILTER_SIZE);
+    }
+
     std::vector<bool> have_txn(txn_available.size());
     {
     LOCK(pool->cs);
-    for (size_t i = 0; i < pool->vTxHashes.size(); i++) {
-        uint64_t shortid = cmpctblock.GetShortID(pool->vTxHashes[i].first);
+    const size_t pool_size = pool->vTxHashes.size();
+    uint64_t shortid_batch[4];
+    for (size_t i = 0; i < pool_size; i++) {
+        if (i % 4 == 0) {
+            // Compute the next four short IDs together (repeating the last
+            // transaction past the end of the mempool)
+            const uint256* txhashes[4];
+            for (size_t j = 0; j < 4; j++) txhashes[j] = &pool->vTxHashes[std::min(i + j, pool_size - 1)].first;
+            cmpctblock.GetShortIDs(txhashes, shortid_batch);
+        }
+        uint64_t shortid = shortid_batch[i % 4];
+        if (!shortid_filter[shortid % SHORTID_FILTER_SIZE]) continue;
         std::unordered_map<uint64_t, uint16_t>::iterator idit = shorttxids.find(shortid);
         if (idit != shorttxids.end()) {
             if (!have_txn[idit->second]) {
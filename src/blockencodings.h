@@ -120,6 +120,9 @@ public:
 
     uint64_t GetShortID(const uint256& txhash) const;
 
+    /** Compute the short IDs of four transaction hashes at once */
+    void GetShortIDs(const uint256* const txhashes[4], uint64_t shortids[4]) const;
+
     size_t BlockTxCount() const { return shorttxids.size() + prefilledtxn.size(); }
 
     SERIALIZE_METHODS(CBlockHeaderAndShortTxIDs, obj)
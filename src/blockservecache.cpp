@@ -0,0 +1,69 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <blockservecache.h>
+
+#include <memusage.h>
+
+namespace {
+/** Memory used by one cache entry: the serialization plus the list and map
+ *  nodes and the shared_ptr control block that refer to it. */
+size_t EntryUsage(const SharedPayload& payload)
+{
+    return memusage::DynamicUsage(payload.data) + memusage::MallocUsage(sizeof(SharedPayload) + 2 * sizeof(void*)) +
+           2 * memusage::MallocUsage(sizeof(uint256) + 8 * sizeof(void*));
+}
+} // namespace
+
+BlockServeCache::Data BlockServeCache::Get(const uint256& hash, bool witness)
+{
+    LOCK(m_mutex);
+    const auto it = m_index.find(Key{hash, witness});
+    if (it == m_index.end()) return nullptr;
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return it->second->data;
+}
+
+void BlockServeCache::Insert(const uint256& hash, bool witness, Data data)
+{
+    const size_t usage{EntryUsage(*data)};
+    if (usage > m_max_bytes) return;
+
+    LOCK(m_mutex);
+    const Key key{hash, witness};
+    if (m_index.count(key)) return;
+    while (m_usage + usage > m_max_bytes) {
+        const Entry& oldest = m_entries.back();
+        m_usage -= oldest.usage;
+        m_index.erase(oldest.key);
+        m_entries.pop_back();
+    }
+    m_entries.push_front(Entry{key, std::move(data), usage});
+    m_index.emplace(key, m_entries.begin());
+    m_usage += usage;
+}
+
+size_t BlockServeCache::Size() const
+{
+    LOCK(m_mutex);
+    return m_entries.size();
+}
+
+size_t BlockServeCache::DynamicMemoryUsage() const
+{
+    LOCK(m_mutex);
+    return m_usage;
+}
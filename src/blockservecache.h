@@ -0,0 +1,78 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BLOCKSERVECACHE_H
+#define BITCOIN_BLOCKSERVECACHE_H
+
+#include <net.h>
+#include <sync.h>
+#include <uint256.h>
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/** Least recently used cache of serialized blocks, used to answer getdata
+ *  requests for recent blocks without reading and re-serializing them.
+ *
+ *  Blocks are keyed by hash and encoding (with or without witness data), so
+ *  the same block may be cached in both encodings. The cache is bounded by
+ *  memory usage rather than by number of blocks. Cached payloads are shared
+ *  with the send queues of the peers they are sent to, so an entry handed
+ *  out by Get() remains valid after it is evicted.
+ */
+class BlockServeCache
+{
+public:
+    using Data = std::shared_ptr<const SharedPayload>;
+
+    explicit BlockServeCache(size_t max_bytes) : m_max_bytes(max_bytes) {}
+
+    /** Return the serialized block, or nullptr if it is not cached */
+    Data Get(const uint256& hash, bool witness) LOCKS_EXCLUDED(m_mutex);
+
+    /** Add a serialized block, evicting the least recently used blocks as
+     *  needed. Blocks larger than the whole cache are not added. */
+    void Insert(const uint256& hash, bool witness, Data data) LOCKS_EXCLUDED(m_mutex);
+
+    /** Number of cached serializations */
+    size_t Size() const LOCKS_EXCLUDED(m_mutex);
+
+    /** Estimated memory used by the cached serializations */
+    size_t DynamicMemoryUsage() const LOCKS_EXCLUDED(m_mutex);
+
+private:
+    using Key = std::pair<uint256, bool>;
+
+    struct Entry {
+        Key key;
+        Data data;
+        size_t usage;
+    };
+
+    const size_t m_max_bytes;
+
+    mutable Mutex m_mutex;
+    //! Entries, most recently used first
+    std::list<Entry> m_entries GUARDED_BY(m_mutex);
+    std::map<Key, std::list<Entry>::iterator> m_index GUARDED_BY(m_mutex);
+    size_t m_usage GUARDED_BY(m_mutex){0};
+};
+
+#endif // BITCOIN_BLOCKSERVECACHE_H
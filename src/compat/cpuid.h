@@ -32,5 +32,39 @@ void static inline GetCPUID(uint32_t leaf, uint32_t subleaf, uint32_t& a, uint32
 #endif
 }
 
+/** Instruction set extensions used by the optimized crypto implementations. */
+struct CPUFeatures
+{
+    bool sse4{false};
+    //! AVX2, with the AVX registers enabled by the OS
+    bool avx2{false};
+    bool shani{false};
+};
+
+/** Detect the CPUFeatures of this machine. Leaf 7 is only queried on CPUs
+ * with SSE4.1, all of which support it. */
+static inline CPUFeatures GetCPUFeatures()
+{
+    CPUFeatures features;
+    uint32_t eax, ebx, ecx, edx;
+    GetCPUID(1, 0, eax, ebx, ecx, edx);
+    features.sse4 = (ecx >> 19) & 1;
+    const bool have_xsave = (ecx >> 27) & 1;
+    const bool have_avx = (ecx >> 28) & 1;
+    bool enabled_avx = false;
+    if (have_xsave && have_avx) {
+        // Check whether the OS has enabled AVX registers
+        uint32_t a, d;
+        __asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+        enabled_avx = (a & 6) == 6;
+    }
+    if (features.sse4) {
+        GetCPUID(7, 0, eax, ebx, ecx, edx);
+        features.avx2 = ((ebx >> 5) & 1) && enabled_avx;
+        features.shani = (ebx >> 29) & 1;
+    }
+    return features;
+}
+
 #endif // defined(__x86_64__) || defined(__amd64__) || defined(__i386__)
 #endif // BITCOIN_COMPAT_CPUID_H
@@ -65,6 +65,11 @@ enum class TxValidationResult {
      */
     TX_CONFLICT,
     TX_MEMPOOL_POLICY,        //!< violated mempool's fee/size/descendant/RBF/etc limits
+    /**
+     * Feerate below the mempool or relay minimum. The transaction may still be
+     * accepted as part of a package with a child paying for it.
+     */
+    TX_RECONSIDERABLE,
 };
 
 /** A "reason" why a block was invalid, suitable for determining whether the
@@ -22,6 +22,27 @@
 
 #include <string.h>
 
+#include <compat/cpuid.h>
+
+namespace chacha20_sse41
+{
+void Crypt_4way(const uint32_t* input, const unsigned char* m, unsigned char* c);
+}
+
+namespace chacha20_avx2
+{
+void Crypt_8way(const uint32_t* input, const unsigned char* m, unsigned char* c);
+}
+
+namespace
+{
+typedef void (*CryptMultiFn)(const uint32_t* input, const unsigned char* m, unsigned char* c);
+
+/** Kernel processing several consecutive blocks at once (nullptr if none was detected), and its block count. */
+CryptMultiFn CryptMulti = nullptr;
+unsigned int multi_blocks = 0;
+} // namespace
+
 constexpr static inline uint32_t rotl32(uint32_t v, int c) { return (v << c) | (v >> (32 - c)); }
 
 #define QUARTERROUND(a,b,c,d) \
@@ -83,6 +104,19 @@ void ChaCha20::Seek(uint64_t pos)
     input[13] = pos >> 32;
 }
 
+void ChaCha20::CryptBlocks(const unsigned char*& m, unsigned char*& c, size_t& bytes)
+{
+    if (!CryptMulti) return;
+    const size_t multi_bytes = 64 * multi_blocks;
+    while (bytes >= multi_bytes) {
+        CryptMulti(input, m, c);
+        Seek((input[12] | (uint64_t)input[13] << 32) + multi_blocks);
+        if (m) m += multi_bytes;
+        c += multi_bytes;
+        bytes -= multi_bytes;
+    }
+}
+
 void ChaCha20::Keystream(unsigned char* c, size_t bytes)
 {
     uint32_t x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
@@ -91,6 +125,8 @@ void ChaCha20::Keystream(unsigned char* c, size_t bytes)
     unsigned char tmp[64];
     unsigned int i;
 
+    const unsigned char* m = nullptr;
+    CryptBlocks(m, c, bytes);
     if (!bytes) return;
 
     j0 = input[0];
@@ -199,6 +235,7 @@ void ChaCha20::Crypt(const unsigned char* m, unsigned char* c, size_t bytes)
     unsigned char tmp[64];
     unsigned int i;
 
+    CryptBlocks(m, c, bytes);
     if (!bytes) return;
 
     j0 = input[0];
@@ -320,3 +357,30 @@ void ChaCha20::Crypt(const unsigned char* m, unsigned char* c, size_t bytes)
         m += 64;
     }
 }
+
+std::string ChaCha20AutoDetect()
+{
+    std::string ret = "standard";
+#if defined(USE_ASM) && defined(HAVE_GETCPUID)
+    const CPUFeatures cpu = GetCPUFeatures();
+    (void)cpu;
+
+#if defined(ENABLE_SSE41) && !defined(BUILD_BITCOIN_INTERNAL)
+    if (cpu.sse4) {
+        CryptMulti = chacha20_sse41::Crypt_4way;
+        multi_blocks = 4;
+        ret = "sse41(4way)";
+    }
+#endif
+
+#if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
+    if (cpu.avx2) {
+        CryptMulti = chacha20_avx2::Crypt_8way;
+        multi_blocks = 8;
+        ret = "avx2(8way)";
+    }
+#endif
+#endif
+
+    return ret;
+}
@@ -19,6 +19,7 @@
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <string>
 
 /** A class for ChaCha20 256-bit stream cipher developed by Daniel J. Bernstein
     https://cr.yp.to/chacha/chacha-20080128.pdf */
@@ -27,6 +28,9 @@ class ChaCha20
 private:
     uint32_t input[16];
 
+    /** process as many whole multi-block batches as the detected kernel handles, advancing the pointers */
+    void CryptBlocks(const unsigned char*& m, unsigned char*& c, size_t& bytes);
+
 public:
     ChaCha20();
     ChaCha20(const unsigned char* key, size_t keylen);
@@ -43,4 +47,9 @@ public:
     void Crypt(const unsigned char* input, unsigned char* output, size_t bytes);
 };
 
+/** Autodetect the best available ChaCha20 implementation.
+ *  Returns the name of the implementation.
+ */
+std::string ChaCha20AutoDetect();
+
 #endif // BITCOIN_CRYPTO_CHACHA20_H
@@ -0,0 +1,95 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifdef ENABLE_AVX2
+
+#include <stdint.h>
+#include <immintrin.h>
+
+namespace chacha20_avx2 {
+namespace {
+
+__m256i inline K(uint32_t x) { return _mm256_set1_epi32(x); }
+__m256i inline Add(__m256i x, __m256i y) { return _mm256_add_epi32(x, y); }
+__m256i inline Xor(__m256i x, __m256i y) { return _mm256_xor_si256(x, y); }
+template <int n> __m256i inline RotL(__m256i x) { return _mm256_or_si256(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32 - n)); }
+__m256i inline RotL8(__m256i x) { return _mm256_shuffle_epi8(x, _mm256_setr_epi8(3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14, 3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14)); }
+__m256i inline RotL16(__m256i x) { return _mm256_shuffle_epi8(x, _mm256_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13, 2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13)); }
+
+void inline QuarterRound(__m256i& a, __m256i& b, __m256i& c, __m256i& d)
+{
+    a = Add(a, b); d = RotL16(Xor(d, a));
+    c = Add(c, d); b = RotL<12>(Xor(b, c));
+    a = Add(a, b); d = RotL8(Xor(d, a));
+    c = Add(c, d); b = RotL<7>(Xor(b, c));
+}
+
+void inline Store(__m128i v, const unsigned char* m, unsigned char* c)
+{
+    if (m) v = _mm_xor_si128(v, _mm_loadu_si128((const __m128i*)m));
+    _mm_storeu_si128((__m128i*)c, v);
+}
+
+/** Write words i..i+3 of all 8 blocks, optionally xored with the message.
+ *  The unpack instructions work within each 128-bit half, so the low half
+ *  holds blocks 0-3 and the high half blocks 4-7. */
+void inline Write8(const __m256i* x, int i, const unsigned char* m, unsigned char* c)
+{
+    __m256i t0 = _mm256_unpacklo_epi32(x[i], x[i + 1]);
+    __m256i t1 = _mm256_unpacklo_epi32(x[i + 2], x[i + 3]);
+    __m256i t2 = _mm256_unpackhi_epi32(x[i], x[i + 1]);
+    __m256i t3 = _mm256_unpackhi_epi32(x[i + 2], x[i + 3]);
+    __m256i r[4] = {_mm256_unpacklo_epi64(t0, t1), _mm256_unpackhi_epi64(t0, t1), _mm256_unpacklo_epi64(t2, t3), _mm256_unpackhi_epi64(t2, t3)};
+    for (int b = 0; b < 4; ++b) {
+        const int lo = 64 * b + 4 * i, hi = 64 * (b + 4) + 4 * i;
+        Store(_mm256_castsi256_si128(r[b]), m ? m + lo : nullptr, c + lo);
+        Store(_mm256_extracti128_si256(r[b], 1), m ? m + hi : nullptr, c + hi);
+    }
+}
+
+} // namespace
+
+void Crypt_8way(const uint32_t* input, const unsigned char* m, unsigned char* c)
+{
+    const uint64_t pos = input[12] | (uint64_t)input[13] << 32;
+    __m256i j[16];
+    for (int i = 0; i < 16; ++i) j[i] = K(input[i]);
+    j[12] = _mm256_setr_epi32(pos, pos + 1, pos + 2, pos + 3, pos + 4, pos + 5, pos + 6, pos + 7);
+    j[13] = _mm256_setr_epi32(pos >> 32, (pos + 1) >> 32, (pos + 2) >> 32, (pos + 3) >> 32, (pos + 4) >> 32, (pos + 5) >> 32, (pos + 6) >> 32, (pos + 7) >> 32);
+
+    __m256i x[16];
+    for (int i = 0; i < 16; ++i) x[i] = j[i];
+    for (int i = 0; i < 10; ++i) {
+        QuarterRound(x[0], x[4], x[8], x[12]);
+        QuarterRound(x[1], x[5], x[9], x[13]);
+        QuarterRound(x[2], x[6], x[10], x[14]);
+        QuarterRound(x[3], x[7], x[11], x[15]);
+        QuarterRound(x[0], x[5], x[10], x[15]);
+        QuarterRound(x[1], x[6], x[11], x[12]);
+        QuarterRound(x[2], x[7], x[8], x[13]);
+        QuarterRound(x[3], x[4], x[9], x[14]);
+    }
+    for (int i = 0; i < 16; ++i) x[i] = Add(x[i], j[i]);
+
+    Write8(x, 0, m, c);
+    Write8(x, 4, m, c);
+    Write8(x, 8, m, c);
+    Write8(x, 12, m, c);
+}
+
+}
+
+#endif
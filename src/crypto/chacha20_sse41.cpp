@@ -0,0 +1,87 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifdef ENABLE_SSE41
+
+#include <stdint.h>
+#include <immintrin.h>
+
+namespace chacha20_sse41 {
+namespace {
+
+__m128i inline K(uint32_t x) { return _mm_set1_epi32(x); }
+__m128i inline Add(__m128i x, __m128i y) { return _mm_add_epi32(x, y); }
+__m128i inline Xor(__m128i x, __m128i y) { return _mm_xor_si128(x, y); }
+template <int n> __m128i inline RotL(__m128i x) { return _mm_or_si128(_mm_slli_epi32(x, n), _mm_srli_epi32(x, 32 - n)); }
+__m128i inline RotL8(__m128i x) { return _mm_shuffle_epi8(x, _mm_setr_epi8(3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14)); }
+__m128i inline RotL16(__m128i x) { return _mm_shuffle_epi8(x, _mm_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13)); }
+
+void inline QuarterRound(__m128i& a, __m128i& b, __m128i& c, __m128i& d)
+{
+    a = Add(a, b); d = RotL16(Xor(d, a));
+    c = Add(c, d); b = RotL<12>(Xor(b, c));
+    a = Add(a, b); d = RotL8(Xor(d, a));
+    c = Add(c, d); b = RotL<7>(Xor(b, c));
+}
+
+/** Write words i..i+3 of all 4 blocks, optionally xored with the message. */
+void inline Write4(const __m128i* x, int i, const unsigned char* m, unsigned char* c)
+{
+    __m128i t0 = _mm_unpacklo_epi32(x[i], x[i + 1]);
+    __m128i t1 = _mm_unpacklo_epi32(x[i + 2], x[i + 3]);
+    __m128i t2 = _mm_unpackhi_epi32(x[i], x[i + 1]);
+    __m128i t3 = _mm_unpackhi_epi32(x[i + 2], x[i + 3]);
+    __m128i r[4] = {_mm_unpacklo_epi64(t0, t1), _mm_unpackhi_epi64(t0, t1), _mm_unpacklo_epi64(t2, t3), _mm_unpackhi_epi64(t2, t3)};
+    for (int b = 0; b < 4; ++b) {
+        __m128i v = r[b];
+        if (m) v = Xor(v, _mm_loadu_si128((const __m128i*)(m + 64 * b + 4 * i)));
+        _mm_storeu_si128((__m128i*)(c + 64 * b + 4 * i), v);
+    }
+}
+
+} // namespace
+
+void Crypt_4way(const uint32_t* input, const unsigned char* m, unsigned char* c)
+{
+    const uint64_t pos = input[12] | (uint64_t)input[13] << 32;
+    __m128i j[16];
+    for (int i = 0; i < 16; ++i) j[i] = K(input[i]);
+    j[12] = _mm_setr_epi32(pos, pos + 1, pos + 2, pos + 3);
+    j[13] = _mm_setr_epi32(pos >> 32, (pos + 1) >> 32, (pos + 2) >> 32, (pos + 3) >> 32);
+
+    __m128i x[16];
+    for (int i = 0; i < 16; ++i) x[i] = j[i];
+    for (int i = 0; i < 10; ++i) {
+        QuarterRound(x[0], x[4], x[8], x[12]);
+        QuarterRound(x[1], x[5], x[9], x[13]);
+        QuarterRound(x[2], x[6], x[10], x[14]);
+        QuarterRound(x[3], x[7], x[11], x[15]);
+        QuarterRound(x[0], x[5], x[10], x[15]);
+        QuarterRound(x[1], x[6], x[11], x[12]);
+        QuarterRound(x[2], x[7], x[8], x[13]);
+        QuarterRound(x[3], x[4], x[9], x[14]);
+    }
+    for (int i = 0; i < 16; ++i) x[i] = Add(x[i], j[i]);
+
+    Write4(x, 0, m, c);
+    Write4(x, 4, m, c);
+    Write4(x, 8, m, c);
+    Write4(x, 12, m, c);
+}
+
+}
+
+#endif
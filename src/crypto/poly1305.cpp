@@ -22,6 +22,106 @@
 
 #include <string.h>
 
+#ifdef HAVE___INT128
+// 64-bit limbs (poly1305-donna-64): three 44/44/42-bit limbs need a third of the
+// multiplications of the 26-bit limb code below.
+typedef unsigned __int128 uint128_t;
+
+void poly1305_auth(unsigned char out[POLY1305_TAGLEN], const unsigned char *m, size_t inlen, const unsigned char key[POLY1305_KEYLEN]) {
+    uint64_t t0,t1;
+    uint64_t h0,h1,h2;
+    uint64_t r0,r1,r2;
+    uint64_t s1,s2;
+    uint64_t g0,g1,g2;
+    uint64_t c, hibit;
+    uint128_t d0,d1,d2;
+    unsigned char mp[16];
+    size_t j;
+
+    /* clamp key */
+    t0 = ReadLE64(key+0);
+    t1 = ReadLE64(key+8);
+    r0 = ( t0                    ) & 0xffc0fffffff;
+    r1 = ((t0 >> 44) | (t1 << 20)) & 0xfffffc0ffff;
+    r2 = ((t1 >> 24)             ) & 0x00ffffffc0f;
+
+    /* precompute multipliers */
+    s1 = r1 * (5 << 2);
+    s2 = r2 * (5 << 2);
+
+    /* init state */
+    h0 = 0;
+    h1 = 0;
+    h2 = 0;
+
+    hibit = (uint64_t)1 << 40;
+    while (inlen) {
+        if (inlen < 16) {
+            /* final bytes */
+            for (j = 0; j < inlen; j++) mp[j] = m[j];
+            mp[j++] = 1;
+            for (; j < 16; j++) mp[j] = 0;
+            m = mp;
+            inlen = 16;
+            hibit = 0;
+        }
+
+        t0 = ReadLE64(m+0);
+        t1 = ReadLE64(m+8);
+        h0 += (( t0                    ) & 0xfffffffffff);
+        h1 += (((t0 >> 44) | (t1 << 20)) & 0xfffffffffff);
+        h2 += (((t1 >> 24)             ) & 0x3ffffffffff) | hibit;
+
+        d0 = (uint128_t)h0 * r0 + (uint128_t)h1 * s2 + (uint128_t)h2 * s1;
+        d1 = (uint128_t)h0 * r1 + (uint128_t)h1 * r0 + (uint128_t)h2 * s2;
+        d2 = (uint128_t)h0 * r2 + (uint128_t)h1 * r1 + (uint128_t)h2 * r0;
+
+                   c = (uint64_t)(d0 >> 44); h0 = (uint64_t)d0 & 0xfffffffffff;
+        d1 += c;   c = (uint64_t)(d1 >> 44); h1 = (uint64_t)d1 & 0xfffffffffff;
+        d2 += c;   c = (uint64_t)(d2 >> 42); h2 = (uint64_t)d2 & 0x3ffffffffff;
+        h0 += c * 5; c = h0 >> 44; h0 &= 0xfffffffffff;
+        h1 += c;
+
+        m += 16;
+        inlen -= 16;
+    }
+
+    /* fully carry h */
+                 c = h1 >> 44; h1 &= 0xfffffffffff;
+    h2 +=     c; c = h2 >> 42; h2 &= 0x3ffffffffff;
+    h0 += c * 5; c = h0 >> 44; h0 &= 0xfffffffffff;
+    h1 +=     c; c = h1 >> 44; h1 &= 0xfffffffffff;
+    h2 +=     c; c = h2 >> 42; h2 &= 0x3ffffffffff;
+    h0 += c * 5; c = h0 >> 44; h0 &= 0xfffffffffff;
+    h1 +=     c;
+
+    /* compute h + -p */
+    g0 = h0 + 5; c = g0 >> 44; g0 &= 0xfffffffffff;
+    g1 = h1 + c; c = g1 >> 44; g1 &= 0xfffffffffff;
+    g2 = h2 + c - ((uint64_t)1 << 42);
+
+    /* select h if h < p, or h + -p if h >= p */
+    c = (g2 >> 63) - 1;
+    g0 &= c;
+    g1 &= c;
+    g2 &= c;
+    c = ~c;
+    h0 = (h0 & c) | g0;
+    h1 = (h1 & c) | g1;
+    h2 = (h2 & c) | g2;
+
+    /* h = (h + pad) */
+    t0 = ReadLE64(key+16);
+    t1 = ReadLE64(key+24);
+    h0 += (( t0                    ) & 0xfffffffffff)    ; c = h0 >> 44; h0 &= 0xfffffffffff;
+    h1 += (((t0 >> 44) | (t1 << 20)) & 0xfffffffffff) + c; c = h1 >> 44; h1 &= 0xfffffffffff;
+    h2 += (((t1 >> 24)             ) & 0x3ffffffffff) + c;               h2 &= 0x3ffffffffff;
+
+    /* mac = h % (2^128) */
+    WriteLE64(&out[0], (h0      ) | (h1 << 44));
+    WriteLE64(&out[8], (h1 >> 20) | (h2 << 24));
+}
+#else
 #define mul32x32_64(a,b) ((uint64_t)(a) * (b))
 
 void poly1305_auth(unsigned char out[POLY1305_TAGLEN], const unsigned char *m, size_t inlen, const unsigned char key[POLY1305_KEYLEN]) {
@@ -151,3 +251,4 @@ poly1305_donna_finish:
     WriteLE32(&out[ 8], f2); f3 += (f2 >> 32);
     WriteLE32(&out[12], f3);
 }
+#endif
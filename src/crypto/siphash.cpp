@@ -14,8 +14,14 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#if defined(HAVE_CONFIG_H)
+#include <config/bitcoin-config.h>
+#endif
+
 #include <crypto/siphash.h>
 
+#include <compat/cpuid.h>
+
 #define ROTL(x, b) (uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
 
 #define SIPROUND do { \
@@ -27,6 +33,25 @@
     v2 = ROTL(v2, 32); \
 } while (0)
 
+namespace siphash_avx2
+{
+void Uint256_4way(uint64_t k0, uint64_t k1, const uint256* const vals[4], uint64_t out[4]);
+}
+
+namespace
+{
+void Uint256_4way_generic(uint64_t k0, uint64_t k1, const uint256* const vals[4], uint64_t out[4])
+{
+    for (int i = 0; i < 4; ++i) {
+        out[i] = SipHashUint256(k0, k1, *vals[i]);
+    }
+}
+
+typedef void (*Uint256_4wayFn)(uint64_t k0, uint64_t k1, const uint256* const vals[4], uint64_t out[4]);
+
+Uint256_4wayFn Uint256_4way = Uint256_4way_generic;
+} // namespace
+
 CSipHasher::CSipHasher(uint64_t k0, uint64_t k1)
 {
     v[0] = 0x736f6d6570736575ULL ^ k0;
@@ -143,6 +168,11 @@ uint64_t SipHashUint256(uint64_t k0, uint64_t k1, const uint256& val)
     return v0 ^ v1 ^ v2 ^ v3;
 }
 
+void SipHashUint256_4way(uint64_t k0, uint64_t k1, const uint256* const vals[4], uint64_t out[4])
+{
+    Uint256_4way(k0, k1, vals, out);
+}
+
 uint64_t SipHashUint256Extra(uint64_t k0, uint64_t k1, const uint256& val, uint32_t extra)
 {
     /* Specialized implementation for efficiency */
@@ -183,3 +213,21 @@ uint64_t SipHashUint256Extra(uint64_t k0, uint64_t k1, const uint256& val, uint3
     SIPROUND;
     return v0 ^ v1 ^ v2 ^ v3;
 }
+
+std::string SipHashAutoDetect()
+{
+    std::string ret = "standard";
+#if defined(USE_ASM) && defined(HAVE_GETCPUID)
+    const CPUFeatures cpu = GetCPUFeatures();
+    (void)cpu;
+
+#if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
+    if (cpu.avx2) {
+        Uint256_4way = siphash_avx2::Uint256_4way;
+        ret = "avx2(4way)";
+    }
+#endif
+#endif
+
+    return ret;
+}
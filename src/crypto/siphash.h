@@ -18,6 +18,7 @@
 #define BITCOIN_CRYPTO_SIPHASH_H
 
 #include <stdint.h>
+#include <string>
 
 #include <uint256.h>
 
@@ -56,4 +57,13 @@ public:
 uint64_t SipHashUint256(uint64_t k0, uint64_t k1, const uint256& val);
 uint64_t SipHashUint256Extra(uint64_t k0, uint64_t k1, const uint256& val, uint32_t extra);
 
+/** Compute SipHashUint256 of four values with the same key at once, using
+ *  the vectorized implementation selected by SipHashAutoDetect if any. */
+void SipHashUint256_4way(uint64_t k0, uint64_t k1, const uint256* const vals[4], uint64_t out[4]);
+
+/** Autodetect the best available SipHashUint256_4way implementation.
+ *  Returns the name of the implementation.
+ */
+std::string SipHashAutoDetect();
+
 #endif // BITCOIN_CRYPTO_SIPHASH_H
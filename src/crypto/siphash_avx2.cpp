@@ -0,0 +1,75 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifdef ENABLE_AVX2
+
+#include <stdint.h>
+#include <immintrin.h>
+
+#include <uint256.h>
+
+namespace siphash_avx2 {
+namespace {
+
+__m256i inline K(uint64_t x) { return _mm256_set1_epi64x(x); }
+__m256i inline Add(__m256i x, __m256i y) { return _mm256_add_epi64(x, y); }
+__m256i inline Xor(__m256i x, __m256i y) { return _mm256_xor_si256(x, y); }
+template <int n> __m256i inline RotL(__m256i x) { return _mm256_or_si256(_mm256_slli_epi64(x, n), _mm256_srli_epi64(x, 64 - n)); }
+__m256i inline RotL16(__m256i x) { return _mm256_shuffle_epi8(x, _mm256_setr_epi8(6, 7, 0, 1, 2, 3, 4, 5, 14, 15, 8, 9, 10, 11, 12, 13, 6, 7, 0, 1, 2, 3, 4, 5, 14, 15, 8, 9, 10, 11, 12, 13)); }
+__m256i inline RotL32(__m256i x) { return _mm256_shuffle_epi32(x, 0xb1); }
+
+void inline SipRound(__m256i& v0, __m256i& v1, __m256i& v2, __m256i& v3)
+{
+    v0 = Add(v0, v1); v1 = RotL<13>(v1); v1 = Xor(v1, v0);
+    v0 = RotL32(v0);
+    v2 = Add(v2, v3); v3 = RotL16(v3); v3 = Xor(v3, v2);
+    v0 = Add(v0, v3); v3 = RotL<21>(v3); v3 = Xor(v3, v0);
+    v2 = Add(v2, v1); v1 = RotL<17>(v1); v1 = Xor(v1, v2);
+    v2 = RotL32(v2);
+}
+
+void inline Compress(__m256i& v0, __m256i& v1, __m256i& v2, __m256i& v3, __m256i d)
+{
+    v3 = Xor(v3, d);
+    SipRound(v0, v1, v2, v3);
+    SipRound(v0, v1, v2, v3);
+    v0 = Xor(v0, d);
+}
+
+} // namespace
+
+void Uint256_4way(uint64_t k0, uint64_t k1, const uint256* const vals[4], uint64_t out[4])
+{
+    __m256i v0 = K(0x736f6d6570736575ULL ^ k0);
+    __m256i v1 = K(0x646f72616e646f6dULL ^ k1);
+    __m256i v2 = K(0x6c7967656e657261ULL ^ k0);
+    __m256i v3 = K(0x7465646279746573ULL ^ k1);
+
+    for (int i = 0; i < 4; ++i) {
+        Compress(v0, v1, v2, v3, _mm256_setr_epi64x(vals[0]->GetUint64(i), vals[1]->GetUint64(i), vals[2]->GetUint64(i), vals[3]->GetUint64(i)));
+    }
+    Compress(v0, v1, v2, v3, K(((uint64_t)4) << 59));
+    v2 = Xor(v2, K(0xFF));
+    SipRound(v0, v1, v2, v3);
+    SipRound(v0, v1, v2, v3);
+    SipRound(v0, v1, v2, v3);
+    SipRound(v0, v1, v2, v3);
+    _mm256_storeu_si256((__m256i*)out, Xor(Xor(v0, v1), Xor(v2, v3)));
+}
+
+} // namespace siphash_avx2
+
+#endif
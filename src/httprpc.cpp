@@ -19,6 +19,7 @@
 #include <chainparams.h>
 #include <crypto/hmac_sha256.h>
 #include <httpserver.h>
+#include <rpc/jsonwriter.h>
 #include <rpc/protocol.h>
 #include <rpc/server.h>
 #include <util/strencodings.h>
@@ -30,6 +31,7 @@
 #include <iterator>
 #include <map>
 #include <memory>
+#include <optional>
 #include <stdio.h>
 #include <set>
 #include <string>
@@ -39,6 +41,29 @@
 /** WWW-Authenticate to present with 401 Unauthorized response */
 static const char* WWW_AUTH_HEADER_DATA = "Basic realm=\"jsonrpc\"";
 
+/** Largest request body that is inspected to classify a request as light */
+static const size_t MAX_LIGHT_REQUEST_SIZE = 4096;
+
+/** RPC methods that are cheap to serve. Requests that only call these are
+ * served from the light HTTP work queue, so they are not held up by expensive
+ * calls like getblock or scantxoutset. */
+static const std::set<std::string> LIGHT_RPC_METHODS{
+    "echo",
+    "estimatesmartfee",
+    "getbestblockhash",
+    "getblockcount",
+    "getblockhash",
+    "getblockheader",
+    "getconnectioncount",
+    "getdifficulty",
+    "getindexinfo",
+    "getmempoolinfo",
+    "getnetworkinfo",
+    "getrpcinfo",
+    "ping",
+    "uptime",
+};
+
 /** Simple one-shot callback timer to be used by the RPC mechanism to e.g.
  * re-lock the wallet.
  */
@@ -85,6 +110,8 @@ static std::vector<std::vector<std::string>> g_rpcauth;
 /* RPC Auth Whitelist */
 static std::map<std::string, std::set<std::string>> g_rpc_whitelist;
 static bool g_rpc_whitelist_default = false;
+/* Maximum number of entries of a single batch request executed concurrently */
+static int g_rpc_batch_parallel = DEFAULT_RPC_BATCH_PARALLEL;
 
 static void JSONErrorReply(HTTPRequest* req, const UniValue& objError, const UniValue& id)
 {
@@ -156,6 +183,31 @@ static bool RPCAuthorized(const std::string& strAuth, std::string& strAuthUserna
     return multiUserAuthorized(strUserPass);
 }
 
+static HTTPRequestCost ClassifyJSONRPC(const HTTPRequest* req, const std::string&)
+{
+    // This runs on the event loop thread, so it only looks at the method
+    // names in a small body. Authorization is left to the worker.
+    if (req->GetRequestMethod() != HTTPRequest::POST) return HTTPRequestCost::NORMAL;
+    const std::optional<std::string> body = req->PeekBody(MAX_LIGHT_REQUEST_SIZE);
+    if (!body) return HTTPRequestCost::NORMAL;
+    UniValue valRequest;
+    if (!valRequest.read(*body)) return HTTPRequestCost::NORMAL;
+
+    auto is_light = [](const UniValue& request) {
+        if (!request.isObject()) return false;
+        const UniValue& method = find_value(request, "method");
+        return method.isStr() && LIGHT_RPC_METHODS.count(method.get_str()) > 0;
+    };
+    if (valRequest.isArray()) {
+        if (valRequest.empty()) return HTTPRequestCost::NORMAL;
+        for (unsigned int reqIdx = 0; reqIdx < valRequest.size(); reqIdx++) {
+            if (!is_light(valRequest[reqIdx])) return HTTPRequestCost::NORMAL;
+        }
+        return HTTPRequestCost::LIGHT;
+    }
+    return is_light(valRequest) ? HTTPRequestCost::LIGHT : HTTPRequestCost::NORMAL;
+}
+
 static bool HTTPReq_JSONRPC(const std::any& context, HTTPRequest* req)
 {
     // JSONRPC handles only POST
@@ -196,7 +248,6 @@ static bool HTTPReq_JSONRPC(const std::any& context, HTTPRequest* req)
         // Set the URI
         jreq.URI = req->GetURI();
 
-        std::string strReply;
         bool user_has_whitelist = g_rpc_whitelist.count(jreq.authUser);
         if (!user_has_whitelist && g_rpc_whitelist_default) {
             LogPrintf("RPC User %s not allowed to call any methods\n", jreq.authUser);
@@ -211,10 +262,27 @@ static bool HTTPReq_JSONRPC(const std::any& context, HTTPRequest* req)
                 req->WriteReply(HTTP_FORBIDDEN);
                 return false;
             }
+            // Large results may be written by the handler straight into the
+            // reply instead of being built as a UniValue first
+            JSONResultWriter result_writer;
+            jreq.result_writer = &result_writer;
             UniValue result = tableRPC.execute(jreq);
-
-            // Send reply
-            strReply = JSONRPCReply(result, NullUniValue, jreq.id);
+            jreq.result_writer = nullptr;
+
+            // Send reply. This is equivalent to JSONRPCReply(result,
+            // NullUniValue, jreq.id), but avoids copying the result into a
+            // reply object.
+            if (!req->WriteJSONReply([&](JSONWriter& writer) {
+                writer.Raw("{\"result\":");
+                if (result_writer) {
+                    result_writer(writer);
+                } else {
+                    writer.Value(result);
+                }
+                writer.Raw(",\"error\":null,\"id\":" + jreq.id.write() + "}\n");
+            })) {
+                return false;
+            }
 
         // array of requests
         } else if (valRequest.isArray()) {
@@ -234,13 +302,14 @@ static bool HTTPReq_JSONRPC(const std::any& context, HTTPRequest* req)
                     }
                 }
             }
-            strReply = JSONRPCExecBatch(jreq, valRequest.get_array());
+            const UniValue replies = JSONRPCExecBatch(jreq, valRequest.get_array(), g_rpc_batch_parallel, HTTPRunTask);
+            req->WriteJSONReply([&](JSONWriter& writer) {
+                writer.Value(replies);
+                writer.Raw("\n");
+            });
         }
         else
             throw JSONRPCError(RPC_PARSE_ERROR, "Top-level object parse error");
-
-        req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strReply);
     } catch (const UniValue& objError) {
         JSONErrorReply(req, objError, jreq.id);
         return false;
@@ -307,10 +376,12 @@ bool StartHTTPRPC(const std::any& context)
     if (!InitRPCAuthentication())
         return false;
 
+    g_rpc_batch_parallel = std::max<int64_t>(gArgs.GetArg("-rpcbatchparallel", DEFAULT_RPC_BATCH_PARALLEL), 1);
+
     auto handle_rpc = [context](HTTPRequest* req, const std::string&) { return HTTPReq_JSONRPC(context, req); };
-    RegisterHTTPHandler("/", true, handle_rpc);
+    RegisterHTTPHandler("/", true, handle_rpc, ClassifyJSONRPC);
     if (g_wallet_init_interface.HasWalletSupport()) {
-        RegisterHTTPHandler("/wallet/", false, handle_rpc);
+        RegisterHTTPHandler("/wallet/", false, handle_rpc, ClassifyJSONRPC);
     }
     struct event_base* eventBase = EventBase();
     assert(eventBase);
@@ -19,6 +19,9 @@
 
 #include <any>
 
+/** Default for -rpcbatchparallel */
+static const int DEFAULT_RPC_BATCH_PARALLEL = 1;
+
 /** Start HTTP RPC subsystem.
  * Precondition; HTTP and RPC has been started.
  */
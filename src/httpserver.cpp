@@ -20,6 +20,7 @@
 #include <compat.h>
 #include <netbase.h>
 #include <node/ui_interface.h>
+#include <rpc/jsonwriter.h>
 #include <rpc/protocol.h> // For HTTP status codes
 #include <shutdown.h>
 #include <sync.h>
@@ -28,8 +29,11 @@
 #include <util/threadnames.h>
 #include <util/translation.h>
 
+#include <chrono>
+#include <condition_variable>
 #include <deque>
 #include <memory>
+#include <set>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string>
@@ -68,22 +72,48 @@ private:
     HTTPRequestHandler func;
 };
 
+/** Work item that is not associated with a request */
+class HTTPTaskItem final : public HTTPClosure
+{
+public:
+    explicit HTTPTaskItem(std::function<void()> _task) : task(std::move(_task))
+    {
+    }
+    void operator()() override
+    {
+        task();
+    }
+
+private:
+    std::function<void()> task;
+};
+
 /** Simple work queue for distributing work over multiple threads.
- * Work items are simply callable objects.
+ * Work items are simply callable objects. Light items are kept in a separate
+ * queue that is served first, and can additionally be served by threads that
+ * run nothing else. Other items are queued up to maxDepth; light items can
+ * also use the extra slots reserved for them on top of that.
  */
 template <typename WorkItem>
 class WorkQueue
 {
 private:
     Mutex cs;
+    //! Signalled for every new item, waited on by threads serving all items
     std::condition_variable cond GUARDED_BY(cs);
+    //! Signalled for new light items, waited on by light-only threads
+    std::condition_variable cond_light GUARDED_BY(cs);
     std::deque<std::unique_ptr<WorkItem>> queue GUARDED_BY(cs);
+    std::deque<std::unique_ptr<WorkItem>> queue_light GUARDED_BY(cs);
     bool running GUARDED_BY(cs);
     const size_t maxDepth;
+    //! Slots reserved for light items in addition to maxDepth
+    const size_t lightReserve;
 
 public:
     explicit WorkQueue(size_t _maxDepth) : running(true),
-                                 maxDepth(_maxDepth)
+                                 maxDepth(_maxDepth),
+                                 lightReserve(std::max<size_t>(_maxDepth / 4, 1))
     {
     }
     /** Precondition: worker threads have all stopped (they have been joined).
@@ -92,29 +122,33 @@ public:
     {
     }
     /** Enqueue a work item */
-    bool Enqueue(WorkItem* item)
+    bool Enqueue(WorkItem* item, bool light = false)
     {
         LOCK(cs);
-        if (queue.size() >= maxDepth) {
+        const size_t depth = queue.size() + queue_light.size();
+        if (depth >= (light ? maxDepth + lightReserve : maxDepth)) {
             return false;
         }
-        queue.emplace_back(std::unique_ptr<WorkItem>(item));
+        auto& q = light ? queue_light : queue;
+        q.emplace_back(std::unique_ptr<WorkItem>(item));
+        if (light) cond_light.notify_one();
         cond.notify_one();
         return true;
     }
     /** Thread function */
-    void Run()
+    void Run(bool light_only = false)
     {
         while (true) {
             std::unique_ptr<WorkItem> i;
             {
                 WAIT_LOCK(cs, lock);
-                while (running && queue.empty())
-                    cond.wait(lock);
+                while (running && queue_light.empty() && (light_only || queue.empty()))
+                    (light_only ? cond_light : cond).wait(lock);
                 if (!running)
                     break;
-                i = std::move(queue.front());
-                queue.pop_front();
+                auto& q = queue_light.empty() ? queue : queue_light;
+                i = std::move(q.front());
+                q.pop_front();
             }
             (*i)();
         }
@@ -125,18 +159,20 @@ public:
         LOCK(cs);
         running = false;
         cond.notify_all();
+        cond_light.notify_all();
     }
 };
 
 struct HTTPPathHandler
 {
-    HTTPPathHandler(std::string _prefix, bool _exactMatch, HTTPRequestHandler _handler):
-        prefix(_prefix), exactMatch(_exactMatch), handler(_handler)
+    HTTPPathHandler(std::string _prefix, bool _exactMatch, HTTPRequestHandler _handler, HTTPRequestClassifier _classifier):
+        prefix(_prefix), exactMatch(_exactMatch), handler(_handler), classifier(_classifier)
     {
     }
     std::string prefix;
     bool exactMatch;
     HTTPRequestHandler handler;
+    HTTPRequestClassifier classifier;
 };
 
 /** HTTP module state */
@@ -267,12 +303,13 @@ static void http_request_cb(struct evhttp_request* req, void* arg)
 
     // Dispatch to worker thread
     if (i != iend) {
+        const bool light = i->classifier && i->classifier(hreq.get(), path) == HTTPRequestCost::LIGHT;
         std::unique_ptr<HTTPWorkItem> item(new HTTPWorkItem(std::move(hreq), path, i->handler));
         assert(workQueue);
-        if (workQueue->Enqueue(item.get()))
+        if (workQueue->Enqueue(item.get(), light))
             item.release(); /* if true, queue took ownership */
         else {
-            LogPrintf("WARNING: request rejected because http work queue depth exceeded, it can be increased with the -rpcworkqueue= setting\n");
+            LogPrintf("WARNING: %srequest rejected because http work queue depth exceeded, it can be increased with the -rpcworkqueue= setting\n", light ? "light " : "");
             item->req->WriteReply(HTTP_SERVICE_UNAVAILABLE, "Work queue depth exceeded");
         }
     } else {
@@ -341,10 +378,10 @@ static bool HTTPBindAddresses(struct evhttp* http)
 }
 
 /** Simple wrapper to set thread name and run work queue */
-static void HTTPWorkQueueRun(WorkQueue<HTTPClosure>* queue, int worker_num)
+static void HTTPWorkQueueRun(WorkQueue<HTTPClosure>* queue, int worker_num, bool light_only)
 {
     util::ThreadRename(strprintf("httpworker.%i", worker_num));
-    queue->Run();
+    queue->Run(light_only);
 }
 
 /** libevent event log callback */
@@ -428,15 +465,69 @@ bool UpdateHTTPServerLogging(bool enable) {
 static std::thread g_thread_http;
 static std::vector<std::thread> g_thread_http_workers;
 
+/** State of a streamed reply, shared between the worker thread producing it
+ * and the event loop sending it.
+ */
+struct HTTPReplyStream
+{
+    Mutex cs;
+    std::condition_variable cond;
+    //! Events posted to the event loop and not yet handled
+    int pending GUARDED_BY(cs){0};
+    //! Length of the connection's output buffer, kept up to date by the event loop
+    size_t backlog GUARDED_BY(cs){0};
+    //! Set (on the event loop) when the connection is closed, after which the
+    //! request has been freed by libevent and must not be touched anymore
+    bool closed GUARDED_BY(cs){false};
+    //! Set on shutdown, after which the reply is no longer waited for
+    bool interrupted GUARDED_BY(cs){false};
+    //! Callback watching the connection's output buffer; only used on the event loop
+    evbuffer_cb_entry* drain_cb{nullptr};
+
+    HTTPReplyStream();
+    ~HTTPReplyStream();
+};
+
+/** Streamed replies in progress, so InterruptHTTPServer can wake up their writers */
+static Mutex g_reply_streams_mutex;
+static std::set<HTTPReplyStream*> g_reply_streams GUARDED_BY(g_reply_streams_mutex);
+static bool g_reply_streams_interrupted GUARDED_BY(g_reply_streams_mutex){false};
+
+HTTPReplyStream::HTTPReplyStream()
+{
+    LOCK(g_reply_streams_mutex);
+    g_reply_streams.insert(this);
+    WITH_LOCK(cs, interrupted = g_reply_streams_interrupted);
+}
+
+HTTPReplyStream::~HTTPReplyStream()
+{
+    LOCK(g_reply_streams_mutex);
+    g_reply_streams.erase(this);
+}
+
+static void InterruptReplyStreams()
+{
+    LOCK(g_reply_streams_mutex);
+    g_reply_streams_interrupted = true;
+    for (HTTPReplyStream* stream : g_reply_streams) {
+        LOCK(stream->cs);
+        stream->interrupted = true;
+        stream->cond.notify_all();
+    }
+}
+
 void StartHTTPServer()
 {
     LogPrint(BCLog::HTTP, "Starting HTTP server\n");
     int rpcThreads = std::max((long)gArgs.GetArg("-rpcthreads", DEFAULT_HTTP_THREADS), 1L);
-    LogPrintf("HTTP: starting %d worker threads\n", rpcThreads);
+    int lightThreads = std::max((long)gArgs.GetArg("-rpclightthreads", DEFAULT_HTTP_LIGHT_THREADS), 0L);
+    LogPrintf("HTTP: starting %d worker threads, and %d for light requests only\n", rpcThreads, lightThreads);
+    WITH_LOCK(g_reply_streams_mutex, g_reply_streams_interrupted = false);
     g_thread_http = std::thread(ThreadHTTP, eventBase);
 
-    for (int i = 0; i < rpcThreads; i++) {
-        g_thread_http_workers.emplace_back(HTTPWorkQueueRun, workQueue, i);
+    for (int i = 0; i < rpcThreads + lightThreads; i++) {
+        g_thread_http_workers.emplace_back(HTTPWorkQueueRun, workQueue, i, /* light_only */ i >= rpcThreads);
     }
 }
 
@@ -449,6 +540,7 @@ void InterruptHTTPServer()
     }
     if (workQueue)
         workQueue->Interrupt();
+    InterruptReplyStreams();
 }
 
 void StopHTTPServer()
@@ -489,6 +581,15 @@ struct event_base* EventBase()
     return eventBase;
 }
 
+bool HTTPRunTask(std::function<void()> task)
+{
+    if (!workQueue) return false;
+    std::unique_ptr<HTTPTaskItem> item(new HTTPTaskItem(std::move(task)));
+    if (!workQueue->Enqueue(item.get())) return false;
+    item.release(); /* queue took ownership */
+    return true;
+}
+
 static void httpevent_callback_fn(evutil_socket_t, short, void* data)
 {
     // Static handler: simply call inner handler
@@ -515,13 +616,15 @@ void HTTPEvent::trigger(struct timeval* tv)
     else
         evtimer_add(ev, tv); // trigger after timeval passed
 }
-HTTPRequest::HTTPRequest(struct evhttp_request* _req, bool _replySent) : req(_req), replySent(_replySent)
+HTTPRequest::HTTPRequest(struct evhttp_request* _req, bool _replySent) : req(_req), replySent(_replySent), replyStarted(false)
 {
 }
 
 HTTPRequest::~HTTPRequest()
 {
-    if (!replySent) {
+    if (replyStarted && !replySent) {
+        EndReply();
+    } else if (!replySent) {
         // Keep track of whether reply was sent to avoid request leaks
         LogPrintf("%s: Unhandled request\n", __func__);
         WriteReply(HTTP_INTERNAL_SERVER_ERROR, "Unhandled request");
@@ -540,6 +643,20 @@ std::pair<bool, std::string> HTTPRequest::GetHeader(const std::string& hdr) cons
         return std::make_pair(false, "");
 }
 
+std::optional<std::string> HTTPRequest::PeekBody(size_t max_size) const
+{
+    struct evbuffer* buf = evhttp_request_get_input_buffer(req);
+    if (!buf)
+        return std::string();
+    size_t size = evbuffer_get_length(buf);
+    if (size > max_size)
+        return std::nullopt;
+    std::string rv(size, '\0');
+    if (size && evbuffer_copyout(buf, &rv[0], size) != (ev_ssize_t)size)
+        return std::nullopt;
+    return rv;
+}
+
 std::string HTTPRequest::ReadBody()
 {
     struct evbuffer* buf = evhttp_request_get_input_buffer(req);
@@ -572,9 +689,25 @@ void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
  * Replies must be sent in the main loop in the main http thread,
  * this cannot be done from worker threads.
  */
+/** Re-enable reading from the socket. This is the second part of the libevent
+ * workaround in http_request_cb. Must be called from the event base thread.
+ */
+static void ReenableReading(struct evhttp_request* req)
+{
+    if (event_get_version_number() >= 0x02010600 && event_get_version_number() < 0x02020001) {
+        evhttp_connection* conn = evhttp_request_get_connection(req);
+        if (conn) {
+            bufferevent* bev = evhttp_connection_get_bufferevent(conn);
+            if (bev) {
+                bufferevent_enable(bev, EV_READ | EV_WRITE);
+            }
+        }
+    }
+}
+
 void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
 {
-    assert(!replySent && req);
+    assert(!replySent && !replyStarted && req);
     if (ShutdownRequested()) {
         WriteHeader("Connection", "close");
     }
@@ -585,16 +718,143 @@ void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
     auto req_copy = req;
     HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, nStatus]{
         evhttp_send_reply(req_copy, nStatus, nullptr, nullptr);
-        // Re-enable reading from the socket. This is the second part of the libevent
-        // workaround above.
-        if (event_get_version_number() >= 0x02010600 && event_get_version_number() < 0x02020001) {
+        ReenableReading(req_copy);
+    });
+    ev->trigger(nullptr);
+    replySent = true;
+    req = nullptr; // transferred back to main thread
+}
+
+/** Output buffer callback for streamed replies. Wakes up the writer when the
+ * client has read part of the reply. */
+static void http_reply_drain_cb(struct evbuffer* buffer, const struct evbuffer_cb_info* info, void* arg)
+{
+    if (info->n_deleted == 0) return;
+    auto stream = static_cast<HTTPReplyStream*>(arg);
+    LOCK(stream->cs);
+    stream->backlog = info->orig_size + info->n_added - info->n_deleted;
+    stream->cond.notify_all();
+}
+
+/** Stop watching the connection of a streamed reply. Runs on the event loop. */
+static void RemoveReplyStreamCallbacks(struct evhttp_connection* conn, HTTPReplyStream* stream)
+{
+    evhttp_connection_set_closecb(conn, nullptr, nullptr);
+    bufferevent* bev = evhttp_connection_get_bufferevent(conn);
+    if (bev && stream->drain_cb) evbuffer_remove_cb_entry(bufferevent_get_output(bev), stream->drain_cb);
+    stream->drain_cb = nullptr;
+}
+
+/** Connection close callback for streamed replies. */
+static void http_reply_close_cb(struct evhttp_connection* conn, void* arg)
+{
+    auto stream = static_cast<HTTPReplyStream*>(arg);
+    RemoveReplyStreamCallbacks(conn, stream);
+    LOCK(stream->cs);
+    stream->closed = true;
+    stream->cond.notify_all();
+}
+
+void HTTPRequest::PostStreamEvent(std::function<void()> fn)
+{
+    WITH_LOCK(m_stream->cs, ++m_stream->pending);
+    auto req_copy = req;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, stream = m_stream, fn = std::move(fn)]{
+        size_t backlog{0};
+        if (!WITH_LOCK(stream->cs, return stream->closed)) {
+            fn();
             evhttp_connection* conn = evhttp_request_get_connection(req_copy);
-            if (conn) {
-                bufferevent* bev = evhttp_connection_get_bufferevent(conn);
-                if (bev) {
-                    bufferevent_enable(bev, EV_READ | EV_WRITE);
-                }
-            }
+            bufferevent* bev = conn ? evhttp_connection_get_bufferevent(conn) : nullptr;
+            if (bev) backlog = evbuffer_get_length(bufferevent_get_output(bev));
+        }
+        LOCK(stream->cs);
+        --stream->pending;
+        stream->backlog = backlog;
+        stream->cond.notify_all();
+    });
+    ev->trigger(nullptr);
+}
+
+void HTTPRequest::WaitForReplyBacklog(size_t max_backlog)
+{
+    WAIT_LOCK(m_stream->cs, lock);
+    m_stream->cond.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_stream->cs) {
+        // Stop waiting on shutdown, as a client that stopped reading would
+        // otherwise keep this worker, and with it the shutdown, from finishing.
+        return m_stream->closed || m_stream->interrupted || (m_stream->pending == 0 && m_stream->backlog <= max_backlog);
+    });
+}
+
+void HTTPRequest::StartReply(int nStatus)
+{
+    assert(!replySent && !replyStarted && req);
+    if (ShutdownRequested()) {
+        WriteHeader("Connection", "close");
+    }
+    m_stream = std::make_shared<HTTPReplyStream>();
+    auto req_copy = req;
+    // The callbacks are removed again by EndReply or AbortReply, which keep
+    // the stream alive until then.
+    PostStreamEvent([req_copy, stream = m_stream.get(), nStatus]{
+        evhttp_connection* conn = evhttp_request_get_connection(req_copy);
+        if (conn) {
+            evhttp_connection_set_closecb(conn, http_reply_close_cb, stream);
+            bufferevent* bev = evhttp_connection_get_bufferevent(conn);
+            if (bev) stream->drain_cb = evbuffer_add_cb(bufferevent_get_output(bev), http_reply_drain_cb, stream);
+        }
+        evhttp_send_reply_start(req_copy, nStatus, nullptr);
+    });
+    replyStarted = true;
+}
+
+void HTTPRequest::WriteReplyChunk(std::string chunk)
+{
+    assert(!replySent && replyStarted && req);
+    if (chunk.empty()) return;
+    WaitForReplyBacklog(MAX_HTTP_REPLY_BACKLOG);
+    // Events triggered from this thread are handled in order, so the chunks
+    // are sent in the order they were written.
+    auto req_copy = req;
+    PostStreamEvent([req_copy, chunk = std::move(chunk)]{
+        struct evbuffer* evb = evbuffer_new();
+        assert(evb);
+        evbuffer_add(evb, chunk.data(), chunk.size());
+        evhttp_send_reply_chunk(req_copy, evb);
+        evbuffer_free(evb);
+    });
+}
+
+void HTTPRequest::EndReply()
+{
+    assert(!replySent && replyStarted && req);
+    auto req_copy = req;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, stream = m_stream]{
+        if (WITH_LOCK(stream->cs, return stream->closed)) return;
+        evhttp_connection* conn = evhttp_request_get_connection(req_copy);
+        if (conn) RemoveReplyStreamCallbacks(conn, stream.get());
+        evhttp_send_reply_end(req_copy);
+        ReenableReading(req_copy);
+    });
+    ev->trigger(nullptr);
+    replySent = true;
+    req = nullptr; // transferred back to main thread
+}
+
+void HTTPRequest::AbortReply()
+{
+    assert(!replySent && replyStarted && req);
+    // Let the client receive what was sent so far before closing
+    WaitForReplyBacklog(0);
+    auto req_copy = req;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, stream = m_stream]{
+        if (WITH_LOCK(stream->cs, return stream->closed)) return;
+        evhttp_connection* conn = evhttp_request_get_connection(req_copy);
+        if (conn) {
+            // Freeing the connection also frees the request
+            RemoveReplyStreamCallbacks(conn, stream.get());
+            evhttp_connection_free(conn);
+        } else {
+            evhttp_send_reply_end(req_copy);
         }
     });
     ev->trigger(nullptr);
@@ -602,6 +862,37 @@ void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
     req = nullptr; // transferred back to main thread
 }
 
+bool HTTPRequest::WriteJSONReply(const std::function<void(JSONWriter&)>& write_json)
+{
+    bool streaming{false};
+    JSONWriter writer{HTTP_REPLY_CHUNK_SIZE, [&](std::string& chunk) {
+        if (!streaming) {
+            WriteHeader("Content-Type", "application/json");
+            StartReply(HTTP_OK);
+            streaming = true;
+        }
+        WriteReplyChunk(std::move(chunk));
+        chunk.clear();
+    }};
+    try {
+        write_json(writer);
+    } catch (...) {
+        if (!streaming) throw;
+        LogPrintf("HTTP: reply to %s aborted, error while writing it\n", GetURI());
+        AbortReply();
+        return false;
+    }
+    std::string reply{writer.Release()};
+    if (streaming) {
+        WriteReplyChunk(std::move(reply));
+        EndReply();
+    } else {
+        WriteHeader("Content-Type", "application/json");
+        WriteReply(HTTP_OK, reply);
+    }
+    return true;
+}
+
 CService HTTPRequest::GetPeer() const
 {
     evhttp_connection* con = evhttp_request_get_connection(req);
@@ -642,10 +933,10 @@ HTTPRequest::RequestMethod HTTPRequest::GetRequestMethod() const
     }
 }
 
-void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler)
+void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler, const HTTPRequestClassifier &classifier)
 {
     LogPrint(BCLog::HTTP, "Registering HTTP handler for %s (exactmatch %d)\n", prefix, exactMatch);
-    pathHandlers.push_back(HTTPPathHandler(prefix, exactMatch, handler));
+    pathHandlers.push_back(HTTPPathHandler(prefix, exactMatch, handler, classifier));
 }
 
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch)
@@ -17,17 +17,27 @@
 #ifndef BITCOIN_HTTPSERVER_H
 #define BITCOIN_HTTPSERVER_H
 
+#include <memory>
+#include <optional>
 #include <string>
 #include <functional>
 
 static const int DEFAULT_HTTP_THREADS=4;
 static const int DEFAULT_HTTP_WORKQUEUE=16;
+static const int DEFAULT_HTTP_LIGHT_THREADS=1;
 static const int DEFAULT_HTTP_SERVER_TIMEOUT=30;
+/** Size of the chunks a streamed reply is sent in */
+static const size_t HTTP_REPLY_CHUNK_SIZE = 1 << 20;
+/** Maximum amount of reply data buffered for a streamed reply before
+ * WriteReplyChunk waits for the client to read it */
+static const size_t MAX_HTTP_REPLY_BACKLOG = 4 << 20;
 
 struct evhttp_request;
 struct event_base;
 class CService;
 class HTTPRequest;
+class JSONWriter;
+struct HTTPReplyStream;
 
 /** Initialize HTTP server.
  * Call this before RegisterHTTPHandler or EventBase().
@@ -49,14 +59,36 @@ bool UpdateHTTPServerLogging(bool enable);
 
 /** Handler for requests to a certain HTTP path */
 typedef std::function<bool(HTTPRequest* req, const std::string &)> HTTPRequestHandler;
+
+/** Cost class of a request, which decides the work queue it is served from.
+ * Light requests have their own queue, are served ahead of normal requests,
+ * and additionally by worker threads (-rpclightthreads) that serve nothing
+ * else.
+ */
+enum class HTTPRequestCost {
+    NORMAL,
+    LIGHT,
+};
+/** Classify a request before it is dispatched. Called on the HTTP event loop
+ * thread, so this must be cheap and must not consume the request body.
+ */
+typedef std::function<HTTPRequestCost(const HTTPRequest* req, const std::string &)> HTTPRequestClassifier;
+
 /** Register handler for prefix.
  * If multiple handlers match a prefix, the first-registered one will
- * be invoked.
+ * be invoked. Requests are dispatched as HTTPRequestCost::NORMAL unless a
+ * classifier is given.
  */
-void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler);
+void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler, const HTTPRequestClassifier &classifier = nullptr);
 /** Unregister handler for prefix */
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
 
+/** Run a task on one of the HTTP worker threads.
+ * Returns false, and drops the task, if the work queue is full or the HTTP
+ * server is not running.
+ */
+bool HTTPRunTask(std::function<void()> task);
+
 /** Return evhttp event base. This can be used by submodules to
  * queue timers or custom events.
  */
@@ -70,6 +102,16 @@ class HTTPRequest
 private:
     struct evhttp_request* req;
     bool replySent;
+    bool replyStarted;
+    //! State of a reply started with StartReply, shared with the event loop
+    std::shared_ptr<HTTPReplyStream> m_stream;
+
+    /** Post a closure that must run on the event loop before the next wait
+     * in WaitForReplyBacklog returns. */
+    void PostStreamEvent(std::function<void()> fn);
+    /** Block until the reply data buffered for the connection has dropped to
+     * max_backlog, or the connection is gone. */
+    void WaitForReplyBacklog(size_t max_backlog);
 
 public:
     explicit HTTPRequest(struct evhttp_request* req, bool replySent = false);
@@ -109,6 +151,12 @@ public:
      */
     std::string ReadBody();
 
+    /**
+     * Return a copy of the request body without consuming it, or nullopt if
+     * the body is larger than max_size.
+     */
+    std::optional<std::string> PeekBody(size_t max_size) const;
+
     /**
      * Write output header.
      *
@@ -125,6 +173,51 @@ public:
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
     void WriteReply(int nStatus, const std::string& strReply = "");
+
+    /**
+     * Start a streamed HTTP reply, as an alternative to WriteReply for replies
+     * that are produced incrementally. Headers must be written before calling
+     * this. The body is sent with WriteReplyChunk (using chunked transfer
+     * encoding for HTTP/1.1 clients) and the reply is finished with EndReply.
+     */
+    void StartReply(int nStatus);
+
+    /**
+     * Send a part of the body of a reply started with StartReply. Blocks
+     * while more than MAX_HTTP_REPLY_BACKLOG bytes of the reply are waiting
+     * to be written to a slow client, so a streamed reply is only buffered up
+     * to that amount.
+     */
+    void WriteReplyChunk(std::string chunk);
+
+    /**
+     * Finish a reply started with StartReply.
+     *
+     * @note As this will give the request back to the main thread, do not
+     * call any other HTTPRequest methods after calling this.
+     */
+    void EndReply();
+
+    /**
+     * Abort a reply started with StartReply by closing the connection without
+     * finishing the reply, so the client can tell that it is incomplete.
+     *
+     * @note As with EndReply, do not call any other HTTPRequest methods after
+     * calling this.
+     */
+    void AbortReply();
+
+    /**
+     * Send the JSON written by write_json as a successful reply. Small
+     * replies are sent in one piece. Larger ones are streamed in chunks of
+     * HTTP_REPLY_CHUNK_SIZE while they are written, so the reply is never held
+     * in memory as a whole.
+     *
+     * If write_json throws before anything was sent, the exception is passed
+     * on and another reply can be sent instead. If it throws later, the reply
+     * is aborted and false is returned.
+     */
+    bool WriteJSONReply(const std::function<void(JSONWriter&)>& write_json);
 };
 
 /** Event handler closure.
@@ -0,0 +1,53 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_BLOCKSTATSINDEX_H
+#define BITCOIN_INDEX_BLOCKSTATSINDEX_H
+
+#include <chain.h>
+#include <index/base.h>
+#include <node/blockstats.h>
+
+/**
+ * BlockStatsIndex stores the getblockstats statistics of every block, so they
+ * do not need to be recomputed from the block and its undo data on each call.
+ */
+class BlockStatsIndex final : public BaseIndex
+{
+private:
+    std::unique_ptr<BaseIndex::DB> m_db;
+
+protected:
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip) override;
+
+    BaseIndex::DB& GetDB() const override { return *m_db; }
+
+    const char* GetName() const override { return "blockstatsindex"; }
+
+public:
+    // Constructs the index, which becomes available to be queried.
+    explicit BlockStatsIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Look up stats for a specific block using CBlockIndex
+    bool LookUpStats(const CBlockIndex* block_index, BlockStats& stats) const;
+};
+
+/// The global block statistics index. May be null.
+extern std::unique_ptr<BlockStatsIndex> g_block_stats_index;
+
+#endif // BITCOIN_INDEX_BLOCKSTATSINDEX_H
@@ -20,7 +20,9 @@
 
 #include <clientversion.h>
 #include <compat/sanity.h>
+#include <crypto/chacha20.h>
 #include <crypto/sha256.h>
+#include <crypto/siphash.h>
 #include <key.h>
 #include <logging.h>
 #include <node/ui_interface.h>
@@ -39,6 +41,10 @@ void SetGlobals()
 {
     std::string sha256_algo = SHA256AutoDetect();
     LogPrintf("Using the '%s' SHA256 implementation\n", sha256_algo);
+    std::string chacha20_algo = ChaCha20AutoDetect();
+    LogPrintf("Using the '%s' ChaCha20 implementation\n", chacha20_algo);
+    std::string siphash_algo = SipHashAutoDetect();
+    LogPrintf("Using the '%s' SipHash implementation\n", siphash_algo);
     RandomInit();
     ECC_Start();
     globalVerifyHandle.reset(new ECCVerifyHandle());
@@ -43,6 +43,7 @@
 #include <string.h>
 #else
 #include <fcntl.h>
+#include <sys/uio.h>
 #endif
 
 #if HAVE_DECL_GETIFADDRS && HAVE_DECL_FREEIFADDRS
@@ -54,6 +55,7 @@
 #endif
 
 #include <algorithm>
+#include <array>
 #include <cstdint>
 #include <functional>
 #include <optional>
@@ -108,6 +110,9 @@ enum BindFlags {
 // The sleep time needs to be small to avoid new sockets stalling
 static const uint64_t SELECT_TIMEOUT_MILLISECONDS = 50;
 
+/** Maximum number of queued send buffers passed to a single sendmsg call */
+static constexpr size_t MAX_SEND_IOVECS = 64;
+
 const std::string NET_MESSAGE_COMMAND_OTHER = "*other*";
 
 static const uint64_t RANDOMIZER_ID_NETGROUP = 0x6c0edd8036ef4036ULL; // SHA256("netgroup")[0:8]
@@ -677,6 +682,62 @@ bool CNode::ReceiveMsgBytes(Span<const uint8_t> msg_bytes, bool& complete)
     return true;
 }
 
+namespace {
+size_t ClassSize(size_t index) { return RecvBufferPool::MIN_CLASS_SIZE << (2 * index); }
+} // namespace
+
+CDataStream RecvBufferPool::Acquire(size_t size, int type, int version)
+{
+    for (size_t index = 0; index < NUM_CLASSES; ++index) {
+        if (size > ClassSize(index)) continue;
+        {
+            LOCK(m_mutex);
+            auto& buffers = m_buffers[index];
+            if (!buffers.empty()) {
+                CDataStream stream{std::move(buffers.back())};
+                buffers.pop_back();
+                stream.SetType(type);
+                stream.SetVersion(version);
+                return stream;
+            }
+        }
+        CDataStream stream{type, version};
+        stream.reserve(ClassSize(index));
+        return stream;
+    }
+    return CDataStream{type, version};
+}
+
+void RecvBufferPool::Release(CDataStream&& stream)
+{
+    const size_t capacity{stream.capacity()};
+    // Buffers that grew for a large message are not worth keeping around
+    if (capacity < MIN_CLASS_SIZE || capacity >= 2 * MAX_CLASS_SIZE) return;
+    size_t index = NUM_CLASSES - 1;
+    while (ClassSize(index) > capacity) --index;
+    const size_t max_buffers{std::min(MAX_BUFFERS_PER_CLASS, std::max<size_t>(1, MAX_BYTES_PER_CLASS / ClassSize(index)))};
+
+    LOCK(m_mutex);
+    auto& buffers = m_buffers[index];
+    if (buffers.size() >= max_buffers) return;
+    stream.clear();
+    buffers.push_back(std::move(stream));
+}
+
+size_t RecvBufferPool::Size() const
+{
+    LOCK(m_mutex);
+    size_t size = 0;
+    for (const auto& buffers : m_buffers) size += buffers.size();
+    return size;
+}
+
+RecvBufferPool& RecvBufferPool::Get()
+{
+    static RecvBufferPool pool;
+    return pool;
+}
+
 int V1TransportDeserializer::readHeader(Span<const uint8_t> msg_bytes)
 {
     // copy data to temporary parsing buffer
@@ -711,6 +772,14 @@ int V1TransportDeserializer::readHeader(Span<const uint8_t> msg_bytes)
         return -1;
     }
 
+    // Take a buffer for the payload from the pool, unless the current one is large enough
+    if (vRecv.capacity() < hdr.nMessageSize) {
+        const int type = vRecv.GetType();
+        const int version = vRecv.GetVersion();
+        RecvBufferPool::Get().Release(std::move(vRecv));
+        vRecv = RecvBufferPool::Get().Acquire(hdr.nMessageSize, type, version);
+    }
+
     // switch state to reading message data
     in_data = true;
 
@@ -780,11 +849,12 @@ std::optional<CNetMessage> V1TransportDeserializer::GetMessage(const std::chrono
 }
 
 void V1TransportSerializer::prepareForTransport(CSerializedNetMsg& msg, std::vector<unsigned char>& header) {
-    // create dbl-sha256 checksum
-    uint256 hash = Hash(msg.data);
+    const Span<const unsigned char> payload{msg.Payload()};
+    // create dbl-sha256 checksum, unless it was computed when the payload was shared
+    uint256 hash = msg.m_shared_payload ? msg.m_shared_payload->hash : Hash(payload);
 
     // create header
-    CMessageHeader hdr(Params().MessageStart(), msg.m_type.c_str(), msg.data.size());
+    CMessageHeader hdr(Params().MessageStart(), msg.m_type.c_str(), payload.size());
     memcpy(hdr.pchChecksum, hash.begin(), CMessageHeader::CHECKSUM_SIZE);
 
     // serialize header
@@ -798,26 +868,51 @@ size_t CConnman::SocketSendData(CNode& node) const
     size_t nSentSize = 0;
 
     while (it != node.vSendMsg.end()) {
-        const auto& data = *it;
-        assert(data.size() > node.nSendOffset);
+        assert((*it)->size() > node.nSendOffset);
         int nBytes = 0;
         {
             LOCK(node.cs_hSocket);
             if (node.hSocket == INVALID_SOCKET)
                 break;
+#ifdef WIN32
+            const auto& data = **it;
             nBytes = send(node.hSocket, reinterpret_cast<const char*>(data.data()) + node.nSendOffset, data.size() - node.nSendOffset, MSG_NOSIGNAL | MSG_DONTWAIT);
+#else
+            // Gather as many queued buffers as possible into a single call
+            std::array<iovec, MAX_SEND_IOVECS> iov;
+            size_t iov_count = 0;
+            size_t offset = node.nSendOffset;
+            for (auto buf = it; buf != node.vSendMsg.end() && iov_count < iov.size(); ++buf) {
+                iov[iov_count].iov_base = const_cast<unsigned char*>((*buf)->data()) + offset;
+                iov[iov_count].iov_len = (*buf)->size() - offset;
+                ++iov_count;
+                offset = 0;
+            }
+            msghdr header{};
+            header.msg_iov = iov.data();
+            header.msg_iovlen = iov_count;
+            nBytes = sendmsg(node.hSocket, &header, MSG_NOSIGNAL | MSG_DONTWAIT);
+#endif
         }
         if (nBytes > 0) {
             node.nLastSend = GetTimeSeconds();
             node.nSendBytes += nBytes;
-            node.nSendOffset += nBytes;
             nSentSize += nBytes;
-            if (node.nSendOffset == data.size()) {
+            // Skip the buffers that were sent completely
+            size_t remaining = nBytes;
+            while (remaining > 0) {
+                const size_t left = (*it)->size() - node.nSendOffset;
+                if (remaining < left) {
+                    node.nSendOffset += remaining;
+                    break;
+                }
+                remaining -= left;
                 node.nSendOffset = 0;
-                node.nSendSize -= data.size();
-                node.fPauseSend = node.nSendSize > nSendBufferMaxSize;
+                node.nSendSize -= (*it)->size();
                 it++;
-            } else {
+            }
+            node.fPauseSend = node.nSendSize > nSendBufferMaxSize;
+            if (node.nSendOffset != 0) {
                 // could not send full message; stop sending more
                 break;
             }
@@ -2973,20 +3068,22 @@ bool CConnman::NodeFullyConnected(const CNode* pnode)
 
 void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg)
 {
-    size_t nMessageSize = msg.data.size();
+    size_t nMessageSize = msg.Payload().size();
     LogPrint(BCLog::NET, "sending %s (%d bytes) peer=%d\n",  SanitizeString(msg.m_type), nMessageSize, pnode->GetId());
     if (gArgs.GetBoolArg("-capturemessages", false)) {
-        CaptureMessage(pnode->addr, msg.m_type, msg.data, /* incoming */ false);
+        CaptureMessage(pnode->addr, msg.m_type, msg.Payload(), /* incoming */ false);
     }
 
-    // make sure we use the appropriate network transport format
-    std::vector<unsigned char> serializedHeader;
-    pnode->m_serializer->prepareForTransport(msg, serializedHeader);
-    size_t nTotalSize = nMessageSize + serializedHeader.size();
-
     size_t nBytesSent = 0;
     {
         LOCK(pnode->cs_vSend);
+        // make sure we use the appropriate network transport format. This is
+        // done under cs_vSend, so a stateful serializer sees the messages in
+        // the order they are queued.
+        std::vector<unsigned char> serializedHeader;
+        pnode->m_serializer->prepareForTransport(msg, serializedHeader);
+        size_t nTotalSize = nMessageSize + serializedHeader.size();
+
         bool optimisticSend(pnode->vSendMsg.empty());
 
         //log total amount of bytes per message type
@@ -2994,8 +3091,15 @@ void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg)
         pnode->nSendSize += nTotalSize;
 
         if (pnode->nSendSize > nSendBufferMaxSize) pnode->fPauseSend = true;
-        pnode->vSendMsg.push_back(std::move(serializedHeader));
-        if (nMessageSize) pnode->vSendMsg.push_back(std::move(msg.data));
+        pnode->vSendMsg.push_back(std::make_shared<const std::vector<unsigned char>>(std::move(serializedHeader)));
+        if (nMessageSize) {
+            if (msg.m_shared_payload) {
+                // Refer to the shared payload instead of copying it
+                pnode->vSendMsg.push_back(SendBuffer{msg.m_shared_payload, &msg.m_shared_payload->data});
+            } else {
+                pnode->vSendMsg.push_back(std::make_shared<const std::vector<unsigned char>>(std::move(msg.data)));
+            }
+        }
 
         // If write queue empty, attempt "optimistic write"
         if (optimisticSend) nBytesSent = SocketSendData(*pnode);
@@ -40,6 +40,7 @@
 #include <uint256.h>
 #include <util/check.h>
 
+#include <array>
 #include <atomic>
 #include <condition_variable>
 #include <cstdint>
@@ -110,6 +111,20 @@ struct AddedNodeInfo
 class CNodeStats;
 class CClientUIInterface;
 
+/** Serialized data queued for sending. Buffers are immutable and shared, so
+ *  the same payload can be queued to several peers without copying it. */
+using SendBuffer = std::shared_ptr<const std::vector<unsigned char>>;
+
+/** A message payload serialized once to be sent to several peers, together
+ *  with its hash so that the header checksum is not recomputed per peer. */
+struct SharedPayload
+{
+    explicit SharedPayload(std::vector<unsigned char>&& data_in) : data(std::move(data_in)), hash(Hash(data)) {}
+
+    const std::vector<unsigned char> data;
+    const uint256 hash;
+};
+
 struct CSerializedNetMsg
 {
     CSerializedNetMsg() = default;
@@ -121,6 +136,14 @@ struct CSerializedNetMsg
 
     std::vector<unsigned char> data;
     std::string m_type;
+    /** Payload shared with other messages, used instead of data when set */
+    std::shared_ptr<const SharedPayload> m_shared_payload;
+
+    /** The payload of the message, wherever it is stored */
+    Span<const unsigned char> Payload() const
+    {
+        return m_shared_payload ? MakeSpan(m_shared_payload->data) : MakeSpan(data);
+    }
 };
 
 /** Different types of connections to a peer. This enum encapsulates the
@@ -288,6 +311,40 @@ public:
 };
 
 
+/** Pool of receive buffers, reused across messages so that receiving a
+ * message does not need a fresh allocation. Buffers are kept in size classes,
+ * each holding a bounded number of buffers. Messages larger than the largest
+ * class are not pooled.
+ */
+class RecvBufferPool
+{
+public:
+    //! Capacity of the smallest size class; each class is four times the previous one
+    static constexpr size_t MIN_CLASS_SIZE{256};
+    static constexpr size_t NUM_CLASSES{6};
+    static constexpr size_t MAX_CLASS_SIZE{MIN_CLASS_SIZE << (2 * (NUM_CLASSES - 1))};
+    //! Memory kept in buffers of a single size class
+    static constexpr size_t MAX_BYTES_PER_CLASS{1 << 20};
+    static constexpr size_t MAX_BUFFERS_PER_CLASS{256};
+
+    /** Return an empty stream with room for at least size bytes, reusing a
+     *  pooled buffer if there is one */
+    CDataStream Acquire(size_t size, int type, int version) LOCKS_EXCLUDED(m_mutex);
+
+    /** Return the buffer of a stream that is no longer needed to the pool */
+    void Release(CDataStream&& stream) LOCKS_EXCLUDED(m_mutex);
+
+    /** Number of buffers in the pool */
+    size_t Size() const LOCKS_EXCLUDED(m_mutex);
+
+    /** The pool shared by all connections */
+    static RecvBufferPool& Get();
+
+private:
+    mutable Mutex m_mutex;
+    std::array<std::vector<CDataStream>, NUM_CLASSES> m_buffers GUARDED_BY(m_mutex);
+};
+
 /** Transport protocol agnostic message container.
  * Ideally it should only contain receive time, payload,
  * command and size.
@@ -301,6 +358,9 @@ public:
     std::string m_command;
 
     CNetMessage(CDataStream&& recv_in) : m_recv(std::move(recv_in)) {}
+    CNetMessage(CNetMessage&&) = default;
+    CNetMessage& operator=(CNetMessage&&) = default;
+    ~CNetMessage() { RecvBufferPool::Get().Release(std::move(m_recv)); }
 
     void SetVersion(int nVersionIn)
     {
@@ -420,7 +480,7 @@ public:
     /** Offset inside the first vSendMsg already sent */
     size_t nSendOffset GUARDED_BY(cs_vSend){0};
     uint64_t nSendBytes GUARDED_BY(cs_vSend){0};
-    std::deque<std::vector<unsigned char>> vSendMsg GUARDED_BY(cs_vSend);
+    std::deque<SendBuffer> vSendMsg GUARDED_BY(cs_vSend);
     Mutex cs_vSend;
     Mutex cs_hSocket;
     Mutex cs_vRecv;
@@ -21,6 +21,7 @@
 #include <banman.h>
 #include <blockencodings.h>
 #include <blockfilter.h>
+#include <blockservecache.h>
 #include <chainparams.h>
 #include <consensus/validation.h>
 #include <hash.h>
@@ -30,6 +31,7 @@
 #include <netmessagemaker.h>
 #include <node/blockstorage.h>
 #include <policy/fees.h>
+#include <policy/packages.h>
 #include <policy/policy.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
@@ -94,6 +96,8 @@ static constexpr int32_t MAX_PEER_TX_REQUEST_IN_FLIGHT = 100;
  *  rate (by our own policy, see INVENTORY_BROADCAST_PER_SECOND) for several minutes, while not receiving
  *  the actual transaction (from any peer) in response to requests for them. */
 static constexpr int32_t MAX_PEER_TX_ANNOUNCEMENTS = 5000;
+/** Maximum number of orphan transactions resolved per call of ProcessOrphanTx. */
+static constexpr unsigned int MAX_ORPHAN_RESOLUTION_BATCH{10};
 /** How long to delay requesting transactions via txids, if we have wtxid-relaying peers */
 static constexpr auto TXID_RELAY_DELAY = std::chrono::seconds{2};
 /** How long to delay requesting transactions from non-preferred peers */
@@ -102,6 +106,11 @@ static constexpr auto NONPREF_PEER_TX_DELAY = std::chrono::seconds{2};
 static constexpr auto OVERLOADED_PEER_TX_DELAY = std::chrono::seconds{2};
 /** How long to wait (in microseconds) before downloading a transaction from an additional peer */
 static constexpr std::chrono::microseconds GETDATA_TX_INTERVAL{std::chrono::seconds{60}};
+/** Maximum number of getpkgtxns requests pending per peer. Beyond it, the missing parents of an orphan
+ *  announced by the peer are requested one by one. */
+static constexpr size_t MAX_PEER_PKGTXNS_IN_FLIGHT{25};
+/** How long to wait for the reply to a getpkgtxns request before requesting the parents one by one */
+static constexpr auto GETPKGTXNS_TIMEOUT{std::chrono::seconds{60}};
 /** Limit to avoid sending big packets. Not used in processing incoming GETDATA for compatibility */
 static const unsigned int MAX_GETDATA_SZ = 1000;
 /** Number of blocks that can be requested at any given time from a single peer. */
@@ -116,6 +125,9 @@ static const unsigned int MAX_HEADERS_RESULTS = 2000;
 static const int MAX_CMPCTBLOCK_DEPTH = 5;
 /** Maximum depth of blocks we're willing to respond to GETBLOCKTXN requests for. */
 static const int MAX_BLOCKTXN_DEPTH = 10;
+/** Maximum depth of blocks whose serialization is kept in the block serve cache.
+ *  Older blocks are requested by syncing peers, which would only churn the cache. */
+static const int MAX_BLOCK_SERVE_CACHE_DEPTH = 10;
 /** Size of the "block download window": how far ahead of our current height do we fetch?
  *  Larger windows tolerate larger download speed differences between peer, but increase the potential
  *  degree of disordering of blocks on disk (which make reindexing and pruning harder). We'll probably
@@ -342,6 +354,25 @@ private:
     bool MaybeDiscourageAndDisconnect(CNode& pnode, Peer& peer);
 
     void ProcessOrphanTx(std::set<uint256>& orphan_work_set) EXCLUSIVE_LOCKS_REQUIRED(cs_main, g_cs_orphans);
+    /** Try to accept a transaction that was rejected for its feerate alone as the parent of
+     *  a package with one of its orphaned children, preferably one announced by peer. Returns
+     *  true if the package was accepted; the child is dropped if it failed for another reason. */
+    bool ProcessOrphanPackage(const CTransactionRef& parent, NodeId peer, std::set<uint256>& orphan_work_set) EXCLUSIVE_LOCKS_REQUIRED(cs_main, g_cs_orphans);
+    /** Add the transactions that failed in a package that was not accepted to the reject filter.
+     *  Returns false if the package may still be accepted later, i.e. if it failed only on feerate
+     *  or the child is missing other inputs. */
+    bool ProcessInvalidPackage(const PackageMempoolAcceptResult& package_result, const CTransactionRef& child) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    /** Relay the transactions of a package accepted to the mempool, and reconsider their orphaned children. */
+    void ProcessValidPackage(const Package& package, std::set<uint256>& orphan_work_set) EXCLUSIVE_LOCKS_REQUIRED(cs_main, g_cs_orphans);
+    /** Validate a package received in a pkgtxns message. */
+    void ProcessPackage(CNode& node, Peer& peer, const Package& package) EXCLUSIVE_LOCKS_REQUIRED(cs_main, g_cs_orphans);
+    /** Send a transaction together with its unconfirmed parents in reply to a getpkgtxns message, or
+     *  notfound if we don't serve that package. */
+    void SendPackage(CNode& node, const uint256& wtxid) LOCKS_EXCLUDED(cs_main);
+    /** Request the parents of an orphan one by one, after the getpkgtxns request for its package
+     *  failed or timed out. */
+    void RequestPackageParents(const CNode& node, const uint256& wtxid, const std::vector<uint256>& parent_txids,
+                               std::chrono::microseconds current_time) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     /** Process a single headers message from a peer. */
     void ProcessHeadersMessage(CNode& pfrom, const Peer& peer,
                                const std::vector<CBlockHeader>& headers,
@@ -396,6 +427,9 @@ private:
     /** Whether this node is running in blocks only mode */
     const bool m_ignore_incoming_txs;
 
+    /** Whether we offer package relay to our peers (-packagerelay) */
+    const bool m_package_relay;
+
     /** Whether we've completed initial sync yet, for determining when to turn
       * on extra block-relay-only peers. */
     bool m_initial_sync_finished{false};
@@ -428,7 +462,9 @@ private:
     /** Number of outbound peers with m_chain_sync.m_protect. */
     int m_outbound_peers_with_protect_from_disconnect GUARDED_BY(cs_main) = 0;
 
-    bool AlreadyHaveTx(const GenTxid& gtxid) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    /** Whether we have or recently rejected this transaction. Transactions rejected
+     *  only for their feerate are included if include_reconsiderable is set. */
+    bool AlreadyHaveTx(const GenTxid& gtxid, bool include_reconsiderable) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
     /**
      * Filter for transactions that were recently rejected by
@@ -467,6 +503,17 @@ private:
     std::unique_ptr<CRollingBloomFilter> recentRejects GUARDED_BY(cs_main);
     uint256 hashRecentRejectsChainTip GUARDED_BY(cs_main);
 
+    /**
+     * Filter for the wtxids of transactions that were recently rejected by
+     * AcceptToMemoryPool only for their feerate (TX_RECONSIDERABLE). They are
+     * not announced-and-downloaded again, but may still be fetched as the
+     * missing parent of an orphan, and are then only validated as a package
+     * with that orphan. Reset together with recentRejects.
+     *
+     * Memory used: 1.3 MB
+     */
+    std::unique_ptr<CRollingBloomFilter> m_recent_rejects_reconsiderable GUARDED_BY(cs_main);
+
     /*
      * Filter for transactions that have been recently confirmed.
      * We use this to avoid requesting transactions that have already been
@@ -523,12 +570,36 @@ private:
     /** Stack of nodes which we have set to announce using compact blocks */
     std::list<NodeId> lNodesAnnouncingHeaderAndIDs GUARDED_BY(cs_main);
 
+    /**
+     * Announce a block which we reconstructed from a compact block, and which
+     * passed CheckBlock, to our high-bandwidth compact block peers before it
+     * is connected. Only done for blocks which extend our tip and were sent
+     * by a peer which negotiated our compact block version; BIP152 peers of
+     * version INVALID_CB_NO_BAN_VERSION or later do not punish us if the block
+     * turns out to be invalid.
+     */
+    void RelayCompactBlockEarly(const CBlockIndex* pindex, const std::shared_ptr<const CBlock>& pblock, NodeId from) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+    /** The last block relayed by RelayCompactBlockEarly, used to answer
+     *  getblocktxn requests for it before it is connected */
+    std::shared_ptr<const CBlock> m_early_relayed_block GUARDED_BY(cs_main);
+
+    /** Peers which m_early_relayed_block was announced to */
+    std::vector<NodeId> m_early_relay_peers GUARDED_BY(cs_main);
+
     /** Number of peers from which we're downloading blocks. */
     int nPeersWithValidatedDownloads GUARDED_BY(cs_main) = 0;
 
     /** Storage for orphan information */
     TxOrphanage m_orphanage;
 
+    /** The last single-header HEADERS announcement, serialized once and shared
+     *  by all peers the same header is announced to */
+    std::pair<uint256, std::shared_ptr<const SharedPayload>> m_last_header_announcement GUARDED_BY(cs_main);
+
+    /** Serialized recent blocks served to peers, limited by -blockservecachesize */
+    BlockServeCache m_block_serve_cache{size_t(std::max<int64_t>(0, gArgs.GetArg("-blockservecachesize", DEFAULT_BLOCK_SERVE_CACHE_SIZE))) << 20};
+
     void AddToCompactExtraTransactions(const CTransactionRef& tx) EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans);
 
     /** Orphan/conflicted/etc transactions that are kept for compact block reconstruction.
@@ -552,7 +623,7 @@ private:
      */
     bool BlockRequestAllowed(const CBlockIndex* pindex) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     bool AlreadyHaveBlock(const uint256& block_hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
-    void ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv& inv);
+    void ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv& inv) LOCKS_EXCLUDED(cs_main);
 
     /**
      * Validation logic for compact filters request handling.
@@ -711,6 +782,20 @@ struct CNodeState {
     //! Whether this peer relays txs via wtxid
     bool m_wtxid_relay{false};
 
+    //! Whether this peer relays txs together with their unconfirmed parents
+    bool m_package_relay{false};
+
+    //! A getpkgtxns request for the package of an orphan
+    struct PkgTxnsRequest {
+        //! When to give up waiting and request the parents one by one
+        std::chrono::microseconds m_expiry;
+        //! The orphan's missing parents
+        std::vector<uint256> m_parent_txids;
+    };
+
+    //! Packages requested from this peer with getpkgtxns, by the wtxid of the orphan
+    std::map<uint256, PkgTxnsRequest> m_pkgtxns_requested;
+
     CNodeState(bool is_inbound) : m_is_inbound(is_inbound) {}
 };
 
@@ -1326,6 +1411,7 @@ bool PeerManagerImpl::MaybePunishNodeForTx(NodeId nodeid, const TxValidationStat
     case TxValidationResult::TX_WITNESS_STRIPPED:
     case TxValidationResult::TX_CONFLICT:
     case TxValidationResult::TX_MEMPOOL_POLICY:
+    case TxValidationResult::TX_RECONSIDERABLE:
         break;
     }
     if (message != "") {
@@ -1360,11 +1446,13 @@ PeerManagerImpl::PeerManagerImpl(const CChainParams& chainparams, CConnman& conn
       m_chainman(chainman),
       m_mempool(pool),
       m_stale_tip_check_time(0),
-      m_ignore_incoming_txs(ignore_incoming_txs)
+      m_ignore_incoming_txs(ignore_incoming_txs),
+      m_package_relay(gArgs.GetBoolArg("-packagerelay", DEFAULT_PACKAGE_RELAY))
 {
     assert(std::addressof(g_chainman) == std::addressof(m_chainman));
     // Initialize global variables that cannot be constructed at startup.
     recentRejects.reset(new CRollingBloomFilter(120000, 0.000001));
+    m_recent_rejects_reconsiderable.reset(new CRollingBloomFilter(120000, 0.000001));
 
     // Blocks don't typically have more than 4000 transactions, so this should
     // be at least six blocks (~1 hr) worth of transactions that we can store,
@@ -1435,6 +1523,8 @@ void PeerManagerImpl::BlockDisconnected(const std::shared_ptr<const CBlock> &blo
 static RecursiveMutex cs_most_recent_block;
 static std::shared_ptr<const CBlock> most_recent_block GUARDED_BY(cs_most_recent_block);
 static std::shared_ptr<const CBlockHeaderAndShortTxIDs> most_recent_compact_block GUARDED_BY(cs_most_recent_block);
+/** most_recent_compact_block serialized with witnesses, shared by all peers it is sent to */
+static std::shared_ptr<const SharedPayload> most_recent_compact_block_payload GUARDED_BY(cs_most_recent_block);
 static uint256 most_recent_block_hash GUARDED_BY(cs_most_recent_block);
 static bool fWitnessesPresentInMostRecentCompactBlock GUARDED_BY(cs_most_recent_block);
 
@@ -1446,6 +1536,8 @@ void PeerManagerImpl::NewPoWValidBlock(const CBlockIndex *pindex, const std::sha
 {
     std::shared_ptr<const CBlockHeaderAndShortTxIDs> pcmpctblock = std::make_shared<const CBlockHeaderAndShortTxIDs> (*pblock, true);
     const CNetMsgMaker msgMaker(PROTOCOL_VERSION);
+    // Serialize the compact block once for every peer it is announced to
+    const std::shared_ptr<const SharedPayload> cmpctblock_payload = msgMaker.MakeSharedPayload(0, *pcmpctblock);
 
     LOCK(cs_main);
 
@@ -1462,13 +1554,15 @@ void PeerManagerImpl::NewPoWValidBlock(const CBlockIndex *pindex, const std::sha
         most_recent_block_hash = hashBlock;
         most_recent_block = pblock;
         most_recent_compact_block = pcmpctblock;
+        most_recent_compact_block_payload = cmpctblock_payload;
         fWitnessesPresentInMostRecentCompactBlock = fWitnessEnabled;
     }
 
-    m_connman.ForEachNode([this, &pcmpctblock, pindex, &msgMaker, fWitnessEnabled, &hashBlock](CNode* pnode) EXCLUSIVE_LOCKS_REQUIRED(::cs_main) {
+    const bool early_relayed = m_early_relayed_block && m_early_relayed_block->GetHash() == hashBlock;
+
+    m_connman.ForEachNode([this, &cmpctblock_payload, pindex, fWitnessEnabled, &hashBlock, early_relayed](CNode* pnode) EXCLUSIVE_LOCKS_REQUIRED(::cs_main) {
         AssertLockHeld(::cs_main);
 
-        // TODO: Avoid the repeated-serialization here
         if (pnode->GetCommonVersion() < INVALID_CB_NO_BAN_VERSION || pnode->fDisconnect)
             return;
         ProcessBlockAvailability(pnode->GetId());
@@ -1478,14 +1572,60 @@ void PeerManagerImpl::NewPoWValidBlock(const CBlockIndex *pindex, const std::sha
         if (state.fPreferHeaderAndIDs && (!fWitnessEnabled || state.fWantsCmpctWitness) &&
                 !PeerHasHeader(&state, pindex) && PeerHasHeader(&state, pindex->pprev)) {
 
+            if (early_relayed && std::count(m_early_relay_peers.begin(), m_early_relay_peers.end(), pnode->GetId())) {
+                // Already announced by RelayCompactBlockEarly; now that the
+                // block passed AcceptBlock, count it as announced
+                state.pindexBestHeaderSent = pindex;
+                return;
+            }
             LogPrint(BCLog::NET, "%s sending header-and-ids %s to peer=%d\n", "PeerManager::NewPoWValidBlock",
                     hashBlock.ToString(), pnode->GetId());
-            m_connman.PushMessage(pnode, msgMaker.Make(NetMsgType::CMPCTBLOCK, *pcmpctblock));
+            m_connman.PushMessage(pnode, CNetMsgMaker::MakeShared(NetMsgType::CMPCTBLOCK, cmpctblock_payload));
             state.pindexBestHeaderSent = pindex;
         }
     });
 }
 
+void PeerManagerImpl::RelayCompactBlockEarly(const CBlockIndex* pindex, const std::shared_ptr<const CBlock>& pblock, NodeId from)
+{
+    AssertLockHeld(cs_main);
+
+    if (m_chainman.ActiveChainstate().IsInitialBlockDownload() || pindex->pprev != m_chainman.ActiveChain().Tip()) return;
+    if (!IsWitnessEnabled(pindex->pprev, m_chainparams.GetConsensus())) return;
+    const CNodeState* from_state = State(from);
+    if (!from_state || !from_state->fSupportsDesiredCmpctVersion) return;
+
+    // Announce a compact block of our own rather than forwarding the one we
+    // received, so that what we relay is derived from the checked block.
+    const CBlockHeaderAndShortTxIDs cmpctblock(*pblock, true);
+    const std::shared_ptr<const SharedPayload> cmpctblock_payload = CNetMsgMaker(PROTOCOL_VERSION).MakeSharedPayload(0, cmpctblock);
+    std::vector<NodeId> relayed_to;
+
+    m_connman.ForEachNode([this, &cmpctblock_payload, pindex, from, &relayed_to](CNode* pnode) EXCLUSIVE_LOCKS_REQUIRED(::cs_main) {
+        AssertLockHeld(::cs_main);
+
+        if (pnode->GetId() == from || pnode->GetCommonVersion() < INVALID_CB_NO_BAN_VERSION || pnode->fDisconnect)
+            return;
+        ProcessBlockAvailability(pnode->GetId());
+        CNodeState &state = *State(pnode->GetId());
+        if (state.fPreferHeaderAndIDs && state.fWantsCmpctWitness &&
+                !PeerHasHeader(&state, pindex) && PeerHasHeader(&state, pindex->pprev)) {
+
+            LogPrint(BCLog::NET, "%s sending header-and-ids %s to peer=%d before validation\n", "PeerManager::RelayCompactBlockEarly",
+                    pindex->GetBlockHash().ToString(), pnode->GetId());
+            m_connman.PushMessage(pnode, CNetMsgMaker::MakeShared(NetMsgType::CMPCTBLOCK, cmpctblock_payload));
+            // pindexBestHeaderSent is left alone: the block has not been
+            // accepted yet, see NewPoWValidBlock
+            relayed_to.push_back(pnode->GetId());
+        }
+    });
+
+    if (!relayed_to.empty()) {
+        m_early_relayed_block = pblock;
+        m_early_relay_peers = std::move(relayed_to);
+    }
+}
+
 /**
  * Update our best height and announce any block hashes which weren't previously
  * in m_chainman.ActiveChain() to our peers.
@@ -1566,7 +1706,7 @@ void PeerManagerImpl::BlockChecked(const CBlock& block, const BlockValidationSta
 //
 
 
-bool PeerManagerImpl::AlreadyHaveTx(const GenTxid& gtxid)
+bool PeerManagerImpl::AlreadyHaveTx(const GenTxid& gtxid, bool include_reconsiderable)
 {
     assert(recentRejects);
     if (m_chainman.ActiveChain().Tip()->GetBlockHash() != hashRecentRejectsChainTip) {
@@ -1576,10 +1716,13 @@ bool PeerManagerImpl::AlreadyHaveTx(const GenTxid& gtxid)
         // txs a second chance.
         hashRecentRejectsChainTip = m_chainman.ActiveChain().Tip()->GetBlockHash();
         recentRejects->reset();
+        m_recent_rejects_reconsiderable->reset();
     }
 
     const uint256& hash = gtxid.GetHash();
 
+    if (include_reconsiderable && m_recent_rejects_reconsiderable->contains(hash)) return true;
+
     if (m_orphanage.HaveTx(gtxid)) return true;
 
     {
@@ -1670,11 +1813,13 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv&
 {
     std::shared_ptr<const CBlock> a_recent_block;
     std::shared_ptr<const CBlockHeaderAndShortTxIDs> a_recent_compact_block;
+    std::shared_ptr<const SharedPayload> a_recent_compact_block_payload;
     bool fWitnessesPresentInARecentCompactBlock;
     {
         LOCK(cs_most_recent_block);
         a_recent_block = most_recent_block;
         a_recent_compact_block = most_recent_compact_block;
+        a_recent_compact_block_payload = most_recent_compact_block_payload;
         fWitnessesPresentInARecentCompactBlock = fWitnessesPresentInMostRecentCompactBlock;
     }
 
@@ -1701,60 +1846,96 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv&
         }
     }
 
-    LOCK(cs_main);
-    const CBlockIndex* pindex = m_chainman.m_blockman.LookupBlockIndex(inv.hash);
-    if (!pindex) {
-        return;
-    }
-    if (!BlockRequestAllowed(pindex)) {
-        LogPrint(BCLog::NET, "%s: ignoring request from peer=%i for old block that isn't in the main chain\n", __func__, pfrom.GetId());
-        return;
-    }
     const CNetMsgMaker msgMaker(pfrom.GetCommonVersion());
-    // disconnect node in case we have reached the outbound limit for serving historical blocks
-    if (m_connman.OutboundTargetReached(true) &&
-        (((pindexBestHeader != nullptr) && (pindexBestHeader->GetBlockTime() - pindex->GetBlockTime() > HISTORICAL_BLOCK_AGE)) || inv.IsMsgFilteredBlk()) &&
-        !pfrom.HasPermission(NetPermissionFlags::Download) // nodes with the download permission may exceed target
-    ) {
-        LogPrint(BCLog::NET, "historical block serving limit reached, disconnect peer=%d\n", pfrom.GetId());
-        pfrom.fDisconnect = true;
-        return;
-    }
-    // Avoid leaking prune-height by never sending blocks below the NODE_NETWORK_LIMITED threshold
-    if (!pfrom.HasPermission(NetPermissionFlags::NoBan) && (
-            (((pfrom.GetLocalServices() & NODE_NETWORK_LIMITED) == NODE_NETWORK_LIMITED) && ((pfrom.GetLocalServices() & NODE_NETWORK) != NODE_NETWORK) && (m_chainman.ActiveChain().Tip()->nHeight - pindex->nHeight > (int)NODE_NETWORK_LIMITED_MIN_BLOCKS + 2 /* add two blocks buffer extension for possible races */) )
-       )) {
-        LogPrint(BCLog::NET, "Ignore block request below NODE_NETWORK_LIMITED threshold, disconnect peer=%d\n", pfrom.GetId());
-        //disconnect node and prevent it from stalling (would otherwise wait for the missing block)
-        pfrom.fDisconnect = true;
-        return;
-    }
-    // Pruned nodes may have deleted the block, so check whether
-    // it's available before trying to send.
-    if (!(pindex->nStatus & BLOCK_HAVE_DATA)) {
-        return;
+    // Everything needed from the block index is copied out under a short
+    // cs_main section; the disk read and serialization below run without it.
+    FlatFilePos block_pos;
+    bool fPeerWantsWitness;
+    bool send_compact;
+    bool cacheable;
+    uint256 tip_hash;
+    {
+        LOCK(cs_main);
+        const CBlockIndex* pindex = m_chainman.m_blockman.LookupBlockIndex(inv.hash);
+        if (!pindex) {
+            return;
+        }
+        if (!BlockRequestAllowed(pindex)) {
+            LogPrint(BCLog::NET, "%s: ignoring request from peer=%i for old block that isn't in the main chain\n", __func__, pfrom.GetId());
+            return;
+        }
+        // disconnect node in case we have reached the outbound limit for serving historical blocks
+        if (m_connman.OutboundTargetReached(true) &&
+            (((pindexBestHeader != nullptr) && (pindexBestHeader->GetBlockTime() - pindex->GetBlockTime() > HISTORICAL_BLOCK_AGE)) || inv.IsMsgFilteredBlk()) &&
+            !pfrom.HasPermission(NetPermissionFlags::Download) // nodes with the download permission may exceed target
+        ) {
+            LogPrint(BCLog::NET, "historical block serving limit reached, disconnect peer=%d\n", pfrom.GetId());
+            pfrom.fDisconnect = true;
+            return;
+        }
+        // Avoid leaking prune-height by never sending blocks below the NODE_NETWORK_LIMITED threshold
+        if (!pfrom.HasPermission(NetPermissionFlags::NoBan) && (
+                (((pfrom.GetLocalServices() & NODE_NETWORK_LIMITED) == NODE_NETWORK_LIMITED) && ((pfrom.GetLocalServices() & NODE_NETWORK) != NODE_NETWORK) && (m_chainman.ActiveChain().Tip()->nHeight - pindex->nHeight > (int)NODE_NETWORK_LIMITED_MIN_BLOCKS + 2 /* add two blocks buffer extension for possible races */) )
+           )) {
+            LogPrint(BCLog::NET, "Ignore block request below NODE_NETWORK_LIMITED threshold, disconnect peer=%d\n", pfrom.GetId());
+            //disconnect node and prevent it from stalling (would otherwise wait for the missing block)
+            pfrom.fDisconnect = true;
+            return;
+        }
+        // Pruned nodes may have deleted the block, so check whether
+        // it's available before trying to send.
+        if (!(pindex->nStatus & BLOCK_HAVE_DATA)) {
+            return;
+        }
+        block_pos = pindex->GetBlockPos();
+        fPeerWantsWitness = State(pfrom.GetId())->fWantsCmpctWitness;
+        send_compact = CanDirectFetch() && pindex->nHeight >= m_chainman.ActiveChain().Height() - MAX_CMPCTBLOCK_DEPTH;
+        cacheable = pindex->nHeight >= m_chainman.ActiveChain().Height() - MAX_BLOCK_SERVE_CACHE_DEPTH;
+        tip_hash = m_chainman.ActiveChain().Tip()->GetBlockHash();
+    } // release cs_main before reading the block from disk
+
+    // Plain block requests are answered with a serialized block, which may
+    // come from (and is added to) the cache of recent blocks.
+    const bool send_serialized{inv.IsMsgBlk() || inv.IsMsgWitnessBlk()};
+    BlockServeCache::Data block_data;
+    if (send_serialized && cacheable) {
+        block_data = m_block_serve_cache.Get(inv.hash, inv.IsMsgWitnessBlk());
     }
     std::shared_ptr<const CBlock> pblock;
-    if (a_recent_block && a_recent_block->GetHash() == pindex->GetBlockHash()) {
+    if (block_data) {
+        // Served from the cache below
+    } else if (a_recent_block && a_recent_block->GetHash() == inv.hash) {
         pblock = a_recent_block;
     } else if (inv.IsMsgWitnessBlk()) {
         // Fast-path: in this case it is possible to serve the block directly from disk,
         // as the network format matches the format on disk
-        std::vector<uint8_t> block_data;
-        if (!ReadRawBlockFromDisk(block_data, pindex, m_chainparams.MessageStart())) {
-            assert(!"cannot load block from disk");
+        std::vector<uint8_t> raw_block;
+        if (!ReadRawBlockFromDisk(raw_block, block_pos, m_chainparams.MessageStart())) {
+            // The block may have been pruned since cs_main was released
+            LogPrint(BCLog::NET, "cannot load block %s from disk, ignoring request from peer=%d\n", inv.hash.ToString(), pfrom.GetId());
+            return;
         }
-        m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::BLOCK, MakeSpan(block_data)));
-        // Don't set pblock as we've sent the block
+        block_data = std::make_shared<const SharedPayload>(std::move(raw_block));
+        if (cacheable) m_block_serve_cache.Insert(inv.hash, /* witness */ true, block_data);
     } else {
         // Send block from disk
         std::shared_ptr<CBlock> pblockRead = std::make_shared<CBlock>();
-        if (!ReadBlockFromDisk(*pblockRead, pindex, m_chainparams.GetConsensus())) {
-            assert(!"cannot load block from disk");
+        if (!ReadBlockFromDisk(*pblockRead, block_pos, m_chainparams.GetConsensus()) || pblockRead->GetHash() != inv.hash) {
+            // The block may have been pruned since cs_main was released
+            LogPrint(BCLog::NET, "cannot load block %s from disk, ignoring request from peer=%d\n", inv.hash.ToString(), pfrom.GetId());
+            return;
         }
         pblock = pblockRead;
     }
-    if (pblock) {
+    if (!block_data && pblock && send_serialized && cacheable) {
+        // Cached serializations are shared between peers, so don't depend on the peer's version
+        const int ser_flags = inv.IsMsgBlk() ? SERIALIZE_TRANSACTION_NO_WITNESS : 0;
+        block_data = CNetMsgMaker(PROTOCOL_VERSION).MakeSharedPayload(ser_flags, *pblock);
+        m_block_serve_cache.Insert(inv.hash, inv.IsMsgWitnessBlk(), block_data);
+    }
+    if (block_data) {
+        m_connman.PushMessage(&pfrom, CNetMsgMaker::MakeShared(NetMsgType::BLOCK, block_data));
+    } else if (pblock) {
         if (inv.IsMsgBlk()) {
             m_connman.PushMessage(&pfrom, msgMaker.Make(SERIALIZE_TRANSACTION_NO_WITNESS, NetMsgType::BLOCK, *pblock));
         } else if (inv.IsMsgWitnessBlk()) {
@@ -1788,11 +1969,10 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv&
             // they won't have a useful mempool to match against a compact block,
             // and we don't feel like constructing the object for them, so
             // instead we respond with the full, non-compact block.
-            bool fPeerWantsWitness = State(pfrom.GetId())->fWantsCmpctWitness;
             int nSendFlags = fPeerWantsWitness ? 0 : SERIALIZE_TRANSACTION_NO_WITNESS;
-            if (CanDirectFetch() && pindex->nHeight >= m_chainman.ActiveChain().Height() - MAX_CMPCTBLOCK_DEPTH) {
-                if ((fPeerWantsWitness || !fWitnessesPresentInARecentCompactBlock) && a_recent_compact_block && a_recent_compact_block->header.GetHash() == pindex->GetBlockHash()) {
-                    m_connman.PushMessage(&pfrom, msgMaker.Make(nSendFlags, NetMsgType::CMPCTBLOCK, *a_recent_compact_block));
+            if (send_compact) {
+                if ((fPeerWantsWitness || !fWitnessesPresentInARecentCompactBlock) && a_recent_compact_block && a_recent_compact_block->header.GetHash() == inv.hash) {
+                    m_connman.PushMessage(&pfrom, CNetMsgMaker::MakeShared(NetMsgType::CMPCTBLOCK, a_recent_compact_block_payload));
                 } else {
                     CBlockHeaderAndShortTxIDs cmpctblock(*pblock, fPeerWantsWitness);
                     m_connman.PushMessage(&pfrom, msgMaker.Make(nSendFlags, NetMsgType::CMPCTBLOCK, cmpctblock));
@@ -1811,7 +1991,7 @@ void PeerManagerImpl::ProcessGetBlockData(CNode& pfrom, Peer& peer, const CInv&
             // and we want it right after the last block so they don't
             // wait for other stuff first.
             std::vector<CInv> vInv;
-            vInv.push_back(CInv(MSG_BLOCK, m_chainman.ActiveChain().Tip()->GetBlockHash()));
+            vInv.push_back(CInv(MSG_BLOCK, tip_hash));
             m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::INV, vInv));
             peer.m_continuation_block.SetNull();
         }
@@ -2148,20 +2328,220 @@ void PeerManagerImpl::ProcessHeadersMessage(CNode& pfrom, const Peer& peer,
     return;
 }
 
+bool PeerManagerImpl::ProcessOrphanPackage(const CTransactionRef& parent, NodeId peer, std::set<uint256>& orphan_work_set)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(g_cs_orphans);
+
+    // Only one package is tried for each arrival of the parent, so that a
+    // parent with many orphaned children does not cost a package validation
+    // for each of them. Prefer a child announced by the peer the parent came from.
+    const auto children = m_orphanage.GetChildren(*parent);
+    if (children.empty()) return false;
+    auto it = std::find_if(children.cbegin(), children.cend(), [peer](const auto& child) { return child.second == peer; });
+    if (it == children.cend()) it = children.cbegin();
+    const auto& [child, from_peer] = *it;
+
+    const PackageMempoolAcceptResult package_result = ProcessNewPackage(m_chainman.ActiveChainstate(), m_mempool,
+                                                                        {parent, child}, /* test_accept */ false);
+    if (package_result.m_state.IsValid()) {
+        LogPrint(BCLog::MEMPOOL, "   accepted package of tx %s with orphan %s from peer=%d\n",
+                 parent->GetHash().ToString(), child->GetHash().ToString(), from_peer);
+        ProcessValidPackage({parent, child}, orphan_work_set);
+        return true;
+    }
+
+    if (ProcessInvalidPackage(package_result, child)) {
+        LogPrint(BCLog::MEMPOOL, "   removed orphan tx %s, package with %s failed: %s\n",
+                 child->GetHash().ToString(), parent->GetHash().ToString(), package_result.m_state.ToString());
+        m_orphanage.EraseTx(child->GetHash());
+    }
+    return false;
+}
+
+bool PeerManagerImpl::ProcessInvalidPackage(const PackageMempoolAcceptResult& package_result, const CTransactionRef& child)
+{
+    AssertLockHeld(cs_main);
+
+    // A package that did not pay enough may still be accepted once the child
+    // is replaced or the mempool minimum fee drops, so the child is kept. For
+    // any other failure, the transaction that failed is not downloaded again.
+    const std::string& reject_reason = package_result.m_state.GetRejectReason();
+    if (reject_reason == "package-fee-too-low" || reject_reason == "package-child-feerate-too-low") return false;
+    for (const auto& [wtxid, tx_result] : package_result.m_tx_results) {
+        const TxValidationResult result = tx_result.m_state.GetResult();
+        if (result == TxValidationResult::TX_RECONSIDERABLE) return false;
+        if (result == TxValidationResult::TX_MISSING_INPUTS) {
+            // The child may still find its other parents.
+            if (wtxid == child->GetWitnessHash()) return false;
+        } else if (result != TxValidationResult::TX_WITNESS_STRIPPED) {
+            recentRejects->insert(wtxid);
+        }
+    }
+    if (package_result.m_tx_results.empty()) recentRejects->insert(child->GetWitnessHash());
+    return true;
+}
+
+void PeerManagerImpl::ProcessValidPackage(const Package& package, std::set<uint256>& orphan_work_set)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(g_cs_orphans);
+
+    for (const CTransactionRef& tx : package) {
+        m_txrequest.ForgetTxHash(tx->GetHash());
+        m_txrequest.ForgetTxHash(tx->GetWitnessHash());
+        _RelayTransaction(tx->GetHash(), tx->GetWitnessHash());
+        m_orphanage.AddChildrenToWorkSet(*tx, orphan_work_set);
+        m_orphanage.EraseTx(tx->GetHash());
+    }
+    m_mempool.check(m_chainman.ActiveChainstate());
+}
+
+void PeerManagerImpl::ProcessPackage(CNode& node, Peer& peer, const Package& package)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(g_cs_orphans);
+
+    for (const CTransactionRef& tx : package) {
+        node.AddKnownTx(tx->GetWitnessHash());
+        node.AddKnownTx(tx->GetHash());
+        m_txrequest.ReceivedResponse(node.GetId(), tx->GetHash());
+        if (tx->HasWitness()) m_txrequest.ReceivedResponse(node.GetId(), tx->GetWitnessHash());
+    }
+
+    const CTransactionRef& child = package.back();
+    // The child was requested as an orphan, so it is normally still in the
+    // orphanage. Otherwise it is not validated again if we already have or
+    // recently rejected it.
+    const GenTxid child_gtxid{/* is_wtxid=*/true, child->GetWitnessHash()};
+    if (!m_orphanage.HaveTx(child_gtxid) && AlreadyHaveTx(child_gtxid, /* include_reconsiderable */ true)) return;
+
+    // Parents that are already in our mempool need no validation, so only
+    // the missing ones are validated together with the child.
+    Package missing;
+    for (auto it = package.cbegin(); it != package.cend() - 1; ++it) {
+        const CTransactionRef& parent = *it;
+        if (recentRejects->contains(parent->GetWitnessHash())) {
+            LogPrint(BCLog::MEMPOOL, "not validating package of %s with rejected parent %s from peer=%d\n",
+                     child->GetHash().ToString(), parent->GetHash().ToString(), node.GetId());
+            return;
+        }
+        if (!m_mempool.exists(GenTxid(/* is_wtxid=*/true, parent->GetWitnessHash()))) missing.push_back(parent);
+    }
+    missing.push_back(child);
+
+    if (missing.size() == 1) {
+        const MempoolAcceptResult result = AcceptToMemoryPool(m_chainman.ActiveChainstate(), m_mempool, child, false /* bypass_limits */);
+        if (result.m_result_type != MempoolAcceptResult::ResultType::VALID) {
+            LogPrint(BCLog::MEMPOOL, "tx %s of package from peer=%d was not accepted: %s\n",
+                     child->GetHash().ToString(), node.GetId(), result.m_state.ToString());
+            const TxValidationResult tx_result = result.m_state.GetResult();
+            if (tx_result == TxValidationResult::TX_RECONSIDERABLE) {
+                m_recent_rejects_reconsiderable->insert(child->GetWitnessHash());
+            } else if (tx_result != TxValidationResult::TX_MISSING_INPUTS) {
+                if (tx_result != TxValidationResult::TX_WITNESS_STRIPPED) recentRejects->insert(child->GetWitnessHash());
+                m_orphanage.EraseTx(child->GetHash());
+            }
+            MaybePunishNodeForTx(node.GetId(), result.m_state);
+            return;
+        }
+        for (const CTransactionRef& removedTx : result.m_replaced_transactions.value()) {
+            AddToCompactExtraTransactions(removedTx);
+        }
+    } else {
+        const PackageMempoolAcceptResult result = ProcessNewPackage(m_chainman.ActiveChainstate(), m_mempool, missing, /* test_accept */ false);
+        if (!result.m_state.IsValid()) {
+            LogPrint(BCLog::MEMPOOL, "package of %s from peer=%d was not accepted: %s\n",
+                     child->GetHash().ToString(), node.GetId(), result.m_state.ToString());
+            if (ProcessInvalidPackage(result, child)) m_orphanage.EraseTx(child->GetHash());
+            for (const auto& [wtxid, tx_result] : result.m_tx_results) {
+                MaybePunishNodeForTx(node.GetId(), tx_result.m_state);
+            }
+            return;
+        }
+    }
+
+    LogPrint(BCLog::MEMPOOL, "accepted package of %u tx with child %s from peer=%d (poolsz %u txn, %u kB)\n",
+             missing.size(), child->GetHash().ToString(), node.GetId(),
+             m_mempool.size(), m_mempool.DynamicMemoryUsage() / 1000);
+    ProcessValidPackage(missing, peer.m_orphan_work_set);
+    node.nLastTXTime = GetTime();
+    ProcessOrphanTx(peer.m_orphan_work_set);
+}
+
+void PeerManagerImpl::SendPackage(CNode& node, const uint256& wtxid)
+{
+    const CNetMsgMaker msgMaker(node.GetCommonVersion());
+    const std::chrono::seconds now = GetTime<std::chrono::seconds>();
+    const std::chrono::seconds mempool_req = node.m_tx_relay->m_last_mempool_req.load();
+    // Only a transaction we would serve in reply to getdata is sent with its parents.
+    const CTransactionRef tx = FindTxForGetData(node, GenTxid{/* is_wtxid=*/true, wtxid}, mempool_req, now);
+
+    Package package;
+    if (tx) {
+        LOCK(m_mempool.cs);
+        const auto txiter = m_mempool.GetIter(tx->GetHash());
+        // Without unconfirmed parents, or with too many of them, there is no
+        // package to send.
+        const size_t parent_count = txiter ? (*txiter)->GetMemPoolParentsConst().size() : 0;
+        if (parent_count > 0 && parent_count < MAX_PACKAGE_COUNT) {
+            std::vector<const CTxMemPoolEntry*> sorted_parents;
+            size_t package_size{(*txiter)->GetTxSize()};
+            for (const CTxMemPoolEntry& parent : (*txiter)->GetMemPoolParentsConst()) {
+                sorted_parents.push_back(&parent);
+                package_size += parent.GetTxSize();
+            }
+            if (package_size <= MAX_PACKAGE_SIZE * 1000) {
+                // An entry has fewer in-mempool ancestors than any of its descendants.
+                std::sort(sorted_parents.begin(), sorted_parents.end(), [](const CTxMemPoolEntry* a, const CTxMemPoolEntry* b) {
+                    return a->GetCountWithAncestors() < b->GetCountWithAncestors();
+                });
+                package.reserve(sorted_parents.size() + 1);
+                for (const CTxMemPoolEntry* parent : sorted_parents) {
+                    package.push_back(parent->GetSharedTx());
+                }
+                package.push_back(tx);
+            }
+        }
+    }
+
+    if (package.empty()) {
+        // Let the peer know, so that it requests the parents one by one
+        m_connman.PushMessage(&node, msgMaker.Make(NetMsgType::NOTFOUND, std::vector<CInv>{CInv{MSG_WTX, wtxid}}));
+        return;
+    }
+    m_connman.PushMessage(&node, msgMaker.Make(NetMsgType::PKGTXNS, package));
+    m_mempool.RemoveUnbroadcastTx(tx->GetHash());
+}
+
+void PeerManagerImpl::RequestPackageParents(const CNode& node, const uint256& wtxid, const std::vector<uint256>& parent_txids,
+                                            std::chrono::microseconds current_time)
+{
+    AssertLockHeld(cs_main);
+
+    // Nothing to do if the orphan was resolved or evicted meanwhile
+    if (!m_orphanage.HaveTx(GenTxid{/* is_wtxid=*/true, wtxid})) return;
+    for (const uint256& parent_txid : parent_txids) {
+        const GenTxid gtxid{/* is_wtxid=*/false, parent_txid};
+        if (!AlreadyHaveTx(gtxid, /* include_reconsiderable */ false)) AddTxAnnouncement(node, gtxid, current_time);
+    }
+}
+
 /**
  * Reconsider orphan transactions after a parent has been accepted to the mempool.
  *
- * @param[in,out]  orphan_work_set  The set of orphan transactions to reconsider. Generally only one
- *                                  orphan will be reconsidered on each call of this function. This set
- *                                  may be added to if accepting an orphan causes its children to be
- *                                  reconsidered.
+ * @param[in,out]  orphan_work_set  The set of orphan transactions to reconsider. Up to
+ *                                  MAX_ORPHAN_RESOLUTION_BATCH orphans will be accepted on each
+ *                                  call of this function. This set may be added to if accepting
+ *                                  an orphan causes its children to be reconsidered.
  */
 void PeerManagerImpl::ProcessOrphanTx(std::set<uint256>& orphan_work_set)
 {
     AssertLockHeld(cs_main);
     AssertLockHeld(g_cs_orphans);
 
-    while (!orphan_work_set.empty()) {
+    unsigned int resolved{0};
+    while (!orphan_work_set.empty() && resolved < MAX_ORPHAN_RESOLUTION_BATCH) {
         const uint256 orphanHash = *orphan_work_set.begin();
         orphan_work_set.erase(orphan_work_set.begin());
 
@@ -2179,7 +2559,11 @@ void PeerManagerImpl::ProcessOrphanTx(std::set<uint256>& orphan_work_set)
             for (const CTransactionRef& removedTx : result.m_replaced_transactions.value()) {
                 AddToCompactExtraTransactions(removedTx);
             }
-            break;
+            ++resolved;
+        } else if (state.GetResult() == TxValidationResult::TX_RECONSIDERABLE &&
+                   ProcessOrphanPackage(porphanTx, from_peer, orphan_work_set)) {
+            m_orphanage.EraseTx(orphanHash);
+            ++resolved;
         } else if (state.GetResult() != TxValidationResult::TX_MISSING_INPUTS) {
             if (state.IsInvalid()) {
                 LogPrint(BCLog::MEMPOOL, "   invalid orphan tx %s from peer=%d. %s\n",
@@ -2192,7 +2576,11 @@ void PeerManagerImpl::ProcessOrphanTx(std::set<uint256>& orphan_work_set)
             // Has inputs but not accepted to mempool
             // Probably non-standard or insufficient fee
             LogPrint(BCLog::MEMPOOL, "   removed orphan tx %s\n", orphanHash.ToString());
-            if (state.GetResult() != TxValidationResult::TX_WITNESS_STRIPPED) {
+            // Transactions rejected only for their feerate may still be accepted as
+            // part of a package later, so they go to a separate filter.
+            if (state.GetResult() == TxValidationResult::TX_RECONSIDERABLE) {
+                m_recent_rejects_reconsiderable->insert(porphanTx->GetWitnessHash());
+            } else if (state.GetResult() != TxValidationResult::TX_WITNESS_STRIPPED) {
                 // We can add the wtxid of this transaction to our reject filter.
                 // Do not add txids of witness transactions or witness-stripped
                 // transactions to the filter, as they can have been malleated;
@@ -2223,7 +2611,7 @@ void PeerManagerImpl::ProcessOrphanTx(std::set<uint256>& orphan_work_set)
                 }
             }
             m_orphanage.EraseTx(orphanHash);
-            break;
+            ++resolved;
         }
     }
     m_mempool.check(m_chainman.ActiveChainstate());
@@ -2507,6 +2895,14 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
             m_connman.PushMessage(&pfrom, msg_maker.Make(NetMsgType::SENDADDRV2));
         }
 
+        // Signal package relay support if the peer may negotiate wtxid relay,
+        // as packages are requested by wtxid, and transactions are relayed in
+        // both directions on this connection.
+        if (m_package_relay && greatest_common_version >= WTXID_RELAY_VERSION && fRelay && !m_ignore_incoming_txs &&
+            pfrom.m_tx_relay != nullptr && !pfrom.IsFeelerConn() && !pfrom.IsAddrFetchConn()) {
+            m_connman.PushMessage(&pfrom, msg_maker.Make(NetMsgType::SENDPACKAGES));
+        }
+
         m_connman.PushMessage(&pfrom, msg_maker.Make(NetMsgType::VERACK));
 
         pfrom.nServices = nServices;
@@ -2658,6 +3054,13 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
             nCMPCTBLOCKVersion = 1;
             m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::SENDCMPCT, fAnnounceUsingCMPCTBLOCK, nCMPCTBLOCKVersion));
         }
+
+        {
+            // Packages are requested by wtxid, so package relay also needs wtxid relay.
+            LOCK(cs_main);
+            CNodeState* state = State(pfrom.GetId());
+            if (!state->m_wtxid_relay) state->m_package_relay = false;
+        }
         pfrom.fSuccessfullyConnected = true;
         return;
     }
@@ -2731,6 +3134,23 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
         return;
     }
 
+    // Package relay is negotiated between VERSION and VERACK like wtxidrelay.
+    if (msg_type == NetMsgType::SENDPACKAGES) {
+        if (pfrom.fSuccessfullyConnected) {
+            // Disconnect peers that send a SENDPACKAGES message after VERACK.
+            LogPrint(BCLog::NET, "sendpackages received after verack from peer=%d; disconnecting\n", pfrom.GetId());
+            pfrom.fDisconnect = true;
+            return;
+        }
+        if (!m_package_relay || m_ignore_incoming_txs || pfrom.m_tx_relay == nullptr) {
+            LogPrint(BCLog::NET, "ignoring sendpackages from peer=%d\n", pfrom.GetId());
+            return;
+        }
+        LOCK(cs_main);
+        State(pfrom.GetId())->m_package_relay = true;
+        return;
+    }
+
     if (!pfrom.fSuccessfullyConnected) {
         LogPrint(BCLog::NET, "Unsupported message \"%s\" prior to verack from peer=%d\n", SanitizeString(msg_type), pfrom.GetId());
         return;
@@ -2849,7 +3269,7 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
                 }
             } else if (inv.IsGenTxMsg()) {
                 const GenTxid gtxid = ToGenTxid(inv);
-                const bool fAlreadyHave = AlreadyHaveTx(gtxid);
+                const bool fAlreadyHave = AlreadyHaveTx(gtxid, /* include_reconsiderable */ true);
                 LogPrint(BCLog::NET, "got inv: %s  %s peer=%d\n", inv.ToString(), fAlreadyHave ? "have" : "new", pfrom.GetId());
 
                 pfrom.AddKnownTx(inv.hash);
@@ -2983,6 +3403,12 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
         {
             LOCK(cs_main);
 
+            if (m_early_relayed_block && m_early_relayed_block->GetHash() == req.blockhash) {
+                // We relayed this block before it was stored
+                SendBlockTransactions(pfrom, *m_early_relayed_block, req);
+                return;
+            }
+
             const CBlockIndex* pindex = m_chainman.m_blockman.LookupBlockIndex(req.blockhash);
             if (!pindex || !(pindex->nStatus & BLOCK_HAVE_DATA)) {
                 LogPrint(BCLog::NET, "Peer %d sent us a getblocktxn for a block we don't have\n", pfrom.GetId());
@@ -3130,7 +3556,18 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
         // already; and an adversary can already relay us old transactions
         // (older than our recency filter) if trying to DoS us, without any need
         // for witness malleation.
-        if (AlreadyHaveTx(GenTxid(/* is_wtxid=*/true, wtxid))) {
+        if (AlreadyHaveTx(GenTxid(/* is_wtxid=*/true, wtxid), /* include_reconsiderable */ true)) {
+            if (m_recent_rejects_reconsiderable->contains(wtxid)) {
+                // The transaction paid too little on its own the last time it
+                // was validated, so only try it together with an orphaned
+                // child that may pay for it (e.g. if it was fetched as the
+                // missing parent of that child).
+                if (ProcessOrphanPackage(ptx, pfrom.GetId(), peer->m_orphan_work_set)) {
+                    pfrom.nLastTXTime = GetTime();
+                    ProcessOrphanTx(peer->m_orphan_work_set);
+                }
+                return;
+            }
             if (pfrom.HasPermission(NetPermissionFlags::ForceRelay)) {
                 // Always relay transactions received from peers with forcerelay
                 // permission, even if they were already in the mempool, allowing
@@ -3171,6 +3608,14 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
             // Recursively process any orphan transactions that depended on this one
             ProcessOrphanTx(peer->m_orphan_work_set);
         }
+        else if (state.GetResult() == TxValidationResult::TX_RECONSIDERABLE &&
+                 ProcessOrphanPackage(ptx, pfrom.GetId(), peer->m_orphan_work_set))
+        {
+            // The transaction paid too little on its own, but was accepted
+            // together with an orphaned child that pays for it.
+            pfrom.nLastTXTime = GetTime();
+            ProcessOrphanTx(peer->m_orphan_work_set);
+        }
         else if (state.GetResult() == TxValidationResult::TX_MISSING_INPUTS)
         {
             bool fRejectedParents = false; // It may be the case that the orphans parents have all been rejected
@@ -3193,6 +3638,12 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
             }
             if (!fRejectedParents) {
                 const auto current_time = GetTime<std::chrono::microseconds>();
+                // A package relay peer is asked for all missing parents at
+                // once with getpkgtxns, other peers for each of them. Once a
+                // package relay peer has too many of those requests pending,
+                // it is asked for the parents one by one as well.
+                const bool request_package = nodestate->m_package_relay &&
+                                             nodestate->m_pkgtxns_requested.size() < MAX_PEER_PKGTXNS_IN_FLIGHT;
 
                 for (const uint256& parent_txid : unique_parents) {
                     // Here, we only have the txid (and not wtxid) of the
@@ -3202,11 +3653,17 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
                     // protocol for getting all unconfirmed parents.
                     const GenTxid gtxid{/* is_wtxid=*/false, parent_txid};
                     pfrom.AddKnownTx(parent_txid);
-                    if (!AlreadyHaveTx(gtxid)) AddTxAnnouncement(pfrom, gtxid, current_time);
+                    if (!request_package && !AlreadyHaveTx(gtxid, /* include_reconsiderable */ false)) AddTxAnnouncement(pfrom, gtxid, current_time);
                 }
 
                 if (m_orphanage.AddTx(ptx, pfrom.GetId())) {
                     AddToCompactExtraTransactions(ptx);
+                    if (request_package) {
+                        // If the peer replies with notfound or not at all, the
+                        // parents are requested one by one instead.
+                        nodestate->m_pkgtxns_requested.emplace(wtxid, CNodeState::PkgTxnsRequest{current_time + GETPKGTXNS_TIMEOUT, unique_parents});
+                        m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::GETPKGTXNS, wtxid));
+                    }
                 }
 
                 // Once added to the orphan pool, a tx is considered AlreadyHave, and we shouldn't request it anymore.
@@ -3215,7 +3672,7 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
 
                 // DoS prevention: do not allow m_orphanage to grow unbounded (see CVE-2012-3789)
                 unsigned int nMaxOrphanTx = (unsigned int)std::max((int64_t)0, gArgs.GetArg("-maxorphantx", DEFAULT_MAX_ORPHAN_TRANSACTIONS));
-                unsigned int nEvicted = m_orphanage.LimitOrphans(nMaxOrphanTx);
+                unsigned int nEvicted = m_orphanage.LimitOrphans(nMaxOrphanTx, MAX_ORPHAN_WEIGHT_PER_PEER);
                 if (nEvicted > 0) {
                     LogPrint(BCLog::MEMPOOL, "orphanage overflow, removed %u tx\n", nEvicted);
                 }
@@ -3233,7 +3690,12 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
                 m_txrequest.ForgetTxHash(tx.GetWitnessHash());
             }
         } else {
-            if (state.GetResult() != TxValidationResult::TX_WITNESS_STRIPPED) {
+            // Transactions rejected only for their feerate may still be accepted as
+            // part of a package later, so they go to a separate filter.
+            if (state.GetResult() == TxValidationResult::TX_RECONSIDERABLE) {
+                m_recent_rejects_reconsiderable->insert(tx.GetWitnessHash());
+                m_txrequest.ForgetTxHash(tx.GetWitnessHash());
+            } else if (state.GetResult() != TxValidationResult::TX_WITNESS_STRIPPED) {
                 // We can add the wtxid of this transaction to our reject filter.
                 // Do not add txids of witness transactions or witness-stripped
                 // transactions to the filter, as they can have been malleated;
@@ -3294,6 +3756,48 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
         return;
     }
 
+    if (msg_type == NetMsgType::GETPKGTXNS) {
+        if (pfrom.m_tx_relay == nullptr || !WITH_LOCK(cs_main, return State(pfrom.GetId())->m_package_relay)) {
+            LogPrint(BCLog::NET, "getpkgtxns from peer=%d without package relay ignored\n", pfrom.GetId());
+            return;
+        }
+        uint256 wtxid;
+        vRecv >> wtxid;
+        SendPackage(pfrom, wtxid);
+        return;
+    }
+
+    if (msg_type == NetMsgType::PKGTXNS) {
+        // Packages are subject to the same restrictions as single transactions
+        if ((m_ignore_incoming_txs && !pfrom.HasPermission(NetPermissionFlags::Relay)) || (pfrom.m_tx_relay == nullptr))
+        {
+            LogPrint(BCLog::NET, "package sent in violation of protocol peer=%d\n", pfrom.GetId());
+            pfrom.fDisconnect = true;
+            return;
+        }
+
+        Package package;
+        vRecv >> package;
+        if (package.empty() || package.size() > MAX_PACKAGE_COUNT) {
+            Misbehaving(pfrom.GetId(), 20, strprintf("pkgtxns message size = %u", package.size()));
+            return;
+        }
+
+        LOCK2(cs_main, g_cs_orphans);
+        CNodeState* nodestate = State(pfrom.GetId());
+        if (!nodestate->m_package_relay) {
+            LogPrint(BCLog::NET, "pkgtxns from peer=%d without package relay ignored\n", pfrom.GetId());
+            return;
+        }
+        // Only packages we asked for are validated.
+        if (nodestate->m_pkgtxns_requested.erase(package.back()->GetWitnessHash()) == 0) {
+            LogPrint(BCLog::NET, "unsolicited pkgtxns from peer=%d ignored\n", pfrom.GetId());
+            return;
+        }
+        ProcessPackage(pfrom, *peer, package);
+        return;
+    }
+
     if (msg_type == NetMsgType::CMPCTBLOCK)
     {
         // Ignore cmpctblock received while importing
@@ -3451,6 +3955,7 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
                 status = tempBlock.FillBlock(*pblock, dummy);
                 if (status == READ_STATUS_OK) {
                     fBlockReconstructed = true;
+                    RelayCompactBlockEarly(pindex, pblock, pfrom.GetId());
                 }
             }
         } else {
@@ -3564,6 +4069,15 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
                 // updated, etc.
                 MarkBlockAsReceived(resp.blockhash); // it is now an empty pointer
                 fBlockRead = true;
+                if (status == READ_STATUS_OK) {
+                    // FillBlock ran CheckBlock, so the transactions match the
+                    // merkle root; announce the block while it is connected.
+                    // If it turns out to be invalid, the sender is not
+                    // punished for it (see MaybePunishNodeForBlock with
+                    // via_compact_block), just like we are not by our peers.
+                    const CBlockIndex* pindex = m_chainman.m_blockman.LookupBlockIndex(resp.blockhash);
+                    if (pindex) RelayCompactBlockEarly(pindex, pblock, pfrom.GetId());
+                }
                 // mapBlockSource is used for potentially punishing peers and
                 // updating which peers send us compact blocks, so the race
                 // between here and cs_main in ProcessNewBlock is fine.
@@ -3873,12 +4387,22 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
         vRecv >> vInv;
         if (vInv.size() <= MAX_PEER_TX_ANNOUNCEMENTS + MAX_BLOCKS_IN_TRANSIT_PER_PEER) {
             LOCK(::cs_main);
+            CNodeState* nodestate = State(pfrom.GetId());
+            const auto current_time = GetTime<std::chrono::microseconds>();
             for (CInv &inv : vInv) {
                 if (inv.IsGenTxMsg()) {
                     // If we receive a NOTFOUND message for a tx we requested, mark the announcement for it as
                     // completed in TxRequestTracker.
                     m_txrequest.ReceivedResponse(pfrom.GetId(), inv.hash);
                 }
+                if (inv.IsMsgWtx()) {
+                    // The peer won't send the package we asked for with getpkgtxns
+                    const auto it = nodestate->m_pkgtxns_requested.find(inv.hash);
+                    if (it != nodestate->m_pkgtxns_requested.end()) {
+                        RequestPackageParents(pfrom, inv.hash, it->second.m_parent_txids, current_time);
+                        nodestate->m_pkgtxns_requested.erase(it);
+                    }
+                }
             }
         }
         return;
@@ -4498,7 +5022,7 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
                         LOCK(cs_most_recent_block);
                         if (most_recent_block_hash == pBestIndex->GetBlockHash()) {
                             if (state.fWantsCmpctWitness || !fWitnessesPresentInMostRecentCompactBlock)
-                                m_connman.PushMessage(pto, msgMaker.Make(nSendFlags, NetMsgType::CMPCTBLOCK, *most_recent_compact_block));
+                                m_connman.PushMessage(pto, CNetMsgMaker::MakeShared(NetMsgType::CMPCTBLOCK, most_recent_compact_block_payload));
                             else {
                                 CBlockHeaderAndShortTxIDs cmpctblock(*most_recent_block, state.fWantsCmpctWitness);
                                 m_connman.PushMessage(pto, msgMaker.Make(nSendFlags, NetMsgType::CMPCTBLOCK, cmpctblock));
@@ -4524,7 +5048,18 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
                         LogPrint(BCLog::NET, "%s: sending header %s to peer=%d\n", __func__,
                                 vHeaders.front().GetHash().ToString(), pto->GetId());
                     }
-                    m_connman.PushMessage(pto, msgMaker.Make(NetMsgType::HEADERS, vHeaders));
+                    if (vHeaders.size() == 1) {
+                        // A new tip is usually announced to every peer with the
+                        // same single header, so serialize it only once.
+                        auto& [last_hash, last_payload] = m_last_header_announcement;
+                        if (!last_payload || last_hash != pBestIndex->GetBlockHash()) {
+                            last_hash = pBestIndex->GetBlockHash();
+                            last_payload = CNetMsgMaker(PROTOCOL_VERSION).MakeSharedPayload(0, vHeaders);
+                        }
+                        m_connman.PushMessage(pto, CNetMsgMaker::MakeShared(NetMsgType::HEADERS, last_payload));
+                    } else {
+                        m_connman.PushMessage(pto, msgMaker.Make(NetMsgType::HEADERS, vHeaders));
+                    }
                     state.pindexBestHeaderSent = pBestIndex;
                 } else
                     fRevertToInv = true;
@@ -4791,6 +5326,18 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
             }
         }
 
+        // Request the parents of orphans one by one if their packages weren't
+        // sent in time
+        for (auto it = state.m_pkgtxns_requested.begin(); it != state.m_pkgtxns_requested.end();) {
+            if (it->second.m_expiry <= current_time) {
+                LogPrint(BCLog::NET, "timeout of getpkgtxns %s from peer=%d\n", it->first.ToString(), pto->GetId());
+                RequestPackageParents(*pto, it->first, it->second.m_parent_txids, current_time);
+                it = state.m_pkgtxns_requested.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
         //
         // Message: getdata (transactions)
         //
@@ -4801,7 +5348,7 @@ bool PeerManagerImpl::SendMessages(CNode* pto)
                 entry.second.GetHash().ToString(), entry.first);
         }
         for (const GenTxid& gtxid : requestable) {
-            if (!AlreadyHaveTx(gtxid)) {
+            if (!AlreadyHaveTx(gtxid, /* include_reconsiderable */ false)) {
                 LogPrint(BCLog::NET, "Requesting %s %s peer=%d\n", gtxid.IsWtxid() ? "wtx" : "tx",
                     gtxid.GetHash().ToString(), pto->GetId());
                 vGetData.emplace_back(gtxid.IsWtxid() ? MSG_WTX : (MSG_TX | GetFetchFlags(*pto)), gtxid.GetHash());
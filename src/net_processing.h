@@ -28,9 +28,15 @@ class ChainstateManager;
 
 /** Default for -maxorphantx, maximum number of orphan transactions kept in memory */
 static const unsigned int DEFAULT_MAX_ORPHAN_TRANSACTIONS = 100;
+/** Maximum total weight of orphan transactions kept for a single peer (two max-size standard transactions) */
+static const unsigned int MAX_ORPHAN_WEIGHT_PER_PEER = 800000;
 /** Default number of orphan+recently-replaced txn to keep around for block reconstruction */
 static const unsigned int DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN = 100;
+/** Default for -blockservecachesize, in MiB, of serialized recent blocks kept for serving to peers */
+static const int64_t DEFAULT_BLOCK_SERVE_CACHE_SIZE = 32;
 static const bool DEFAULT_PEERBLOOMFILTERS = false;
+/** Default for -packagerelay, whether to relay transactions together with their unconfirmed parents */
+static const bool DEFAULT_PACKAGE_RELAY = false;
 static const bool DEFAULT_PEERBLOCKFILTERS = false;
 /** Threshold for marking a node to be discouraged, e.g. disconnected and added to the discouragement filter. */
 static const int DISCOURAGEMENT_THRESHOLD{100};
@@ -41,6 +41,25 @@ public:
         return Make(0, std::move(msg_type), std::forward<Args>(args)...);
     }
 
+    /** Serialize a payload once, to be sent to several peers with MakeShared */
+    template <typename... Args>
+    std::shared_ptr<const SharedPayload> MakeSharedPayload(int nFlags, Args&&... args) const
+    {
+        std::vector<unsigned char> data;
+        CVectorWriter{ SER_NETWORK, nFlags | nVersion, data, 0, std::forward<Args>(args)... };
+        return std::make_shared<const SharedPayload>(std::move(data));
+    }
+
+    /** Make a message whose payload is already serialized and shared with
+     *  other messages, such as a block sent to several peers */
+    static CSerializedNetMsg MakeShared(std::string msg_type, std::shared_ptr<const SharedPayload> payload)
+    {
+        CSerializedNetMsg msg;
+        msg.m_type = std::move(msg_type);
+        msg.m_shared_payload = std::move(payload);
+        return msg;
+    }
+
 private:
     const int nVersion;
 };
@@ -0,0 +1,180 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/blockstats.h>
+
+#include <consensus/consensus.h>
+#include <consensus/validation.h>
+#include <primitives/block.h>
+#include <undo.h>
+#include <util/check.h>
+#include <version.h>
+
+#include <algorithm>
+
+// outpoint (needed for the utxo index) + nHeight + fCoinBase
+static constexpr size_t PER_UTXO_OVERHEAD = sizeof(COutPoint) + sizeof(uint32_t) + sizeof(bool);
+
+template<typename T>
+static T CalculateTruncatedMedian(std::vector<T>& scores)
+{
+    size_t size = scores.size();
+    if (size == 0) {
+        return 0;
+    }
+
+    std::sort(scores.begin(), scores.end());
+    if (size % 2 == 0) {
+        return (scores[size / 2 - 1] + scores[size / 2]) / 2;
+    } else {
+        return scores[size / 2];
+    }
+}
+
+void CalculatePercentilesByWeight(CAmount result[NUM_GETBLOCKSTATS_PERCENTILES], std::vector<std::pair<CAmount, int64_t>>& scores, int64_t total_weight)
+{
+    if (scores.empty()) {
+        return;
+    }
+
+    std::sort(scores.begin(), scores.end());
+
+    // 10th, 25th, 50th, 75th, and 90th percentile weight units.
+    const double weights[NUM_GETBLOCKSTATS_PERCENTILES] = {
+        total_weight / 10.0, total_weight / 4.0, total_weight / 2.0, (total_weight * 3.0) / 4.0, (total_weight * 9.0) / 10.0
+    };
+
+    int64_t next_percentile_index = 0;
+    int64_t cumulative_weight = 0;
+    for (const auto& element : scores) {
+        cumulative_weight += element.second;
+        while (next_percentile_index < NUM_GETBLOCKSTATS_PERCENTILES && cumulative_weight >= weights[next_percentile_index]) {
+            result[next_percentile_index] = element.first;
+            ++next_percentile_index;
+        }
+    }
+
+    // Fill any remaining percentiles with the last value.
+    for (int64_t i = next_percentile_index; i < NUM_GETBLOCKSTATS_PERCENTILES; i++) {
+        result[i] = scores.back().first;
+    }
+}
+
+BlockStats ComputeBlockStats(const CBlock& block, const CBlockUndo& block_undo)
+{
+    CAmount maxfee = 0;
+    CAmount maxfeerate = 0;
+    CAmount minfee = MAX_MONEY;
+    CAmount minfeerate = MAX_MONEY;
+    CAmount total_out = 0;
+    CAmount totalfee = 0;
+    int64_t inputs = 0;
+    int64_t maxtxsize = 0;
+    int64_t mintxsize = MAX_BLOCK_SERIALIZED_SIZE;
+    int64_t outputs = 0;
+    int64_t swtotal_size = 0;
+    int64_t swtotal_weight = 0;
+    int64_t swtxs = 0;
+    int64_t total_size = 0;
+    int64_t total_weight = 0;
+    int64_t utxo_size_inc = 0;
+    std::vector<CAmount> fee_array;
+    std::vector<std::pair<CAmount, int64_t>> feerate_array;
+    std::vector<int64_t> txsize_array;
+
+    for (size_t i = 0; i < block.vtx.size(); ++i) {
+        const auto& tx = block.vtx.at(i);
+        outputs += tx->vout.size();
+
+        CAmount tx_total_out = 0;
+        for (const CTxOut& out : tx->vout) {
+            tx_total_out += out.nValue;
+            utxo_size_inc += GetSerializeSize(out, PROTOCOL_VERSION) + PER_UTXO_OVERHEAD;
+        }
+
+        if (tx->IsCoinBase()) {
+            continue;
+        }
+
+        inputs += tx->vin.size(); // Don't count coinbase's fake input
+        total_out += tx_total_out; // Don't count coinbase reward
+
+        int64_t tx_size = tx->GetTotalSize();
+        txsize_array.push_back(tx_size);
+        maxtxsize = std::max(maxtxsize, tx_size);
+        mintxsize = std::min(mintxsize, tx_size);
+        total_size += tx_size;
+
+        int64_t weight = GetTransactionWeight(*tx);
+        total_weight += weight;
+
+        if (tx->HasWitness()) {
+            ++swtxs;
+            swtotal_size += tx_size;
+            swtotal_weight += weight;
+        }
+
+        CAmount tx_total_in = 0;
+        const auto& txundo = block_undo.vtxundo.at(i - 1);
+        for (const Coin& coin: txundo.vprevout) {
+            const CTxOut& prevoutput = coin.out;
+
+            tx_total_in += prevoutput.nValue;
+            utxo_size_inc -= GetSerializeSize(prevoutput, PROTOCOL_VERSION) + PER_UTXO_OVERHEAD;
+        }
+
+        CAmount txfee = tx_total_in - tx_total_out;
+        CHECK_NONFATAL(MoneyRange(txfee));
+        fee_array.push_back(txfee);
+        maxfee = std::max(maxfee, txfee);
+        minfee = std::min(minfee, txfee);
+        totalfee += txfee;
+
+        // New feerate uses satoshis per virtual byte instead of per serialized byte
+        CAmount feerate = weight ? (txfee * WITNESS_SCALE_FACTOR) / weight : 0;
+        feerate_array.emplace_back(std::make_pair(feerate, weight));
+        maxfeerate = std::max(maxfeerate, feerate);
+        minfeerate = std::min(minfeerate, feerate);
+    }
+
+    BlockStats stats;
+    CalculatePercentilesByWeight(stats.feerate_percentiles, feerate_array, total_weight);
+
+    stats.avgfee = (block.vtx.size() > 1) ? totalfee / (block.vtx.size() - 1) : 0;
+    stats.avgfeerate = total_weight ? (totalfee * WITNESS_SCALE_FACTOR) / total_weight : 0; // Unit: sat/vbyte
+    stats.avgtxsize = (block.vtx.size() > 1) ? total_size / (block.vtx.size() - 1) : 0;
+    stats.ins = inputs;
+    stats.maxfee = maxfee;
+    stats.maxfeerate = maxfeerate;
+    stats.maxtxsize = maxtxsize;
+    stats.medianfee = CalculateTruncatedMedian(fee_array);
+    stats.mediantxsize = CalculateTruncatedMedian(txsize_array);
+    stats.minfee = (minfee == MAX_MONEY) ? 0 : minfee;
+    stats.minfeerate = (minfeerate == MAX_MONEY) ? 0 : minfeerate;
+    stats.mintxsize = mintxsize == MAX_BLOCK_SERIALIZED_SIZE ? 0 : mintxsize;
+    stats.outs = outputs;
+    stats.swtotal_size = swtotal_size;
+    stats.swtotal_weight = swtotal_weight;
+    stats.swtxs = swtxs;
+    stats.total_out = total_out;
+    stats.total_size = total_size;
+    stats.total_weight = total_weight;
+    stats.totalfee = totalfee;
+    stats.txs = block.vtx.size();
+    stats.utxo_increase = outputs - inputs;
+    stats.utxo_size_inc = utxo_size_inc;
+    return stats;
+}
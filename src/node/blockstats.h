@@ -0,0 +1,101 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_BLOCKSTATS_H
+#define BITCOIN_NODE_BLOCKSTATS_H
+
+#include <amount.h>
+#include <serialize.h>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+class CBlock;
+class CBlockUndo;
+
+static constexpr int NUM_GETBLOCKSTATS_PERCENTILES = 5;
+
+/**
+ * Statistics about the transactions of a block, as reported by the
+ * getblockstats RPC. Amounts are in satoshis and feerates in satoshis per
+ * virtual byte. Values that only depend on the block index (height, times,
+ * subsidy) are not included.
+ */
+struct BlockStats {
+    CAmount avgfee{0};
+    CAmount avgfeerate{0};
+    int64_t avgtxsize{0};
+    CAmount feerate_percentiles[NUM_GETBLOCKSTATS_PERCENTILES]{0};
+    int64_t ins{0};
+    CAmount maxfee{0};
+    CAmount maxfeerate{0};
+    int64_t maxtxsize{0};
+    CAmount medianfee{0};
+    int64_t mediantxsize{0};
+    CAmount minfee{0};
+    CAmount minfeerate{0};
+    int64_t mintxsize{0};
+    int64_t outs{0};
+    int64_t swtotal_size{0};
+    int64_t swtotal_weight{0};
+    int64_t swtxs{0};
+    CAmount total_out{0};
+    int64_t total_size{0};
+    int64_t total_weight{0};
+    CAmount totalfee{0};
+    int64_t txs{0};
+    int64_t utxo_increase{0};
+    int64_t utxo_size_inc{0};
+
+    SERIALIZE_METHODS(BlockStats, obj)
+    {
+        READWRITE(VARINT_MODE(obj.avgfee, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT_MODE(obj.avgfeerate, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT_MODE(obj.avgtxsize, VarIntMode::NONNEGATIVE_SIGNED));
+        for (auto& feerate : obj.feerate_percentiles) {
+            READWRITE(VARINT_MODE(feerate, VarIntMode::NONNEGATIVE_SIGNED));
+        }
+        READWRITE(VARINT_MODE(obj.ins, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT_MODE(obj.maxfee, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT_MODE(obj.maxfeerate, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT_MODE(obj.maxtxsize, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT_MODE(obj.medianfee, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT_MODE(obj.mediantxsize, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT_MODE(obj.minfee, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT_MODE(obj.minfeerate, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT_MODE(obj.mintxsize, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT_MODE(obj.outs, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT_MODE(obj.swtotal_size, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT_MODE(obj.swtotal_weight, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT_MODE(obj.swtxs, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT_MODE(obj.total_out, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT_MODE(obj.total_size, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT_MODE(obj.total_weight, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT_MODE(obj.totalfee, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT_MODE(obj.txs, VarIntMode::NONNEGATIVE_SIGNED));
+        // These two can be negative
+        READWRITE(obj.utxo_increase, obj.utxo_size_inc);
+    }
+};
+
+/** Compute the statistics of a block from the block and its undo data. */
+BlockStats ComputeBlockStats(const CBlock& block, const CBlockUndo& block_undo);
+
+/** Used by getblockstats to get feerates at different percentiles by weight  */
+void CalculatePercentilesByWeight(CAmount result[NUM_GETBLOCKSTATS_PERCENTILES], std::vector<std::pair<CAmount, int64_t>>& scores, int64_t total_weight);
+
+#endif // BITCOIN_NODE_BLOCKSTATS_H
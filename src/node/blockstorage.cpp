@@ -178,6 +178,60 @@ bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex* pindex)
     return true;
 }
 
+bool ReadRawUndoFromDisk(std::vector<uint8_t>& undo, const CBlockIndex* pindex, const CMessageHeader::MessageStartChars& message_start)
+{
+    FlatFilePos pos;
+    {
+        LOCK(cs_main);
+        pos = pindex->GetUndoPos();
+    }
+    if (pos.IsNull()) {
+        return error("%s: no undo data available", __func__);
+    }
+
+    FlatFilePos hpos = pos;
+    hpos.nPos -= 8; // Seek back 8 bytes for meta header
+    CAutoFile filein(OpenUndoFile(hpos, true), SER_DISK, CLIENT_VERSION);
+    if (filein.IsNull()) {
+        return error("%s: OpenUndoFile failed for %s", __func__, pos.ToString());
+    }
+
+    uint256 hashChecksum;
+    try {
+        CMessageHeader::MessageStartChars undo_start;
+        unsigned int undo_size;
+
+        filein >> undo_start >> undo_size;
+
+        if (memcmp(undo_start, message_start, CMessageHeader::MESSAGE_START_SIZE)) {
+            return error("%s: Undo magic mismatch for %s: %s versus expected %s", __func__, pos.ToString(),
+                         HexStr(undo_start),
+                         HexStr(message_start));
+        }
+
+        if (undo_size > MAX_SIZE) {
+            return error("%s: Undo data is larger than maximum deserialization size for %s: %s versus %s", __func__, pos.ToString(),
+                         undo_size, MAX_SIZE);
+        }
+
+        undo.resize(undo_size);
+        filein.read((char*)undo.data(), undo_size);
+        filein >> hashChecksum;
+    } catch (const std::exception& e) {
+        return error("%s: Read from undo file failed: %s for %s", __func__, e.what(), pos.ToString());
+    }
+
+    // Verify checksum
+    CHashWriter hasher(SER_GETHASH, PROTOCOL_VERSION);
+    hasher << pindex->pprev->GetBlockHash();
+    hasher.write((const char*)undo.data(), undo.size());
+    if (hashChecksum != hasher.GetHash()) {
+        return error("%s: Checksum mismatch for %s", __func__, pos.ToString());
+    }
+
+    return true;
+}
+
 static void FlushUndoFile(int block_file, bool finalize = false)
 {
     FlatFilePos undo_pos_old(block_file, vinfoBlockFile[block_file].nUndoSize);
@@ -0,0 +1,35 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+
+#include <policy/packages.h>
+#include <util/hasher.h>
+
+#include <algorithm>
+#include <unordered_set>
+
+bool IsChildWithParents(const Package& package)
+{
+    if (package.size() < 2) return false;
+
+    const CTransaction& child = *package.back();
+    std::unordered_set<uint256, SaltedTxidHasher> input_txids;
+    for (const CTxIn& input : child.vin) {
+        input_txids.insert(input.prevout.hash);
+    }
+    return std::all_of(package.cbegin(), package.cend() - 1,
+                       [&input_txids](const auto& tx) { return input_txids.count(tx->GetHash()) > 0; });
+}
@@ -43,4 +43,9 @@ using Package = std::vector<CTransactionRef>;
 
 class PackageValidationState : public ValidationState<PackageValidationResult> {};
 
+/** Whether the package consists of one child (the last transaction) and some
+ *  of its parents, each of which the child spends directly. A package of a
+ *  single transaction is not a child-with-parents package. */
+bool IsChildWithParents(const Package& package);
+
 #endif // BITCOIN_POLICY_PACKAGES_H
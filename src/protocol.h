@@ -273,6 +273,23 @@ extern const char* CFCHECKPT;
  * @since protocol version 70016 as described by BIP 339.
  */
 extern const char* WTXIDRELAY;
+/**
+ * Indicates that a node supports package relay: it requests and accepts a
+ * transaction together with its unconfirmed parents in a single pkgtxns
+ * message. Sent between VERSION and VERACK, and only used if wtxidrelay
+ * is negotiated as well.
+ */
+extern const char* SENDPACKAGES;
+/**
+ * Contains a wtxid, requesting the transaction together with its unconfirmed
+ * parents from a peer that negotiated package relay.
+ */
+extern const char* GETPKGTXNS;
+/**
+ * Contains a package in response to getpkgtxns: the unconfirmed parents of a
+ * transaction, sorted topologically, followed by the transaction itself.
+ */
+extern const char* PKGTXNS;
 }; // namespace NetMsgType
 
 /* Get a vector of all valid message types (see above) */
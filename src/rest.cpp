@@ -25,6 +25,7 @@
 #include <primitives/block.h>
 #include <primitives/transaction.h>
 #include <rpc/blockchain.h>
+#include <rpc/jsonwriter.h>
 #include <rpc/protocol.h>
 #include <rpc/server.h>
 #include <streams.h>
@@ -42,6 +43,7 @@
 #include <univalue.h>
 
 static const size_t MAX_GETUTXOS_OUTPOINTS = 15; //allow a max of 15 outpoints to be queried at once
+static const int MAX_REST_BLOCK_RANGE = 1000; //allow a max of 1000 blocks to be streamed at once
 
 enum class RetFormat {
     UNDEF,
@@ -272,7 +274,7 @@ static bool rest_headers(const std::any& context,
 static bool rest_block(const std::any& context,
                        HTTPRequest* req,
                        const std::string& strURIPart,
-                       bool showTxDetails)
+                       TxVerbosity tx_verbosity)
 {
     if (!CheckWarmup(req))
         return false;
@@ -324,11 +326,10 @@ static bool rest_block(const std::any& context,
     }
 
     case RetFormat::JSON: {
-        UniValue objBlock = blockToJSON(block, tip, pblockindex, showTxDetails);
-        std::string strJSON = objBlock.write() + "\n";
-        req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
-        return true;
+        return req->WriteJSONReply([&](JSONWriter& writer) {
+            blockToJSON(writer, block, tip, pblockindex, tx_verbosity);
+            writer.Raw("\n");
+        });
     }
 
     default: {
@@ -339,12 +340,119 @@ static bool rest_block(const std::any& context,
 
 static bool rest_block_extended(const std::any& context, HTTPRequest* req, const std::string& strURIPart)
 {
-    return rest_block(context, req, strURIPart, true);
+    return rest_block(context, req, strURIPart, TxVerbosity::SHOW_DETAILS);
 }
 
 static bool rest_block_notxdetails(const std::any& context, HTTPRequest* req, const std::string& strURIPart)
 {
-    return rest_block(context, req, strURIPart, false);
+    return rest_block(context, req, strURIPart, TxVerbosity::SHOW_TXID);
+}
+
+static bool rest_block_prevouts(const std::any& context, HTTPRequest* req, const std::string& strURIPart)
+{
+    return rest_block(context, req, strURIPart, TxVerbosity::SHOW_DETAILS_AND_PREVOUT);
+}
+
+static bool rest_block_range(const std::any& context,
+                             HTTPRequest* req,
+                             const std::string& strURIPart,
+                             bool with_undo)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    if (rf != RetFormat::BINARY && rf != RetFormat::HEX)
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: .bin, .hex)");
+
+    std::vector<std::string> path;
+    boost::split(path, param, boost::is_any_of("/"));
+    if (path.size() != 2)
+        return RESTERR(req, HTTP_BAD_REQUEST, "No block count specified. Use /rest/blockrange/<height>/<count>.<ext>.");
+
+    int32_t height = -1;
+    if (!ParseInt32(path[0], &height) || height < 0)
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid height: " + SanitizeString(path[0]));
+    int32_t count = 0;
+    if (!ParseInt32(path[1], &count) || count < 1 || count > MAX_REST_BLOCK_RANGE)
+        return RESTERR(req, HTTP_BAD_REQUEST, "Block count out of range: " + SanitizeString(path[1]));
+
+    std::vector<const CBlockIndex*> blocks;
+    {
+        ChainstateManager* maybe_chainman = GetChainman(context, req);
+        if (!maybe_chainman) return false;
+        ChainstateManager& chainman = *maybe_chainman;
+        LOCK(cs_main);
+        const CChain& active_chain = chainman.ActiveChain();
+        if (height > active_chain.Height())
+            return RESTERR(req, HTTP_NOT_FOUND, "Block height out of range");
+        for (int h = height; h <= active_chain.Height() && blocks.size() < (size_t)count; ++h) {
+            const CBlockIndex* pindex = active_chain[h];
+            if (!(pindex->nStatus & BLOCK_HAVE_DATA) || (with_undo && pindex->pprev && !(pindex->nStatus & BLOCK_HAVE_UNDO)))
+                return RESTERR(req, HTTP_NOT_FOUND, strprintf("Block at height %d not available (pruned data)", h));
+            blocks.push_back(pindex);
+        }
+    }
+
+    // Blocks are read from disk one at a time and sent as they are read, so
+    // the reply is not held in memory. A read error past this point cannot
+    // change the status code any more, so the connection is closed without
+    // finishing the reply instead.
+    req->WriteHeader("Content-Type", rf == RetFormat::BINARY ? "application/octet-stream" : "text/plain");
+    req->StartReply(HTTP_OK);
+
+    std::string chunk;
+    std::vector<uint8_t> data;
+    auto append = [&](Span<const uint8_t> bytes) {
+        if (rf == RetFormat::BINARY) {
+            chunk.append(bytes.begin(), bytes.end());
+        } else {
+            chunk += HexStr(bytes);
+        }
+    };
+    bool complete = true;
+    for (const CBlockIndex* pindex : blocks) {
+        if (!ReadRawBlockFromDisk(data, pindex, Params().MessageStart())) {
+            complete = false;
+            break;
+        }
+        append(data);
+        if (with_undo) {
+            if (pindex->pprev) {
+                if (!ReadRawUndoFromDisk(data, pindex, Params().MessageStart())) {
+                    complete = false;
+                    break;
+                }
+            } else {
+                // The genesis block has no undo data; send an empty CBlockUndo
+                data.assign(1, 0);
+            }
+            append(data);
+        }
+        if (chunk.size() >= HTTP_REPLY_CHUNK_SIZE) {
+            req->WriteReplyChunk(std::move(chunk));
+            chunk.clear();
+        }
+    }
+    if (!complete) {
+        LogPrintf("REST: block range reply aborted, could not read block data\n");
+        req->AbortReply();
+        return false;
+    }
+    if (rf == RetFormat::HEX) chunk += "\n";
+    req->WriteReplyChunk(std::move(chunk));
+    req->EndReply();
+    return true;
+}
+
+static bool rest_block_range_blocks(const std::any& context, HTTPRequest* req, const std::string& strURIPart)
+{
+    return rest_block_range(context, req, strURIPart, false);
+}
+
+static bool rest_block_range_with_undo(const std::any& context, HTTPRequest* req, const std::string& strURIPart)
+{
+    return rest_block_range(context, req, strURIPart, true);
 }
 
 // A bit of a hack - dependency on a function defined in rpc/blockchain.cpp
@@ -408,12 +516,10 @@ static bool rest_mempool_contents(const std::any& context, HTTPRequest* req, con
 
     switch (rf) {
     case RetFormat::JSON: {
-        UniValue mempoolObject = MempoolToJSON(*mempool, true);
-
-        std::string strJSON = mempoolObject.write() + "\n";
-        req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
-        return true;
+        return req->WriteJSONReply([&](JSONWriter& writer) {
+            MempoolToJSON(writer, *mempool);
+            writer.Raw("\n");
+        });
     }
     default: {
         return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: json)");
@@ -725,7 +831,10 @@ static const struct {
 } uri_prefixes[] = {
       {"/rest/tx/", rest_tx},
       {"/rest/block/notxdetails/", rest_block_notxdetails},
+      {"/rest/block/prevouts/", rest_block_prevouts},
       {"/rest/block/", rest_block_extended},
+      {"/rest/blockrange/withundo/", rest_block_range_with_undo},
+      {"/rest/blockrange/", rest_block_range_blocks},
       {"/rest/chaininfo", rest_chaininfo},
       {"/rest/mempool/info", rest_mempool_info},
       {"/rest/mempool/contents", rest_mempool_contents},
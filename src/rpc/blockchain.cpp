@@ -26,7 +26,9 @@
 #include <core_io.h>
 #include <hash.h>
 #include <index/blockfilterindex.h>
+#include <index/blockstatsindex.h>
 #include <index/coinstatsindex.h>
+#include <node/blockstats.h>
 #include <node/blockstorage.h>
 #include <node/coinstats.h>
 #include <node/context.h>
@@ -34,8 +36,8 @@
 #include <policy/feerate.h>
 #include <policy/fees.h>
 #include <policy/policy.h>
-#include <policy/rbf.h>
 #include <primitives/transaction.h>
+#include <rpc/jsonwriter.h>
 #include <rpc/server.h>
 #include <rpc/util.h>
 #include <script/descriptor.h>
@@ -208,35 +210,64 @@ UniValue blockheaderToJSON(const CBlockIndex* tip, const CBlockIndex* blockindex
     return result;
 }
 
-UniValue blockToJSON(const CBlock& block, const CBlockIndex* tip, const CBlockIndex* blockindex, bool txDetails)
+/** Block description without its transactions */
+static UniValue blockSummaryToJSON(const CBlock& block, const CBlockIndex* tip, const CBlockIndex* blockindex)
 {
     UniValue result = blockheaderToJSON(tip, blockindex);
 
     result.pushKV("strippedsize", (int)::GetSerializeSize(block, PROTOCOL_VERSION | SERIALIZE_TRANSACTION_NO_WITNESS));
     result.pushKV("size", (int)::GetSerializeSize(block, PROTOCOL_VERSION));
     result.pushKV("weight", (int)::GetBlockWeight(block));
-    UniValue txs(UniValue::VARR);
-    if (txDetails) {
-        CBlockUndo blockUndo;
-        const bool have_undo = !IsBlockPruned(blockindex) && UndoReadFromDisk(blockUndo, blockindex);
-        for (size_t i = 0; i < block.vtx.size(); ++i) {
-            const CTransactionRef& tx = block.vtx.at(i);
-            // coinbase transaction (i == 0) doesn't have undo data
-            const CTxUndo* txundo = (have_undo && i) ? &blockUndo.vtxundo.at(i - 1) : nullptr;
-            UniValue objTx(UniValue::VOBJ);
-            TxToUniv(*tx, uint256(), objTx, true, RPCSerializationFlags(), txundo);
-            txs.push_back(objTx);
-        }
-    } else {
-        for (const CTransactionRef& tx : block.vtx) {
-            txs.push_back(tx->GetHash().GetHex());
-        }
+    return result;
+}
+
+/** Call fn with the JSON description of each transaction of the block, in order */
+static void blockTxsToJSON(const CBlock& block, const CBlockIndex* blockindex, TxVerbosity verbosity, const std::function<void(UniValue&&)>& fn)
+{
+    switch (verbosity) {
+        case TxVerbosity::SHOW_TXID:
+            for (const CTransactionRef& tx : block.vtx) {
+                fn(tx->GetHash().GetHex());
+            }
+            break;
+
+        case TxVerbosity::SHOW_DETAILS:
+        case TxVerbosity::SHOW_DETAILS_AND_PREVOUT:
+            CBlockUndo blockUndo;
+            const bool have_undo = !IsBlockPruned(blockindex) && UndoReadFromDisk(blockUndo, blockindex);
+            for (size_t i = 0; i < block.vtx.size(); ++i) {
+                const CTransactionRef& tx = block.vtx.at(i);
+                // coinbase transaction (i == 0) doesn't have undo data
+                const CTxUndo* txundo = (have_undo && i) ? &blockUndo.vtxundo.at(i - 1) : nullptr;
+                UniValue objTx(UniValue::VOBJ);
+                TxToUniv(*tx, uint256(), objTx, true, RPCSerializationFlags(), txundo, verbosity);
+                fn(std::move(objTx));
+            }
+            break;
     }
+}
+
+UniValue blockToJSON(const CBlock& block, const CBlockIndex* tip, const CBlockIndex* blockindex, TxVerbosity verbosity)
+{
+    UniValue result = blockSummaryToJSON(block, tip, blockindex);
+    UniValue txs(UniValue::VARR);
+    blockTxsToJSON(block, blockindex, verbosity, [&](UniValue&& tx) { txs.push_back(std::move(tx)); });
     result.pushKV("tx", txs);
 
     return result;
 }
 
+void blockToJSON(JSONWriter& writer, const CBlock& block, const CBlockIndex* tip, const CBlockIndex* blockindex, TxVerbosity verbosity)
+{
+    writer.BeginObject();
+    writer.Members(blockSummaryToJSON(block, tip, blockindex));
+    writer.Key("tx");
+    writer.BeginArray();
+    blockTxsToJSON(block, blockindex, verbosity, [&](UniValue&& tx) { writer.Value(tx); });
+    writer.EndArray();
+    writer.EndObject();
+}
+
 static RPCHelpMan getblockcount()
 {
     return RPCHelpMan{"getblockcount",
@@ -489,36 +520,32 @@ static std::vector<RPCResult> MempoolEntryDescription() { return {
     RPCResult{RPCResult::Type::BOOL, "unbroadcast", "Whether this transaction is currently unbroadcast (initial broadcast not yet acknowledged by any peers)"},
 };}
 
-static void entryToJSON(const CTxMemPool& pool, UniValue& info, const CTxMemPoolEntry& e) EXCLUSIVE_LOCKS_REQUIRED(pool.cs)
+static void entryToJSON(UniValue& info, const TxMempoolEntrySnapshot& e)
 {
-    AssertLockHeld(pool.cs);
-
     UniValue fees(UniValue::VOBJ);
-    fees.pushKV("base", ValueFromAmount(e.GetFee()));
-    fees.pushKV("modified", ValueFromAmount(e.GetModifiedFee()));
-    fees.pushKV("ancestor", ValueFromAmount(e.GetModFeesWithAncestors()));
-    fees.pushKV("descendant", ValueFromAmount(e.GetModFeesWithDescendants()));
+    fees.pushKV("base", ValueFromAmount(e.fee));
+    fees.pushKV("modified", ValueFromAmount(e.modified_fee));
+    fees.pushKV("ancestor", ValueFromAmount(e.mod_fees_with_ancestors));
+    fees.pushKV("descendant", ValueFromAmount(e.mod_fees_with_descendants));
     info.pushKV("fees", fees);
 
-    info.pushKV("vsize", (int)e.GetTxSize());
-    info.pushKV("weight", (int)e.GetTxWeight());
-    info.pushKV("fee", ValueFromAmount(e.GetFee()));
-    info.pushKV("modifiedfee", ValueFromAmount(e.GetModifiedFee()));
-    info.pushKV("time", count_seconds(e.GetTime()));
-    info.pushKV("height", (int)e.GetHeight());
-    info.pushKV("descendantcount", e.GetCountWithDescendants());
-    info.pushKV("descendantsize", e.GetSizeWithDescendants());
-    info.pushKV("descendantfees", e.GetModFeesWithDescendants());
-    info.pushKV("ancestorcount", e.GetCountWithAncestors());
-    info.pushKV("ancestorsize", e.GetSizeWithAncestors());
-    info.pushKV("ancestorfees", e.GetModFeesWithAncestors());
-    info.pushKV("wtxid", pool.vTxHashes[e.vTxHashesIdx].first.ToString());
-    const CTransaction& tx = e.GetTx();
+    info.pushKV("vsize", (int)e.vsize);
+    info.pushKV("weight", (int)e.weight);
+    info.pushKV("fee", ValueFromAmount(e.fee));
+    info.pushKV("modifiedfee", ValueFromAmount(e.modified_fee));
+    info.pushKV("time", count_seconds(e.time));
+    info.pushKV("height", (int)e.height);
+    info.pushKV("descendantcount", e.count_with_descendants);
+    info.pushKV("descendantsize", e.size_with_descendants);
+    info.pushKV("descendantfees", e.mod_fees_with_descendants);
+    info.pushKV("ancestorcount", e.count_with_ancestors);
+    info.pushKV("ancestorsize", e.size_with_ancestors);
+    info.pushKV("ancestorfees", e.mod_fees_with_ancestors);
+    info.pushKV("wtxid", e.tx->GetWitnessHash().ToString());
     std::set<std::string> setDepends;
-    for (const CTxIn& txin : tx.vin)
+    for (const uint256& parent : e.parents)
     {
-        if (pool.exists(txin.prevout.hash))
-            setDepends.insert(txin.prevout.hash.ToString());
+        setDepends.insert(parent.ToString());
     }
 
     UniValue depends(UniValue::VARR);
@@ -530,25 +557,32 @@ static void entryToJSON(const CTxMemPool& pool, UniValue& info, const CTxMemPool
     info.pushKV("depends", depends);
 
     UniValue spent(UniValue::VARR);
-    const CTxMemPool::txiter& it = pool.mapTx.find(tx.GetHash());
-    const CTxMemPoolEntry::Children& children = it->GetMemPoolChildrenConst();
-    for (const CTxMemPoolEntry& child : children) {
-        spent.push_back(child.GetTx().GetHash().ToString());
+    for (const uint256& child : e.children) {
+        spent.push_back(child.ToString());
     }
 
     info.pushKV("spentby", spent);
+    info.pushKV("bip125-replaceable", e.bip125_replaceable);
+    info.pushKV("unbroadcast", e.unbroadcast);
+}
 
-    // Add opt-in RBF status
-    bool rbfStatus = false;
-    RBFTransactionState rbfState = IsRBFOptIn(tx, pool);
-    if (rbfState == RBFTransactionState::UNKNOWN) {
-        throw JSONRPCError(RPC_MISC_ERROR, "Transaction is not in mempool");
-    } else if (rbfState == RBFTransactionState::REPLACEABLE_BIP125) {
-        rbfStatus = true;
-    }
+static void entryToJSON(const CTxMemPool& pool, UniValue& info, const CTxMemPoolEntry& e) EXCLUSIVE_LOCKS_REQUIRED(pool.cs)
+{
+    AssertLockHeld(pool.cs);
+    entryToJSON(info, pool.GetEntrySnapshot(e));
+}
 
-    info.pushKV("bip125-replaceable", rbfStatus);
-    info.pushKV("unbroadcast", pool.IsUnbroadcastTx(tx.GetHash()));
+/** Call fn with the txid and JSON description of each entry of a mempool snapshot */
+static void MempoolEntriesToJSON(const CTxMemPool& pool, const std::function<void(const uint256&, UniValue&&)>& fn)
+{
+    // Serialize a snapshot, so the mempool is not locked while the
+    // (potentially large) result is being built.
+    const std::shared_ptr<const MempoolSnapshot> snapshot = pool.GetSnapshot();
+    for (const auto& e : *snapshot) {
+        UniValue info(UniValue::VOBJ);
+        entryToJSON(info, *e);
+        fn(e->tx->GetHash(), std::move(info));
+    }
 }
 
 UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose, bool include_mempool_sequence)
@@ -557,17 +591,13 @@ UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose, bool include_mempoo
         if (include_mempool_sequence) {
             throw JSONRPCError(RPC_INVALID_PARAMETER, "Verbose results cannot contain mempool sequence values.");
         }
-        LOCK(pool.cs);
         UniValue o(UniValue::VOBJ);
-        for (const CTxMemPoolEntry& e : pool.mapTx) {
-            const uint256& hash = e.GetTx().GetHash();
-            UniValue info(UniValue::VOBJ);
-            entryToJSON(pool, info, e);
+        MempoolEntriesToJSON(pool, [&](const uint256& hash, UniValue&& info) {
             // Mempool has unique entries so there is no advantage in using
             // UniValue::pushKV, which checks if the key already exists in O(N).
             // UniValue::__pushKV is used instead which currently is O(1).
-            o.__pushKV(hash.ToString(), info);
-        }
+            o.__pushKV(hash.ToString(), std::move(info));
+        });
         return o;
     } else {
         uint64_t mempool_sequence;
@@ -592,6 +622,16 @@ UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose, bool include_mempoo
     }
 }
 
+void MempoolToJSON(JSONWriter& writer, const CTxMemPool& pool)
+{
+    writer.BeginObject();
+    MempoolEntriesToJSON(pool, [&](const uint256& hash, UniValue&& info) {
+        writer.Key(hash.ToString());
+        writer.Value(info);
+    });
+    writer.EndObject();
+}
+
 static RPCHelpMan getrawmempool()
 {
     return RPCHelpMan{"getrawmempool",
@@ -637,7 +677,12 @@ static RPCHelpMan getrawmempool()
         include_mempool_sequence = request.params[1].get_bool();
     }
 
-    return MempoolToJSON(EnsureAnyMemPool(request.context), fVerbose, include_mempool_sequence);
+    const CTxMemPool& mempool = EnsureAnyMemPool(request.context);
+    if (fVerbose && !include_mempool_sequence && request.result_writer) {
+        *request.result_writer = [&mempool](JSONWriter& writer) { MempoolToJSON(writer, mempool); };
+        return NullUniValue;
+    }
+    return MempoolToJSON(mempool, fVerbose, include_mempool_sequence);
 },
     };
 }
@@ -939,10 +984,11 @@ static RPCHelpMan getblock()
     return RPCHelpMan{"getblock",
                 "\nIf verbosity is 0, returns a string that is serialized, hex-encoded data for block 'hash'.\n"
                 "If verbosity is 1, returns an Object with information about block <hash>.\n"
-                "If verbosity is 2, returns an Object with information about block <hash> and information about each transaction. \n",
+                "If verbosity is 2, returns an Object with information about block <hash> and information about each transaction.\n"
+                "If verbosity is 3, returns an Object with information about block <hash> and information about each transaction, including prevout information for inputs (only for unpruned blocks in the current best chain).\n",
                 {
                     {"blockhash", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "The block hash"},
-                    {"verbosity|verbose", RPCArg::Type::NUM, RPCArg::Default{1}, "0 for hex-encoded data, 1 for a json object, and 2 for json object with transaction data"},
+                    {"verbosity|verbose", RPCArg::Type::NUM, RPCArg::Default{1}, "0 for hex-encoded data, 1 for a json object, 2 for json object with transaction data, and 3 for JSON object with transaction data including prevout information for inputs"},
                 },
                 {
                     RPCResult{"for verbosity = 0",
@@ -984,6 +1030,40 @@ static RPCHelpMan getblock()
                         }},
                     }},
                 }},
+                    RPCResult{"for verbosity = 3",
+                RPCResult::Type::OBJ, "", "",
+                {
+                    {RPCResult::Type::ELISION, "", "Same output as verbosity = 2"},
+                    {RPCResult::Type::ARR, "tx", "",
+                    {
+                        {RPCResult::Type::OBJ, "", "",
+                        {
+                            {RPCResult::Type::ARR, "vin", "",
+                            {
+                                {RPCResult::Type::OBJ, "", "",
+                                {
+                                    {RPCResult::Type::ELISION, "", "The same output as verbosity = 2"},
+                                    {RPCResult::Type::OBJ, "prevout", "(Only if undo information is available)",
+                                    {
+                                        {RPCResult::Type::BOOL, "generated", "Coinbase or not"},
+                                        {RPCResult::Type::NUM, "height", "The height of the prevout"},
+                                        {RPCResult::Type::STR_AMOUNT, "value", "The value in " + CURRENCY_UNIT},
+                                        {RPCResult::Type::OBJ, "scriptPubKey", "",
+                                        {
+                                            {RPCResult::Type::STR, "asm", ""},
+                                            {RPCResult::Type::STR_HEX, "hex", ""},
+                                            {RPCResult::Type::NUM, "reqSigs", /* optional */ true, "(DEPRECATED, returned only if config option -deprecatedrpc=addresses is passed) Number of required signatures"},
+                                            {RPCResult::Type::STR, "type", "The type, eg pubkeyhash"},
+                                            {RPCResult::Type::STR, "address", /* optional */ true, "bitcoin address (only if a well-defined address exists)"},
+                                            {RPCResult::Type::ARR, "addresses", /* optional */ true, "(DEPRECATED, returned only if config option -deprecatedrpc=addresses is passed) Array of bitcoin addresses",
+                                                {{RPCResult::Type::STR, "address", "bitcoin address"}}},
+                                        }},
+                                    }},
+                                }},
+                            }},
+                        }},
+                    }},
+                }},
         },
                 RPCExamples{
                     HelpExampleCli("getblock", "\"00000000c937983704a73af28acdec37b049d214adbda81d7e2a3dd146f6ed09\"")
@@ -1026,7 +1106,23 @@ static RPCHelpMan getblock()
         return strHex;
     }
 
-    return blockToJSON(block, tip, pblockindex, verbosity >= 2);
+    TxVerbosity tx_verbosity;
+    if (verbosity == 1) {
+        tx_verbosity = TxVerbosity::SHOW_TXID;
+    } else if (verbosity == 2) {
+        tx_verbosity = TxVerbosity::SHOW_DETAILS;
+    } else {
+        tx_verbosity = TxVerbosity::SHOW_DETAILS_AND_PREVOUT;
+    }
+
+    if (request.result_writer) {
+        auto shared_block = std::make_shared<const CBlock>(std::move(block));
+        *request.result_writer = [shared_block, tip, pblockindex, tx_verbosity](JSONWriter& writer) {
+            blockToJSON(writer, *shared_block, tip, pblockindex, tx_verbosity);
+        };
+        return NullUniValue;
+    }
+    return blockToJSON(block, tip, pblockindex, tx_verbosity);
 },
     };
 }
@@ -1891,77 +1987,22 @@ static RPCHelpMan getchaintxstats()
     };
 }
 
-template<typename T>
-static T CalculateTruncatedMedian(std::vector<T>& scores)
-{
-    size_t size = scores.size();
-    if (size == 0) {
-        return 0;
-    }
-
-    std::sort(scores.begin(), scores.end());
-    if (size % 2 == 0) {
-        return (scores[size / 2 - 1] + scores[size / 2]) / 2;
-    } else {
-        return scores[size / 2];
-    }
-}
-
-void CalculatePercentilesByWeight(CAmount result[NUM_GETBLOCKSTATS_PERCENTILES], std::vector<std::pair<CAmount, int64_t>>& scores, int64_t total_weight)
-{
-    if (scores.empty()) {
-        return;
-    }
-
-    std::sort(scores.begin(), scores.end());
-
-    // 10th, 25th, 50th, 75th, and 90th percentile weight units.
-    const double weights[NUM_GETBLOCKSTATS_PERCENTILES] = {
-        total_weight / 10.0, total_weight / 4.0, total_weight / 2.0, (total_weight * 3.0) / 4.0, (total_weight * 9.0) / 10.0
-    };
-
-    int64_t next_percentile_index = 0;
-    int64_t cumulative_weight = 0;
-    for (const auto& element : scores) {
-        cumulative_weight += element.second;
-        while (next_percentile_index < NUM_GETBLOCKSTATS_PERCENTILES && cumulative_weight >= weights[next_percentile_index]) {
-            result[next_percentile_index] = element.first;
-            ++next_percentile_index;
-        }
-    }
-
-    // Fill any remaining percentiles with the last value.
-    for (int64_t i = next_percentile_index; i < NUM_GETBLOCKSTATS_PERCENTILES; i++) {
-        result[i] = scores.back().first;
-    }
-}
-
 void ScriptPubKeyToUniv(const CScript& scriptPubKey, UniValue& out, bool fIncludeHex)
 {
     ScriptPubKeyToUniv(scriptPubKey, out, fIncludeHex, IsDeprecatedRPCEnabled("addresses"));
 }
 
-void TxToUniv(const CTransaction& tx, const uint256& hashBlock, UniValue& entry, bool include_hex, int serialize_flags, const CTxUndo* txundo)
+void TxToUniv(const CTransaction& tx, const uint256& hashBlock, UniValue& entry, bool include_hex, int serialize_flags, const CTxUndo* txundo, TxVerbosity verbosity)
 {
-    TxToUniv(tx, hashBlock, IsDeprecatedRPCEnabled("addresses"), entry, include_hex, serialize_flags, txundo);
+    TxToUniv(tx, hashBlock, IsDeprecatedRPCEnabled("addresses"), entry, include_hex, serialize_flags, txundo, verbosity);
 }
 
-template<typename T>
-static inline bool SetHasKeys(const std::set<T>& set) {return false;}
-template<typename T, typename Tk, typename... Args>
-static inline bool SetHasKeys(const std::set<T>& set, const Tk& key, const Args&... args)
-{
-    return (set.count(key) != 0) || SetHasKeys(set, args...);
-}
-
-// outpoint (needed for the utxo index) + nHeight + fCoinBase
-static constexpr size_t PER_UTXO_OVERHEAD = sizeof(COutPoint) + sizeof(uint32_t) + sizeof(bool);
-
 static RPCHelpMan getblockstats()
 {
     return RPCHelpMan{"getblockstats",
                 "\nCompute per block statistics for a given window. All amounts are in satoshis.\n"
-                "It won't work for some heights with pruning.\n",
+                "It won't work for some heights with pruning.\n"
+                "The statistics are read from blockstatsindex if it is enabled and has indexed the block.\n",
                 {
                     {"hash_or_height", RPCArg::Type::NUM, RPCArg::Optional::NO, "The block hash or height of the target block", "", {"", "string or numeric"}},
                     {"stats", RPCArg::Type::ARR, RPCArg::DefaultHint{"all values"}, "Values to plot (see result below)",
@@ -2033,151 +2074,50 @@ static RPCHelpMan getblockstats()
         }
     }
 
-    const CBlock block = GetBlockChecked(pindex);
-    const CBlockUndo blockUndo = GetUndoChecked(pindex);
-
     const bool do_all = stats.size() == 0; // Calculate everything if nothing selected (default)
-    const bool do_mediantxsize = do_all || stats.count("mediantxsize") != 0;
-    const bool do_medianfee = do_all || stats.count("medianfee") != 0;
-    const bool do_feerate_percentiles = do_all || stats.count("feerate_percentiles") != 0;
-    const bool loop_inputs = do_all || do_medianfee || do_feerate_percentiles ||
-        SetHasKeys(stats, "utxo_size_inc", "totalfee", "avgfee", "avgfeerate", "minfee", "maxfee", "minfeerate", "maxfeerate");
-    const bool loop_outputs = do_all || loop_inputs || stats.count("total_out");
-    const bool do_calculate_size = do_mediantxsize ||
-        SetHasKeys(stats, "total_size", "avgtxsize", "mintxsize", "maxtxsize", "swtotal_size");
-    const bool do_calculate_weight = do_all || SetHasKeys(stats, "total_weight", "avgfeerate", "swtotal_weight", "avgfeerate", "feerate_percentiles", "minfeerate", "maxfeerate");
-    const bool do_calculate_sw = do_all || SetHasKeys(stats, "swtxs", "swtotal_size", "swtotal_weight");
-
-    CAmount maxfee = 0;
-    CAmount maxfeerate = 0;
-    CAmount minfee = MAX_MONEY;
-    CAmount minfeerate = MAX_MONEY;
-    CAmount total_out = 0;
-    CAmount totalfee = 0;
-    int64_t inputs = 0;
-    int64_t maxtxsize = 0;
-    int64_t mintxsize = MAX_BLOCK_SERIALIZED_SIZE;
-    int64_t outputs = 0;
-    int64_t swtotal_size = 0;
-    int64_t swtotal_weight = 0;
-    int64_t swtxs = 0;
-    int64_t total_size = 0;
-    int64_t total_weight = 0;
-    int64_t utxo_size_inc = 0;
-    std::vector<CAmount> fee_array;
-    std::vector<std::pair<CAmount, int64_t>> feerate_array;
-    std::vector<int64_t> txsize_array;
-
-    for (size_t i = 0; i < block.vtx.size(); ++i) {
-        const auto& tx = block.vtx.at(i);
-        outputs += tx->vout.size();
-
-        CAmount tx_total_out = 0;
-        if (loop_outputs) {
-            for (const CTxOut& out : tx->vout) {
-                tx_total_out += out.nValue;
-                utxo_size_inc += GetSerializeSize(out, PROTOCOL_VERSION) + PER_UTXO_OVERHEAD;
-            }
-        }
-
-        if (tx->IsCoinBase()) {
-            continue;
-        }
-
-        inputs += tx->vin.size(); // Don't count coinbase's fake input
-        total_out += tx_total_out; // Don't count coinbase reward
-
-        int64_t tx_size = 0;
-        if (do_calculate_size) {
-
-            tx_size = tx->GetTotalSize();
-            if (do_mediantxsize) {
-                txsize_array.push_back(tx_size);
-            }
-            maxtxsize = std::max(maxtxsize, tx_size);
-            mintxsize = std::min(mintxsize, tx_size);
-            total_size += tx_size;
-        }
-
-        int64_t weight = 0;
-        if (do_calculate_weight) {
-            weight = GetTransactionWeight(*tx);
-            total_weight += weight;
-        }
-
-        if (do_calculate_sw && tx->HasWitness()) {
-            ++swtxs;
-            swtotal_size += tx_size;
-            swtotal_weight += weight;
-        }
-
-        if (loop_inputs) {
-            CAmount tx_total_in = 0;
-            const auto& txundo = blockUndo.vtxundo.at(i - 1);
-            for (const Coin& coin: txundo.vprevout) {
-                const CTxOut& prevoutput = coin.out;
 
-                tx_total_in += prevoutput.nValue;
-                utxo_size_inc -= GetSerializeSize(prevoutput, PROTOCOL_VERSION) + PER_UTXO_OVERHEAD;
-            }
-
-            CAmount txfee = tx_total_in - tx_total_out;
-            CHECK_NONFATAL(MoneyRange(txfee));
-            if (do_medianfee) {
-                fee_array.push_back(txfee);
-            }
-            maxfee = std::max(maxfee, txfee);
-            minfee = std::min(minfee, txfee);
-            totalfee += txfee;
-
-            // New feerate uses satoshis per virtual byte instead of per serialized byte
-            CAmount feerate = weight ? (txfee * WITNESS_SCALE_FACTOR) / weight : 0;
-            if (do_feerate_percentiles) {
-                feerate_array.emplace_back(std::make_pair(feerate, weight));
-            }
-            maxfeerate = std::max(maxfeerate, feerate);
-            minfeerate = std::min(minfeerate, feerate);
-        }
+    BlockStats block_stats;
+    if (!g_block_stats_index || !g_block_stats_index->LookUpStats(pindex, block_stats)) {
+        const CBlock block = GetBlockChecked(pindex);
+        const CBlockUndo blockUndo = GetUndoChecked(pindex);
+        block_stats = ComputeBlockStats(block, blockUndo);
     }
 
-    CAmount feerate_percentiles[NUM_GETBLOCKSTATS_PERCENTILES] = { 0 };
-    CalculatePercentilesByWeight(feerate_percentiles, feerate_array, total_weight);
-
     UniValue feerates_res(UniValue::VARR);
     for (int64_t i = 0; i < NUM_GETBLOCKSTATS_PERCENTILES; i++) {
-        feerates_res.push_back(feerate_percentiles[i]);
+        feerates_res.push_back(block_stats.feerate_percentiles[i]);
     }
 
     UniValue ret_all(UniValue::VOBJ);
-    ret_all.pushKV("avgfee", (block.vtx.size() > 1) ? totalfee / (block.vtx.size() - 1) : 0);
-    ret_all.pushKV("avgfeerate", total_weight ? (totalfee * WITNESS_SCALE_FACTOR) / total_weight : 0); // Unit: sat/vbyte
-    ret_all.pushKV("avgtxsize", (block.vtx.size() > 1) ? total_size / (block.vtx.size() - 1) : 0);
+    ret_all.pushKV("avgfee", block_stats.avgfee);
+    ret_all.pushKV("avgfeerate", block_stats.avgfeerate); // Unit: sat/vbyte
+    ret_all.pushKV("avgtxsize", block_stats.avgtxsize);
     ret_all.pushKV("blockhash", pindex->GetBlockHash().GetHex());
     ret_all.pushKV("feerate_percentiles", feerates_res);
     ret_all.pushKV("height", (int64_t)pindex->nHeight);
-    ret_all.pushKV("ins", inputs);
-    ret_all.pushKV("maxfee", maxfee);
-    ret_all.pushKV("maxfeerate", maxfeerate);
-    ret_all.pushKV("maxtxsize", maxtxsize);
-    ret_all.pushKV("medianfee", CalculateTruncatedMedian(fee_array));
+    ret_all.pushKV("ins", block_stats.ins);
+    ret_all.pushKV("maxfee", block_stats.maxfee);
+    ret_all.pushKV("maxfeerate", block_stats.maxfeerate);
+    ret_all.pushKV("maxtxsize", block_stats.maxtxsize);
+    ret_all.pushKV("medianfee", block_stats.medianfee);
     ret_all.pushKV("mediantime", pindex->GetMedianTimePast());
-    ret_all.pushKV("mediantxsize", CalculateTruncatedMedian(txsize_array));
-    ret_all.pushKV("minfee", (minfee == MAX_MONEY) ? 0 : minfee);
-    ret_all.pushKV("minfeerate", (minfeerate == MAX_MONEY) ? 0 : minfeerate);
-    ret_all.pushKV("mintxsize", mintxsize == MAX_BLOCK_SERIALIZED_SIZE ? 0 : mintxsize);
-    ret_all.pushKV("outs", outputs);
+    ret_all.pushKV("mediantxsize", block_stats.mediantxsize);
+    ret_all.pushKV("minfee", block_stats.minfee);
+    ret_all.pushKV("minfeerate", block_stats.minfeerate);
+    ret_all.pushKV("mintxsize", block_stats.mintxsize);
+    ret_all.pushKV("outs", block_stats.outs);
     ret_all.pushKV("subsidy", GetBlockSubsidy(pindex->nHeight, Params().GetConsensus()));
-    ret_all.pushKV("swtotal_size", swtotal_size);
-    ret_all.pushKV("swtotal_weight", swtotal_weight);
-    ret_all.pushKV("swtxs", swtxs);
+    ret_all.pushKV("swtotal_size", block_stats.swtotal_size);
+    ret_all.pushKV("swtotal_weight", block_stats.swtotal_weight);
+    ret_all.pushKV("swtxs", block_stats.swtxs);
     ret_all.pushKV("time", pindex->GetBlockTime());
-    ret_all.pushKV("total_out", total_out);
-    ret_all.pushKV("total_size", total_size);
-    ret_all.pushKV("total_weight", total_weight);
-    ret_all.pushKV("totalfee", totalfee);
-    ret_all.pushKV("txs", (int64_t)block.vtx.size());
-    ret_all.pushKV("utxo_increase", outputs - inputs);
-    ret_all.pushKV("utxo_size_inc", utxo_size_inc);
+    ret_all.pushKV("total_out", block_stats.total_out);
+    ret_all.pushKV("total_size", block_stats.total_size);
+    ret_all.pushKV("total_weight", block_stats.total_weight);
+    ret_all.pushKV("totalfee", block_stats.totalfee);
+    ret_all.pushKV("txs", block_stats.txs);
+    ret_all.pushKV("utxo_increase", block_stats.utxo_increase);
+    ret_all.pushKV("utxo_size_inc", block_stats.utxo_size_inc);
 
     if (do_all) {
         return ret_all;
@@ -175,6 +175,8 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "getmempooldescendants", 1, "verbose" },
     { "bumpfee", 1, "options" },
     { "psbtbumpfee", 1, "options" },
+    { "getlockstats", 0, "count" },
+    { "getlockstats", 1, "reset" },
     { "logging", 0, "include" },
     { "logging", 1, "exclude" },
     { "disconnectnode", 1, "nodeid" },
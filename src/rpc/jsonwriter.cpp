@@ -0,0 +1,214 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <rpc/jsonwriter.h>
+
+#include <util/check.h>
+
+#include <univalue.h>
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+/** Escape sequence for ch, or nullptr if ch is written as is. Matches the
+ * escapes used by UniValue::write(). */
+static const char* JSONEscape(unsigned char ch)
+{
+    static const char* const CONTROL_ESCAPES[0x20] = {
+        "\\u0000", "\\u0001", "\\u0002", "\\u0003", "\\u0004", "\\u0005", "\\u0006", "\\u0007",
+        "\\b", "\\t", "\\n", "\\u000b", "\\f", "\\r", "\\u000e", "\\u000f",
+        "\\u0010", "\\u0011", "\\u0012", "\\u0013", "\\u0014", "\\u0015", "\\u0016", "\\u0017",
+        "\\u0018", "\\u0019", "\\u001a", "\\u001b", "\\u001c", "\\u001d", "\\u001e", "\\u001f",
+    };
+    if (ch < 0x20) return CONTROL_ESCAPES[ch];
+    if (ch == '"') return "\\\"";
+    if (ch == '\\') return "\\\\";
+    if (ch == 0x7f) return "\\u007f";
+    return nullptr;
+}
+
+/*
+ * Word-at-a-time helpers to skip over runs of bytes that need no escaping.
+ * Each test looks at eight bytes at once and reports whether any of them may
+ * need attention; such a word is then handled byte by byte.
+ */
+static constexpr uint64_t SCAN_ONES{0x0101010101010101ULL};
+static constexpr uint64_t SCAN_HIGHS{0x8080808080808080ULL};
+
+/** Nonzero if any byte of w is zero */
+static inline uint64_t HasZeroByte(uint64_t w) { return (w - SCAN_ONES) & ~w & SCAN_HIGHS; }
+/** Nonzero if any byte of w equals c */
+static inline uint64_t HasByte(uint64_t w, uint8_t c) { return HasZeroByte(w ^ (SCAN_ONES * c)); }
+/** Nonzero if any byte of w is less than n (n <= 128) */
+static inline uint64_t HasByteLess(uint64_t w, uint8_t n) { return (w - SCAN_ONES * n) & ~w & SCAN_HIGHS; }
+
+/** Skip the leading bytes of [p, end) that are written as is, in steps of eight */
+static const char* SkipUnescaped(const char* p, const char* end)
+{
+    while (end - p >= 8) {
+        uint64_t w;
+        std::memcpy(&w, p, sizeof(w));
+        if (HasByteLess(w, 0x20) | HasByte(w, '"') | HasByte(w, '\\') | HasByte(w, 0x7f)) break;
+        p += 8;
+    }
+    return p;
+}
+
+void JSONWriteString(std::string_view str, std::string& out)
+{
+    out += '"';
+    const char* run{str.data()};
+    const char* const end{str.data() + str.size()};
+    for (const char* p = run; p < end; ++p) {
+        p = SkipUnescaped(p, end);
+        if (p == end) break;
+        const char* esc = JSONEscape(*p);
+        if (!esc) continue;
+        out.append(run, p);
+        out += esc;
+        run = p + 1;
+    }
+    out.append(run, end);
+    out += '"';
+}
+
+JSONWriter::JSONWriter(size_t flush_size, FlushFn flush)
+    : m_flush_size{flush_size}, m_flush{std::move(flush)} {}
+
+void JSONWriter::Separate()
+{
+    if (m_after_key) {
+        m_after_key = false;
+    } else if (!m_empty.empty()) {
+        if (!m_empty.back()) m_out += ',';
+        m_empty.back() = false;
+    }
+}
+
+void JSONWriter::MaybeFlush()
+{
+    if (m_out.size() >= m_flush_size) m_flush(m_out);
+}
+
+void JSONWriter::BeginObject()
+{
+    Separate();
+    m_out += '{';
+    m_empty.push_back(true);
+}
+
+void JSONWriter::EndObject()
+{
+    CHECK_NONFATAL(!m_empty.empty() && !m_after_key);
+    m_out += '}';
+    m_empty.pop_back();
+    MaybeFlush();
+}
+
+void JSONWriter::BeginArray()
+{
+    Separate();
+    m_out += '[';
+    m_empty.push_back(true);
+}
+
+void JSONWriter::EndArray()
+{
+    CHECK_NONFATAL(!m_empty.empty() && !m_after_key);
+    m_out += ']';
+    m_empty.pop_back();
+    MaybeFlush();
+}
+
+void JSONWriter::Key(std::string_view key)
+{
+    CHECK_NONFATAL(!m_empty.empty() && !m_after_key);
+    Separate();
+    JSONWriteString(key, m_out);
+    m_out += ':';
+    m_after_key = true;
+}
+
+void JSONWriter::Value(const UniValue& value)
+{
+    Separate();
+    WriteValue(value);
+    MaybeFlush();
+}
+
+void JSONWriter::Members(const UniValue& obj)
+{
+    const std::vector<std::string>& keys = obj.getKeys();
+    const std::vector<UniValue>& values = obj.getValues();
+    for (size_t i = 0; i < keys.size(); ++i) {
+        Key(keys[i]);
+        Value(values[i]);
+    }
+}
+
+void JSONWriter::Raw(std::string_view json)
+{
+    m_out += json;
+}
+
+std::string JSONWriter::Release()
+{
+    return std::exchange(m_out, {});
+}
+
+void JSONWriter::WriteValue(const UniValue& value)
+{
+    switch (value.getType()) {
+    case UniValue::VNULL:
+        m_out += "null";
+        break;
+    case UniValue::VOBJ: {
+        const std::vector<std::string>& keys = value.getKeys();
+        const std::vector<UniValue>& values = value.getValues();
+        m_out += '{';
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (i) m_out += ',';
+            JSONWriteString(keys[i], m_out);
+            m_out += ':';
+            WriteValue(values[i]);
+            MaybeFlush();
+        }
+        m_out += '}';
+        break;
+    }
+    case UniValue::VARR: {
+        const std::vector<UniValue>& values = value.getValues();
+        m_out += '[';
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (i) m_out += ',';
+            WriteValue(values[i]);
+            MaybeFlush();
+        }
+        m_out += ']';
+        break;
+    }
+    case UniValue::VSTR:
+        JSONWriteString(value.get_str(), m_out);
+        break;
+    case UniValue::VNUM:
+        m_out += value.getValStr();
+        break;
+    case UniValue::VBOOL:
+        m_out += value.isTrue() ? "true" : "false";
+        break;
+    }
+}
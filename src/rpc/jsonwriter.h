@@ -0,0 +1,77 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_RPC_JSONWRITER_H
+#define BITCOIN_RPC_JSONWRITER_H
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class UniValue;
+
+/**
+ * Incremental writer for compact JSON, producing the same output as
+ * UniValue::write() without the whole document having to be built as a
+ * UniValue first. Objects and arrays are opened and closed explicitly, so a
+ * large result can be written one element at a time.
+ *
+ * Output is collected in a buffer that is handed to the flush function
+ * whenever it has grown to at least flush_size bytes after a complete
+ * element was written. Whatever was not flushed yet is returned by Release().
+ */
+class JSONWriter
+{
+public:
+    //! Called with the output collected so far; must consume and clear it
+    using FlushFn = std::function<void(std::string& out)>;
+
+    JSONWriter(size_t flush_size, FlushFn flush);
+
+    void BeginObject();
+    void EndObject();
+    void BeginArray();
+    void EndArray();
+    /** Write the key of the next member of the current object. */
+    void Key(std::string_view key);
+    /** Write a value into the current array, or as the value of the last key. */
+    void Value(const UniValue& value);
+    /** Write all members of the object obj into the current object. */
+    void Members(const UniValue& obj);
+    /** Append text that is already serialized, e.g. a reply envelope. */
+    void Raw(std::string_view json);
+    /** Return the output that has not been flushed yet. */
+    std::string Release();
+
+private:
+    const size_t m_flush_size;
+    const FlushFn m_flush;
+    std::string m_out;
+    //! Whether each open object or array has no elements yet
+    std::vector<bool> m_empty;
+    //! Whether a key was written that still needs its value
+    bool m_after_key{false};
+
+    void Separate();
+    void WriteValue(const UniValue& value);
+    void MaybeFlush();
+};
+
+/** Append str to out as a quoted and escaped JSON string. */
+void JSONWriteString(std::string_view str, std::string& out);
+
+#endif // BITCOIN_RPC_JSONWRITER_H
@@ -17,6 +17,7 @@
 
 #include <httpserver.h>
 #include <index/blockfilterindex.h>
+#include <index/blockstatsindex.h>
 #include <index/coinstatsindex.h>
 #include <index/txindex.h>
 #include <interfaces/chain.h>
@@ -31,10 +32,12 @@
 #include <rpc/util.h>
 #include <scheduler.h>
 #include <script/descriptor.h>
+#include <sync.h>
 #include <util/check.h>
 #include <util/message.h> // For MessageSign(), MessageVerify()
 #include <util/strencodings.h>
 #include <util/system.h>
+#include <validationinterface.h>
 
 #include <stdint.h>
 #include <tuple>
@@ -625,6 +628,111 @@ static RPCHelpMan logging()
     };
 }
 
+static RPCHelpMan getvalidationqueueinfo()
+{
+    return RPCHelpMan{"getvalidationqueueinfo",
+                "Returns the number of validation notifications (connected blocks, mempool changes, ...) waiting to be processed by\n"
+                "subscribers such as wallets, indexes and ZMQ. Each subscriber has its own queue.\n",
+                {},
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::NUM, "subscribers", "Number of registered subscribers"},
+                        {RPCResult::Type::NUM, "callbacks_pending", "Notifications waiting to be processed, summed over all subscribers"},
+                        {RPCResult::Type::NUM, "max_callbacks_pending", "Notifications waiting to be processed by the subscriber that is furthest behind"},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getvalidationqueueinfo", "")
+            + HelpExampleRpc("getvalidationqueueinfo", "")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const ValidationQueueStats stats{GetMainSignals().GetQueueStats()};
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("subscribers", (uint64_t)stats.subscribers);
+    obj.pushKV("callbacks_pending", (uint64_t)stats.callbacks_pending);
+    obj.pushKV("max_callbacks_pending", (uint64_t)stats.max_callbacks_pending);
+    return obj;
+},
+    };
+}
+
+static RPCHelpMan getlockstats()
+{
+    return RPCHelpMan{"getlockstats",
+                "Returns contention statistics per lock site, collected while the node runs with -lockprofiling.\n"
+                "Sites are sorted by total time spent waiting for the lock.\n",
+                {
+                    {"count", RPCArg::Type::NUM, RPCArg::Default{20}, "Number of lock sites to return, 0 for all"},
+                    {"reset", RPCArg::Type::BOOL, RPCArg::Default{false}, "Reset the statistics after reading them"},
+                },
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::BOOL, "enabled", "Whether statistics are being collected"},
+                        {RPCResult::Type::ARR, "locks", "",
+                        {
+                            {RPCResult::Type::OBJ, "", "",
+                            {
+                                {RPCResult::Type::STR, "name", "The locked expression"},
+                                {RPCResult::Type::STR, "file", "Source file of the lock site"},
+                                {RPCResult::Type::NUM, "line", "Source line of the lock site"},
+                                {RPCResult::Type::NUM, "acquisitions", "Number of times the lock was taken"},
+                                {RPCResult::Type::NUM, "contentions", "Number of times the lock was held by another thread when requested"},
+                                {RPCResult::Type::NUM, "wait_us", "Total time spent waiting for the lock, in microseconds"},
+                                {RPCResult::Type::NUM, "max_wait_us", "Longest single wait for the lock, in microseconds"},
+                                {RPCResult::Type::NUM, "hold_us", "Total time the lock was held, in microseconds, including condition variable waits"},
+                            }},
+                        }},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getlockstats", "")
+            + HelpExampleCli("getlockstats", "0 true")
+            + HelpExampleRpc("getlockstats", "")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const int count{request.params[0].isNull() ? 20 : request.params[0].get_int()};
+    if (count < 0) throw JSONRPCError(RPC_INVALID_PARAMETER, "count must be non-negative");
+
+    struct Stats {
+        const LockSite* site;
+        uint64_t acquisitions, contentions, wait_ns, max_wait_ns, hold_ns;
+    };
+    std::vector<Stats> sites;
+    ForEachLockSite([&sites](const LockSite& site) {
+        const uint64_t acquisitions{site.acquisitions.load()};
+        const uint64_t contentions{site.contentions.load()};
+        if (acquisitions == 0 && contentions == 0) return;
+        sites.push_back({&site, acquisitions, contentions, site.wait_ns.load(), site.max_wait_ns.load(), site.hold_ns.load()});
+    });
+    if (!request.params[1].isNull() && request.params[1].get_bool()) ResetLockSites();
+
+    std::sort(sites.begin(), sites.end(), [](const Stats& a, const Stats& b) { return a.wait_ns > b.wait_ns; });
+    if (count > 0 && sites.size() > (size_t)count) sites.resize(count);
+
+    UniValue locks(UniValue::VARR);
+    for (const Stats& stats : sites) {
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("name", stats.site->name);
+        obj.pushKV("file", stats.site->file);
+        obj.pushKV("line", stats.site->line);
+        obj.pushKV("acquisitions", stats.acquisitions);
+        obj.pushKV("contentions", stats.contentions);
+        obj.pushKV("wait_us", stats.wait_ns / 1000);
+        obj.pushKV("max_wait_us", stats.max_wait_ns / 1000);
+        obj.pushKV("hold_us", stats.hold_ns / 1000);
+        locks.push_back(obj);
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("enabled", g_lock_profiling.load());
+    result.pushKV("locks", locks);
+    return result;
+},
+    };
+}
+
 static RPCHelpMan echo(const std::string& name)
 {
     return RPCHelpMan{name,
@@ -746,6 +854,10 @@ static RPCHelpMan getindexinfo()
         result.pushKVs(SummaryToJSON(g_coin_stats_index->GetSummary(), index_name));
     }
 
+    if (g_block_stats_index) {
+        result.pushKVs(SummaryToJSON(g_block_stats_index->GetSummary(), index_name));
+    }
+
     ForEachBlockFilterIndex([&result, &index_name](const BlockFilterIndex& index) {
         result.pushKVs(SummaryToJSON(index.GetSummary(), index_name));
     });
@@ -763,6 +875,8 @@ static const CRPCCommand commands[] =
   //  --------------------- ------------------------
     { "control",            &getmemoryinfo,           },
     { "control",            &logging,                 },
+    { "control",            &getvalidationqueueinfo,  },
+    { "control",            &getlockstats,            },
     { "util",               &validateaddress,         },
     { "util",               &createmultisig,          },
     { "util",               &deriveaddresses,         },
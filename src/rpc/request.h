@@ -19,10 +19,13 @@
 #define BITCOIN_RPC_REQUEST_H
 
 #include <any>
+#include <functional>
 #include <string>
 
 #include <univalue.h>
 
+class JSONWriter;
+
 UniValue JSONRPCRequestObj(const std::string& strMethod, const UniValue& params, const UniValue& id);
 UniValue JSONRPCReplyObj(const UniValue& result, const UniValue& error, const UniValue& id);
 std::string JSONRPCReply(const UniValue& result, const UniValue& error, const UniValue& id);
@@ -37,6 +40,9 @@ void DeleteAuthCookie();
 /** Parse JSON-RPC batch reply into a vector */
 std::vector<UniValue> JSONRPCProcessBatchReply(const UniValue& in);
 
+/** Writes the result of an RPC call, see JSONRPCRequest::result_writer. */
+using JSONResultWriter = std::function<void(JSONWriter& writer)>;
+
 class JSONRPCRequest
 {
 public:
@@ -48,6 +54,11 @@ public:
     std::string authUser;
     std::string peerAddr;
     std::any context;
+    //! Set by callers that can stream the result. Handlers with large results
+    //! may then store a function here that writes the result, and return
+    //! NullUniValue instead of building it. The function is called after the
+    //! handler has returned, so it must not rely on locks taken by the handler.
+    JSONResultWriter* result_writer{nullptr};
 
     void parse(const UniValue& valRequest);
 };
@@ -27,7 +27,10 @@
 #include <boost/algorithm/string/split.hpp>
 #include <boost/signals2/signal.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <condition_variable>
 #include <memory> // for unique_ptr
 #include <mutex>
 #include <unordered_map>
@@ -391,13 +394,58 @@ static UniValue JSONRPCExecOne(JSONRPCRequest jreq, const UniValue& req)
     return rpc_result;
 }
 
-std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq)
+UniValue JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq, int max_parallel, const RPCTaskRunner& run_task)
 {
     UniValue ret(UniValue::VARR);
-    for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++)
-        ret.push_back(JSONRPCExecOne(jreq, vReq[reqIdx]));
+    const size_t num_requests = vReq.size();
 
-    return ret.write() + "\n";
+    if (max_parallel <= 1 || num_requests <= 1 || !run_task) {
+        for (unsigned int reqIdx = 0; reqIdx < num_requests; reqIdx++)
+            ret.push_back(JSONRPCExecOne(jreq, vReq[reqIdx]));
+        return ret;
+    }
+
+    // Entries are claimed one at a time by the calling thread and by any
+    // helper task that gets to run. The state is shared, because a helper
+    // may only start after the batch has completed; it then finds nothing
+    // left to claim and never touches jreq or vReq.
+    struct BatchState {
+        const JSONRPCRequest& jreq;
+        const UniValue& requests;
+        std::vector<UniValue> results;
+        std::atomic<size_t> next{0};
+        Mutex cs;
+        std::condition_variable cond;
+        size_t done GUARDED_BY(cs){0};
+
+        BatchState(const JSONRPCRequest& jreq_in, const UniValue& requests_in)
+            : jreq(jreq_in), requests(requests_in), results(requests_in.size()) {}
+    };
+    auto state = std::make_shared<BatchState>(jreq, vReq);
+    auto work = [state, num_requests] {
+        size_t idx;
+        while ((idx = state->next++) < num_requests) {
+            state->results[idx] = JSONRPCExecOne(state->jreq, state->requests[idx]);
+            LOCK(state->cs);
+            if (++state->done == num_requests) state->cond.notify_all();
+        }
+    };
+
+    const size_t num_helpers = std::min<size_t>(max_parallel - 1, num_requests - 1);
+    for (size_t i = 0; i < num_helpers; ++i) {
+        if (!run_task(work)) break;
+    }
+    work();
+    {
+        WAIT_LOCK(state->cs, lock);
+        while (state->done != num_requests)
+            state->cond.wait(lock);
+    }
+
+    for (UniValue& result : state->results) {
+        ret.push_back(std::move(result));
+    }
+    return ret;
 }
 
 /**
@@ -185,7 +185,18 @@ extern CRPCTable tableRPC;
 void StartRPC();
 void InterruptRPC();
 void StopRPC();
-std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq);
+
+/** Schedule a task on another thread. Returns false if the task could not be scheduled. */
+typedef std::function<bool(std::function<void()>)> RPCTaskRunner;
+
+/**
+ * Execute a JSON-RPC batch and return the replies in request order.
+ *
+ * If max_parallel is larger than one, up to max_parallel - 1 helper tasks are
+ * scheduled through run_task, and they execute batch entries concurrently with
+ * the calling thread. Entries are then not necessarily executed in order.
+ */
+UniValue JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq, int max_parallel = 1, const RPCTaskRunner& run_task = nullptr);
 
 // Retrieves any serialization flags requested in command line argument
 int RPCSerializationFlags();
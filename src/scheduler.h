@@ -22,9 +22,15 @@
 #include <list>
 #include <map>
 #include <thread>
+#include <vector>
 
 #include <sync.h>
 
+/** Default number of threads servicing the node's scheduler */
+static constexpr int DEFAULT_SCHEDULER_THREADS{1};
+/** Maximum number of threads servicing the node's scheduler */
+static constexpr int MAX_SCHEDULER_THREADS{16};
+
 /**
  * Simple class for background tasks that should be run
  * periodically or once "after a while"
@@ -49,6 +55,8 @@ public:
     ~CScheduler();
 
     std::thread m_service_thread;
+    //! Additional threads running serviceQueue, joined together with m_service_thread
+    std::vector<std::thread> m_extra_service_threads;
 
     typedef std::function<void()> Function;
 
@@ -86,14 +94,14 @@ public:
     {
         WITH_LOCK(newTaskMutex, stopRequested = true);
         newTaskScheduled.notify_all();
-        if (m_service_thread.joinable()) m_service_thread.join();
+        JoinServiceThreads();
     }
     /** Tell any threads running serviceQueue to stop when there is no work left to be done */
     void StopWhenDrained()
     {
         WITH_LOCK(newTaskMutex, stopWhenEmpty = true);
         newTaskScheduled.notify_all();
-        if (m_service_thread.joinable()) m_service_thread.join();
+        JoinServiceThreads();
     }
 
     /**
@@ -114,6 +122,14 @@ private:
     bool stopRequested GUARDED_BY(newTaskMutex){false};
     bool stopWhenEmpty GUARDED_BY(newTaskMutex){false};
     bool shouldStop() const EXCLUSIVE_LOCKS_REQUIRED(newTaskMutex) { return stopRequested || (stopWhenEmpty && taskQueue.empty()); }
+    void JoinServiceThreads()
+    {
+        if (m_service_thread.joinable()) m_service_thread.join();
+        for (auto& thread : m_extra_service_threads) {
+            if (thread.joinable()) thread.join();
+        }
+        m_extra_service_threads.clear();
+    }
 };
 
 /**
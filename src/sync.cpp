@@ -35,6 +35,54 @@
 #include <utility>
 #include <vector>
 
+std::atomic<bool> g_lock_profiling{false};
+
+namespace {
+/** All lock sites reached so far. Uses a plain std::mutex, as taking a LOCK here would recurse. */
+struct LockSiteRegistry {
+    std::mutex mutex;
+    std::vector<LockSite*> sites;
+};
+
+LockSiteRegistry& GetLockSiteRegistry()
+{
+    // Function-local so that it is ready for locks taken during static initialization
+    static LockSiteRegistry registry;
+    return registry;
+}
+} // namespace
+
+LockSite::LockSite(const char* name_in, const char* file_in, int line_in) : name(name_in), file(file_in), line(line_in)
+{
+    LockSiteRegistry& registry = GetLockSiteRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.sites.push_back(this);
+}
+
+void ForEachLockSite(const std::function<void(const LockSite&)>& f)
+{
+    std::vector<LockSite*> sites;
+    {
+        LockSiteRegistry& registry = GetLockSiteRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        sites = registry.sites;
+    }
+    for (const LockSite* site : sites) f(*site);
+}
+
+void ResetLockSites()
+{
+    LockSiteRegistry& registry = GetLockSiteRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (LockSite* site : registry.sites) {
+        site->acquisitions = 0;
+        site->contentions = 0;
+        site->wait_ns = 0;
+        site->max_wait_ns = 0;
+        site->hold_ns = 0;
+    }
+}
+
 #ifdef DEBUG_LOCKCONTENTION
 #if !defined(HAVE_THREAD_LOCAL)
 static_assert(false, "thread_local is not supported");
@@ -21,8 +21,13 @@
 #include <threadsafety.h>
 #include <util/macros.h>
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
+#include <functional>
 #include <mutex>
+#include <optional>
 #include <string>
 #include <thread>
 
@@ -142,14 +147,89 @@ typedef AnnotatedMixin<std::mutex> Mutex;
 void PrintLockContention(const char* pszName, const char* pszFile, int nLine);
 #endif
 
+/**
+ * Contention statistics of a single LOCK, LOCK2, WAIT_LOCK or TRY_LOCK site.
+ * They are only collected while g_lock_profiling is set (-lockprofiling), so
+ * that otherwise the cost is a relaxed atomic load per lock.
+ */
+struct LockSite {
+    const char* const name;
+    const char* const file;
+    const int line;
+    std::atomic<uint64_t> acquisitions{0}; //!< times the lock was taken
+    std::atomic<uint64_t> contentions{0};  //!< times the lock was held by another thread when it was requested
+    std::atomic<uint64_t> wait_ns{0};      //!< total time spent waiting for the lock
+    std::atomic<uint64_t> max_wait_ns{0};  //!< longest single wait for the lock
+    std::atomic<uint64_t> hold_ns{0};      //!< total time the lock was held, including condition variable waits
+
+    LockSite(const char* name_in, const char* file_in, int line_in);
+
+    void Acquired(bool contended, std::chrono::nanoseconds wait)
+    {
+        acquisitions.fetch_add(1, std::memory_order_relaxed);
+        if (!contended) return;
+        const uint64_t wait_count = wait.count();
+        contentions.fetch_add(1, std::memory_order_relaxed);
+        wait_ns.fetch_add(wait_count, std::memory_order_relaxed);
+        uint64_t max_wait = max_wait_ns.load(std::memory_order_relaxed);
+        while (wait_count > max_wait && !max_wait_ns.compare_exchange_weak(max_wait, wait_count, std::memory_order_relaxed)) {}
+    }
+
+    void Released(std::chrono::nanoseconds held)
+    {
+        hold_ns.fetch_add(held.count(), std::memory_order_relaxed);
+    }
+};
+
+/** Whether lock sites collect contention statistics */
+extern std::atomic<bool> g_lock_profiling;
+/** Call f for every lock site that has been reached so far */
+void ForEachLockSite(const std::function<void(const LockSite&)>& f);
+/** Reset the statistics of all lock sites */
+void ResetLockSites();
+
+/** The LockSite of the current source location, created the first time it is reached */
+#define LOCK_SITE(cs) ([]() -> LockSite& { static LockSite site{#cs, __FILE__, __LINE__}; return site; }())
+
 /** Wrapper around std::unique_lock style lock for Mutex. */
 template <typename Mutex, typename Base = typename Mutex::UniqueLock>
 class SCOPED_LOCKABLE UniqueLock : public Base
 {
 private:
-    void Enter(const char* pszName, const char* pszFile, int nLine)
+    LockSite* m_site{nullptr};
+    //! When the lock was taken, if it was taken while profiling
+    std::optional<std::chrono::steady_clock::time_point> m_locked_at;
+
+    void ProfiledLock(const char* pszName, const char* pszFile, int nLine)
     {
-        EnterCritical(pszName, pszFile, nLine, Base::mutex());
+        if (Base::try_lock()) {
+            m_locked_at = std::chrono::steady_clock::now();
+            m_site->Acquired(false, {});
+            return;
+        }
+#ifdef DEBUG_LOCKCONTENTION
+        PrintLockContention(pszName, pszFile, nLine);
+#endif
+        const auto start = std::chrono::steady_clock::now();
+        Base::lock();
+        m_locked_at = std::chrono::steady_clock::now();
+        m_site->Acquired(true, *m_locked_at - start);
+    }
+
+    void ProfiledRelease()
+    {
+        if (!m_locked_at) return;
+        m_site->Released(std::chrono::steady_clock::now() - *m_locked_at);
+        m_locked_at.reset();
+    }
+
+    //! Take the lock, recording statistics if profiling
+    void Lock(const char* pszName, const char* pszFile, int nLine)
+    {
+        if (m_site && g_lock_profiling.load(std::memory_order_relaxed)) {
+            ProfiledLock(pszName, pszFile, nLine);
+            return;
+        }
 #ifdef DEBUG_LOCKCONTENTION
         if (!Base::try_lock()) {
             PrintLockContention(pszName, pszFile, nLine);
@@ -160,17 +240,31 @@ private:
 #endif
     }
 
+    void Enter(const char* pszName, const char* pszFile, int nLine)
+    {
+        EnterCritical(pszName, pszFile, nLine, Base::mutex());
+        Lock(pszName, pszFile, nLine);
+    }
+
     bool TryEnter(const char* pszName, const char* pszFile, int nLine)
     {
         EnterCritical(pszName, pszFile, nLine, Base::mutex(), true);
         Base::try_lock();
+        if (m_site && g_lock_profiling.load(std::memory_order_relaxed)) {
+            if (Base::owns_lock()) {
+                m_locked_at = std::chrono::steady_clock::now();
+                m_site->Acquired(false, {});
+            } else {
+                m_site->contentions.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
         if (!Base::owns_lock())
             LeaveCritical();
         return Base::owns_lock();
     }
 
 public:
-    UniqueLock(Mutex& mutexIn, const char* pszName, const char* pszFile, int nLine, bool fTry = false) EXCLUSIVE_LOCK_FUNCTION(mutexIn) : Base(mutexIn, std::defer_lock)
+    UniqueLock(Mutex& mutexIn, const char* pszName, const char* pszFile, int nLine, bool fTry = false, LockSite* site = nullptr) EXCLUSIVE_LOCK_FUNCTION(mutexIn) : Base(mutexIn, std::defer_lock), m_site(site)
     {
         if (fTry)
             TryEnter(pszName, pszFile, nLine);
@@ -178,7 +272,7 @@ public:
             Enter(pszName, pszFile, nLine);
     }
 
-    UniqueLock(Mutex* pmutexIn, const char* pszName, const char* pszFile, int nLine, bool fTry = false) EXCLUSIVE_LOCK_FUNCTION(pmutexIn)
+    UniqueLock(Mutex* pmutexIn, const char* pszName, const char* pszFile, int nLine, bool fTry = false, LockSite* site = nullptr) EXCLUSIVE_LOCK_FUNCTION(pmutexIn) : m_site(site)
     {
         if (!pmutexIn) return;
 
@@ -191,8 +285,10 @@ public:
 
     ~UniqueLock() UNLOCK_FUNCTION()
     {
-        if (Base::owns_lock())
+        if (Base::owns_lock()) {
+            ProfiledRelease();
             LeaveCritical();
+        }
     }
 
     operator bool()
@@ -212,6 +308,7 @@ public:
     public:
         explicit reverse_lock(UniqueLock& _lock, const char* _guardname, const char* _file, int _line) : lock(_lock), file(_file), line(_line) {
             CheckLastCritical((void*)lock.mutex(), lockname, _guardname, _file, _line);
+            lock.ProfiledRelease();
             lock.unlock();
             LeaveCritical();
             lock.swap(templock);
@@ -220,7 +317,7 @@ public:
         ~reverse_lock() {
             templock.swap(lock);
             EnterCritical(lockname.c_str(), file.c_str(), line, lock.mutex());
-            lock.lock();
+            lock.Lock(lockname.c_str(), file.c_str(), line);
         }
 
      private:
@@ -241,12 +338,12 @@ public:
 template<typename MutexArg>
 using DebugLock = UniqueLock<typename std::remove_reference<typename std::remove_pointer<MutexArg>::type>::type>;
 
-#define LOCK(cs) DebugLock<decltype(cs)> PASTE2(criticalblock, __COUNTER__)(cs, #cs, __FILE__, __LINE__)
-#define LOCK2(cs1, cs2)                                               \
-    DebugLock<decltype(cs1)> criticalblock1(cs1, #cs1, __FILE__, __LINE__); \
-    DebugLock<decltype(cs2)> criticalblock2(cs2, #cs2, __FILE__, __LINE__);
-#define TRY_LOCK(cs, name) DebugLock<decltype(cs)> name(cs, #cs, __FILE__, __LINE__, true)
-#define WAIT_LOCK(cs, name) DebugLock<decltype(cs)> name(cs, #cs, __FILE__, __LINE__)
+#define LOCK(cs) DebugLock<decltype(cs)> PASTE2(criticalblock, __COUNTER__)(cs, #cs, __FILE__, __LINE__, false, &LOCK_SITE(cs))
+#define LOCK2(cs1, cs2)                                                                         \
+    DebugLock<decltype(cs1)> criticalblock1(cs1, #cs1, __FILE__, __LINE__, false, &LOCK_SITE(cs1)); \
+    DebugLock<decltype(cs2)> criticalblock2(cs2, #cs2, __FILE__, __LINE__, false, &LOCK_SITE(cs2));
+#define TRY_LOCK(cs, name) DebugLock<decltype(cs)> name(cs, #cs, __FILE__, __LINE__, true, &LOCK_SITE(cs))
+#define WAIT_LOCK(cs, name) DebugLock<decltype(cs)> name(cs, #cs, __FILE__, __LINE__, false, &LOCK_SITE(cs))
 
 #define ENTER_CRITICAL_SECTION(cs)                            \
     {                                                         \
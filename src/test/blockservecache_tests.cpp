@@ -0,0 +1,91 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <blockservecache.h>
+#include <uint256.h>
+
+#include <test/util/setup_common.h>
+
+#include <memory>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(blockservecache_tests, BasicTestingSetup)
+
+static BlockServeCache::Data MakeData(size_t size)
+{
+    return std::make_shared<const SharedPayload>(std::vector<unsigned char>(size, 0x42));
+}
+
+BOOST_AUTO_TEST_CASE(encodings_are_separate)
+{
+    BlockServeCache cache{1 << 20};
+    const uint256 hash{InsecureRand256()};
+    const auto witness_data{MakeData(1000)};
+    const auto stripped_data{MakeData(800)};
+
+    BOOST_CHECK(!cache.Get(hash, true));
+    cache.Insert(hash, true, witness_data);
+    BOOST_CHECK(cache.Get(hash, true) == witness_data);
+    BOOST_CHECK(!cache.Get(hash, false));
+
+    cache.Insert(hash, false, stripped_data);
+    BOOST_CHECK(cache.Get(hash, false) == stripped_data);
+    BOOST_CHECK_EQUAL(cache.Size(), 2U);
+
+    // Inserting an already cached serialization keeps the existing entry
+    cache.Insert(hash, true, MakeData(10));
+    BOOST_CHECK(cache.Get(hash, true) == witness_data);
+    BOOST_CHECK_EQUAL(cache.Size(), 2U);
+}
+
+BOOST_AUTO_TEST_CASE(least_recently_used_eviction)
+{
+    // Room for three 100 kB blocks, but not four
+    BlockServeCache cache{350 * 1000};
+    std::vector<uint256> hashes;
+    for (int i = 0; i < 4; ++i) hashes.push_back(InsecureRand256());
+
+    for (int i = 0; i < 3; ++i) cache.Insert(hashes[i], true, MakeData(100 * 1000));
+    BOOST_CHECK_EQUAL(cache.Size(), 3U);
+
+    // Touch the oldest block so that the second one is evicted instead
+    BOOST_CHECK(cache.Get(hashes[0], true));
+    cache.Insert(hashes[3], true, MakeData(100 * 1000));
+    BOOST_CHECK_EQUAL(cache.Size(), 3U);
+    BOOST_CHECK(cache.Get(hashes[0], true));
+    BOOST_CHECK(!cache.Get(hashes[1], true));
+    BOOST_CHECK(cache.Get(hashes[2], true));
+    BOOST_CHECK(cache.Get(hashes[3], true));
+    BOOST_CHECK(cache.DynamicMemoryUsage() <= 350 * 1000);
+
+    // Data handed out stays valid after its entry is evicted
+    const auto held{cache.Get(hashes[2], true)};
+    for (int i = 0; i < 3; ++i) cache.Insert(InsecureRand256(), true, MakeData(100 * 1000));
+    BOOST_CHECK(!cache.Get(hashes[2], true));
+    BOOST_CHECK_EQUAL(held->data.size(), 100U * 1000);
+
+    // Blocks larger than the whole cache are never added
+    cache.Insert(InsecureRand256(), true, MakeData(400 * 1000));
+    BOOST_CHECK_EQUAL(cache.Size(), 3U);
+
+    BlockServeCache disabled{0};
+    disabled.Insert(hashes[0], true, MakeData(1));
+    BOOST_CHECK(!disabled.Get(hashes[0], true));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,109 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+// Copyright (c) 2021 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <index/blockstatsindex.h>
+#include <node/blockstorage.h>
+#include <streams.h>
+#include <test/util/setup_common.h>
+#include <undo.h>
+#include <util/time.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+
+static BlockStats ComputeStatsFromDisk(const CBlockIndex* block_index)
+{
+    CBlock block;
+    CBlockUndo block_undo;
+    BOOST_REQUIRE(ReadBlockFromDisk(block, block_index, Params().GetConsensus()));
+    if (block_index->nHeight > 0) BOOST_REQUIRE(UndoReadFromDisk(block_undo, block_index));
+    return ComputeBlockStats(block, block_undo);
+}
+
+static std::vector<unsigned char> SerializeStats(const BlockStats& stats)
+{
+    CDataStream ss{SER_DISK, PROTOCOL_VERSION};
+    ss << stats;
+    return {ss.begin(), ss.end()};
+}
+
+BOOST_AUTO_TEST_SUITE(blockstatsindex_tests)
+
+BOOST_FIXTURE_TEST_CASE(blockstatsindex_initial_sync, TestChain100Setup)
+{
+    BlockStatsIndex block_stats_index{1 << 20, true};
+
+    BlockStats block_stats;
+    const CBlockIndex* block_index;
+    {
+        LOCK(cs_main);
+        block_index = ChainActive().Tip();
+    }
+
+    // BlockStatsIndex should not be found before it is started.
+    BOOST_CHECK(!block_stats_index.LookUpStats(block_index, block_stats));
+
+    BOOST_REQUIRE(block_stats_index.Start(::ChainstateActive()));
+
+    // Allow the BlockStatsIndex to catch up with the block index that is
+    // syncing in a background thread.
+    const auto timeout = GetTime<std::chrono::seconds>() + 120s;
+    while (!block_stats_index.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(timeout > GetTime<std::chrono::milliseconds>());
+        UninterruptibleSleep(100ms);
+    }
+
+    // Check that BlockStatsIndex works for genesis block.
+    const CBlockIndex* genesis_block_index;
+    {
+        LOCK(cs_main);
+        genesis_block_index = ChainActive().Genesis();
+    }
+    BOOST_CHECK(block_stats_index.LookUpStats(genesis_block_index, block_stats));
+    BOOST_CHECK(SerializeStats(block_stats) == SerializeStats(ComputeStatsFromDisk(genesis_block_index)));
+
+    // Connect a block spending a coinbase output, so there are fees and
+    // inputs to account for.
+    const CScript script_pub_key{CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG};
+    const CMutableTransaction spend{CreateValidMempoolTransaction(m_coinbase_txns[0], 0, 1, coinbaseKey, script_pub_key, 40 * COIN, /* submit */ false)};
+    CreateAndProcessBlock({spend}, script_pub_key);
+
+    // Let the BlockStatsIndex catch up again.
+    BOOST_CHECK(block_stats_index.BlockUntilSyncedToCurrentChain());
+
+    const CBlockIndex* new_block_index;
+    {
+        LOCK(cs_main);
+        new_block_index = ChainActive().Tip();
+    }
+    BOOST_CHECK(block_index != new_block_index);
+
+    BOOST_REQUIRE(block_stats_index.LookUpStats(new_block_index, block_stats));
+    BOOST_CHECK(SerializeStats(block_stats) == SerializeStats(ComputeStatsFromDisk(new_block_index)));
+    BOOST_CHECK_EQUAL(block_stats.txs, 2);
+    BOOST_CHECK_EQUAL(block_stats.ins, 1);
+    BOOST_CHECK_EQUAL(block_stats.totalfee, 10 * COIN);
+
+    // Shutdown sequence (c.f. Shutdown() in init.cpp)
+    block_stats_index.Stop();
+
+    // Rest of shutdown sequence and destructors happen in ~TestingSetup()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -35,6 +35,7 @@
 #include <test/util/setup_common.h>
 
 #include <array>
+#include <limits>
 #include <stdint.h>
 
 #include <boost/test/unit_test.hpp>
@@ -448,12 +449,119 @@ BOOST_AUTO_TEST_CASE(DoS_mapOrphans)
     }
 
     // Test LimitOrphanTxSize() function:
-    orphanage.LimitOrphans(40);
+    orphanage.LimitOrphans(40, std::numeric_limits<unsigned int>::max());
     BOOST_CHECK(orphanage.CountOrphans() <= 40);
-    orphanage.LimitOrphans(10);
+    orphanage.LimitOrphans(10, std::numeric_limits<unsigned int>::max());
     BOOST_CHECK(orphanage.CountOrphans() <= 10);
-    orphanage.LimitOrphans(0);
+    orphanage.LimitOrphans(0, std::numeric_limits<unsigned int>::max());
     BOOST_CHECK(orphanage.CountOrphans() == 0);
 }
 
+static CTransactionRef MakeOrphan(const uint256& prev_hash, uint32_t prev_n)
+{
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].prevout = COutPoint(prev_hash, prev_n);
+    tx.vin[0].scriptSig << OP_1;
+    tx.vout.resize(1);
+    tx.vout[0].nValue = 1*CENT;
+    tx.vout[0].scriptPubKey = CScript() << OP_TRUE;
+    return MakeTransactionRef(tx);
+}
+
+BOOST_AUTO_TEST_CASE(DoS_mapOrphans_per_peer)
+{
+    TxOrphanageTest orphanage;
+    LOCK(g_cs_orphans);
+
+    std::vector<CTransactionRef> orphans;
+    for (int i = 0; i < 6; i++) {
+        orphans.push_back(MakeOrphan(InsecureRand256(), 0));
+        // Peer 0 announces five orphans, peer 1 only one
+        BOOST_CHECK(orphanage.AddTx(orphans.back(), i < 5 ? 0 : 1));
+    }
+    const unsigned int weight = GetTransactionWeight(*orphans[0]);
+    BOOST_CHECK_EQUAL(orphanage.PeerWeight(0), 5 * weight);
+    BOOST_CHECK_EQUAL(orphanage.PeerWeight(1), weight);
+    BOOST_CHECK_EQUAL(orphanage.PeerWeight(2), 0U);
+
+    // Only the peer over its budget loses orphans
+    BOOST_CHECK_EQUAL(orphanage.LimitOrphans(100, 2 * weight), 3U);
+    BOOST_CHECK_EQUAL(orphanage.PeerWeight(0), 2 * weight);
+    BOOST_CHECK_EQUAL(orphanage.PeerWeight(1), weight);
+    BOOST_CHECK(orphanage.HaveTx(GenTxid(false, orphans[5]->GetHash())));
+
+    // The global limit evicts from the peer with the most orphans first
+    BOOST_CHECK_EQUAL(orphanage.LimitOrphans(2, std::numeric_limits<unsigned int>::max()), 1U);
+    BOOST_CHECK_EQUAL(orphanage.PeerWeight(0), weight);
+    BOOST_CHECK_EQUAL(orphanage.PeerWeight(1), weight);
+
+    orphanage.EraseForPeer(0);
+    orphanage.EraseForPeer(1);
+    BOOST_CHECK_EQUAL(orphanage.CountOrphans(), 0U);
+    BOOST_CHECK_EQUAL(orphanage.PeerWeight(1), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(DoS_mapOrphans_count_limit)
+{
+    TxOrphanageTest orphanage;
+    LOCK(g_cs_orphans);
+
+    // Peer 0 announces many light orphans, peer 1 a few heavy ones
+    std::vector<CTransactionRef> light, heavy;
+    for (int i = 0; i < 6; i++) {
+        light.push_back(MakeOrphan(InsecureRand256(), 0));
+        BOOST_CHECK(orphanage.AddTx(light.back(), 0));
+    }
+    for (int i = 0; i < 2; i++) {
+        CMutableTransaction tx(*MakeOrphan(InsecureRand256(), 0));
+        tx.vin[0].scriptSig << std::vector<unsigned char>(10000, 0);
+        heavy.push_back(MakeTransactionRef(tx));
+        BOOST_CHECK(orphanage.AddTx(heavy.back(), 1));
+    }
+    BOOST_CHECK(orphanage.PeerWeight(1) > orphanage.PeerWeight(0));
+
+    // Evicting by count takes from the peer with the most orphans, not from
+    // the one whose orphans weigh the most
+    BOOST_CHECK_EQUAL(orphanage.LimitOrphans(5, std::numeric_limits<unsigned int>::max()), 3U);
+    BOOST_CHECK_EQUAL(orphanage.CountOrphans(), 5U);
+    BOOST_CHECK_EQUAL(orphanage.PeerWeight(0), 3 * GetTransactionWeight(*light[0]));
+    for (const auto& tx : heavy) {
+        BOOST_CHECK(orphanage.HaveTx(GenTxid(false, tx->GetHash())));
+    }
+
+    // Peer 0 still announced more orphans than peer 1
+    BOOST_CHECK_EQUAL(orphanage.LimitOrphans(4, std::numeric_limits<unsigned int>::max()), 1U);
+    BOOST_CHECK_EQUAL(orphanage.PeerWeight(0), 2 * GetTransactionWeight(*light[0]));
+}
+
+BOOST_AUTO_TEST_CASE(DoS_mapOrphans_children)
+{
+    TxOrphanageTest orphanage;
+    LOCK(g_cs_orphans);
+
+    CMutableTransaction parent;
+    parent.vin.resize(1);
+    parent.vin[0].prevout = COutPoint(InsecureRand256(), 0);
+    parent.vout.resize(2);
+    const CTransactionRef parent_ref = MakeTransactionRef(parent);
+
+    const CTransactionRef child0 = MakeOrphan(parent_ref->GetHash(), 0);
+    const CTransactionRef child1 = MakeOrphan(parent_ref->GetHash(), 1);
+    const CTransactionRef unrelated = MakeOrphan(InsecureRand256(), 0);
+    BOOST_CHECK(orphanage.AddTx(child0, 1));
+    BOOST_CHECK(orphanage.AddTx(child1, 2));
+    BOOST_CHECK(orphanage.AddTx(unrelated, 1));
+
+    const auto children = orphanage.GetChildren(*parent_ref);
+    BOOST_CHECK_EQUAL(children.size(), 2U);
+    std::set<std::pair<uint256, NodeId>> found;
+    for (const auto& [tx, peer] : children) found.emplace(tx->GetHash(), peer);
+    BOOST_CHECK(found.count({child0->GetHash(), 1}));
+    BOOST_CHECK(found.count({child1->GetHash(), 2}));
+
+    orphanage.EraseTx(child0->GetHash());
+    BOOST_CHECK_EQUAL(orphanage.GetChildren(*parent_ref).size(), 1U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
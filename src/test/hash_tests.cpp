@@ -157,6 +157,19 @@ BOOST_AUTO_TEST_CASE(siphash)
         BOOST_CHECK_EQUAL(SipHashUint256(k1, k2, x), sip256.Finalize());
         BOOST_CHECK_EQUAL(SipHashUint256Extra(k1, k2, x, n), sip288.Finalize());
     }
+
+    // Check consistency between SipHashUint256 and SipHashUint256_4way.
+    for (int i = 0; i < 16; ++i) {
+        uint64_t k1 = ctx.rand64();
+        uint64_t k2 = ctx.rand64();
+        uint256 x[4] = {InsecureRand256(), InsecureRand256(), InsecureRand256(), InsecureRand256()};
+        const uint256* const vals[4] = {&x[0], &x[1], &x[2], &x[3]};
+        uint64_t out[4];
+        SipHashUint256_4way(k1, k2, vals, out);
+        for (int j = 0; j < 4; ++j) {
+            BOOST_CHECK_EQUAL(out[j], SipHashUint256(k1, k2, x[j]));
+        }
+    }
 }
 
 BOOST_AUTO_TEST_SUITE_END()
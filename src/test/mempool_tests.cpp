@@ -16,12 +16,14 @@
 
 #include <policy/policy.h>
 #include <txmempool.h>
+#include <util/rbf.h>
 #include <util/system.h>
 #include <util/time.h>
 
 #include <test/util/setup_common.h>
 
 #include <boost/test/unit_test.hpp>
+#include <list>
 #include <vector>
 
 BOOST_FIXTURE_TEST_SUITE(mempool_tests, TestingSetup)
@@ -798,4 +800,135 @@ BOOST_AUTO_TEST_CASE(MempoolAncestryTests)
     BOOST_CHECK_EQUAL(descendants, 4ULL);
 }
 
+BOOST_AUTO_TEST_CASE(MemPoolEntryRefSetTest)
+{
+    TestMemPoolEntryHelper entry;
+    std::list<CTxMemPoolEntry> entries;
+    for (int i = 0; i < 5; ++i) {
+        entries.push_back(entry.FromTx(make_tx(/* output_values */ {(i + 1) * COIN})));
+    }
+
+    MemPoolEntryRefSet<CTxMemPoolEntry> set;
+    BOOST_CHECK(set.empty());
+    for (const CTxMemPoolEntry& e : entries) {
+        BOOST_CHECK(set.insert(e));
+        // Up to two entries are stored inline
+        if (set.size() <= 2) BOOST_CHECK_EQUAL(set.DynamicMemoryUsage(), 0U);
+    }
+    BOOST_CHECK_EQUAL(set.size(), 5U);
+    BOOST_CHECK(set.DynamicMemoryUsage() > 0);
+    BOOST_CHECK(!set.insert(entries.front()));
+    BOOST_CHECK_EQUAL(set.size(), 5U);
+
+    const auto check_sorted = [&set]() {
+        std::vector<uint256> hashes;
+        for (const CTxMemPoolEntry& e : set) hashes.push_back(e.GetTx().GetHash());
+        BOOST_CHECK(std::is_sorted(hashes.begin(), hashes.end()));
+        BOOST_CHECK_EQUAL(hashes.size(), set.size());
+    };
+    check_sorted();
+
+    BOOST_CHECK_EQUAL(set.erase(*std::next(entries.begin(), 2)), 1U);
+    BOOST_CHECK_EQUAL(set.erase(*std::next(entries.begin(), 2)), 0U);
+    BOOST_CHECK_EQUAL(set.size(), 4U);
+    check_sorted();
+
+    // Shrinking back to two entries releases the heap allocation
+    BOOST_CHECK_EQUAL(set.erase(entries.front()), 1U);
+    BOOST_CHECK_EQUAL(set.erase(entries.back()), 1U);
+    BOOST_CHECK_EQUAL(set.size(), 2U);
+    BOOST_CHECK_EQUAL(set.DynamicMemoryUsage(), 0U);
+    check_sorted();
+    BOOST_CHECK(!set.insert(*std::next(entries.begin(), 1)));
+    BOOST_CHECK(set.insert(entries.front()));
+    BOOST_CHECK_EQUAL(set.size(), 3U);
+    check_sorted();
+}
+
+BOOST_AUTO_TEST_CASE(MempoolSnapshotTest)
+{
+    CTxMemPool pool;
+    TestMemPoolEntryHelper entry;
+
+    // [tx1].0 <- [tx2 (signals RBF)].0 <- [tx3]
+    // [tx4]
+    CTransactionRef tx1 = make_tx(/* output_values */ {10 * COIN});
+    CMutableTransaction mtx2{*make_tx(/* output_values */ {9 * COIN}, /* inputs */ {tx1})};
+    mtx2.vin[0].nSequence = MAX_BIP125_RBF_SEQUENCE;
+    CTransactionRef tx2 = MakeTransactionRef(mtx2);
+    CTransactionRef tx3 = make_tx(/* output_values */ {8 * COIN}, /* inputs */ {tx2});
+    CTransactionRef tx4 = make_tx(/* output_values */ {7 * COIN});
+    {
+        LOCK2(cs_main, pool.cs);
+        for (const CTransactionRef& tx : {tx1, tx2, tx3, tx4}) {
+            pool.addUnchecked(entry.Fee(10000LL).FromTx(tx));
+        }
+    }
+
+    const std::shared_ptr<const MempoolSnapshot> snapshot = pool.GetSnapshot();
+    BOOST_CHECK_EQUAL(snapshot->size(), 4U);
+    // The snapshot is shared until the mempool changes
+    BOOST_CHECK(pool.GetSnapshot() == snapshot);
+
+    std::map<uint256, TxMempoolEntrySnapshot> entries;
+    for (const auto& e : *snapshot) {
+        entries.emplace(e->tx->GetHash(), *e);
+    }
+    BOOST_CHECK(!entries.at(tx1->GetHash()).bip125_replaceable);
+    BOOST_CHECK(entries.at(tx2->GetHash()).bip125_replaceable);
+    BOOST_CHECK(entries.at(tx3->GetHash()).bip125_replaceable);
+    BOOST_CHECK(!entries.at(tx4->GetHash()).bip125_replaceable);
+    BOOST_CHECK(entries.at(tx1->GetHash()).parents.empty());
+    BOOST_CHECK(entries.at(tx2->GetHash()).parents == std::vector<uint256>{tx1->GetHash()});
+    BOOST_CHECK(entries.at(tx2->GetHash()).children == std::vector<uint256>{tx3->GetHash()});
+    BOOST_CHECK_EQUAL(entries.at(tx1->GetHash()).count_with_descendants, 3U);
+    BOOST_CHECK_EQUAL(entries.at(tx3->GetHash()).count_with_ancestors, 3U);
+    {
+        LOCK(pool.cs);
+        const TxMempoolEntrySnapshot e = pool.GetEntrySnapshot(*pool.mapTx.find(tx3->GetHash()));
+        BOOST_CHECK(e.bip125_replaceable);
+        BOOST_CHECK(e.parents == std::vector<uint256>{tx2->GetHash()});
+    }
+
+    // Changes to the mempool produce a new snapshot, the old one is unaffected
+    pool.PrioritiseTransaction(tx4->GetHash(), 5000);
+    const std::shared_ptr<const MempoolSnapshot> prioritised = pool.GetSnapshot();
+    BOOST_CHECK(prioritised != snapshot);
+    for (const auto& e : *prioritised) {
+        if (e->tx->GetHash() == tx4->GetHash()) BOOST_CHECK_EQUAL(e->modified_fee, 15000);
+    }
+    BOOST_CHECK_EQUAL(entries.at(tx4->GetHash()).modified_fee, 10000);
+
+    pool.AddUnbroadcastTx(tx1->GetHash());
+    const std::shared_ptr<const MempoolSnapshot> unbroadcast = pool.GetSnapshot();
+    BOOST_CHECK(unbroadcast != prioritised);
+    for (const auto& e : *unbroadcast) {
+        BOOST_CHECK_EQUAL(e->unbroadcast, e->tx->GetHash() == tx1->GetHash());
+    }
+
+    // Entries that did not change are shared with the previous snapshot
+    std::map<uint256, std::shared_ptr<const TxMempoolEntrySnapshot>> prioritised_entries, unbroadcast_entries;
+    for (const auto& e : *prioritised) prioritised_entries.emplace(e->tx->GetHash(), e);
+    for (const auto& e : *unbroadcast) unbroadcast_entries.emplace(e->tx->GetHash(), e);
+    BOOST_CHECK(unbroadcast_entries.at(tx1->GetHash()) != prioritised_entries.at(tx1->GetHash()));
+    for (const CTransactionRef& tx : {tx2, tx3, tx4}) {
+        BOOST_CHECK(unbroadcast_entries.at(tx->GetHash()) == prioritised_entries.at(tx->GetHash()));
+    }
+
+    WITH_LOCK(pool.cs, pool.removeRecursive(*tx2, REMOVAL_REASON_DUMMY));
+    const std::shared_ptr<const MempoolSnapshot> removed = pool.GetSnapshot();
+    BOOST_CHECK_EQUAL(removed->size(), 2U);
+    BOOST_CHECK_EQUAL(unbroadcast->size(), 4U);
+    for (const auto& e : *removed) {
+        // tx1 lost its child, tx4 is unrelated
+        if (e->tx->GetHash() == tx1->GetHash()) {
+            BOOST_CHECK(e != unbroadcast_entries.at(tx1->GetHash()));
+            BOOST_CHECK(e->children.empty());
+            BOOST_CHECK_EQUAL(e->count_with_descendants, 1U);
+        } else {
+            BOOST_CHECK(e == unbroadcast_entries.at(tx4->GetHash()));
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
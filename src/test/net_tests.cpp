@@ -22,9 +22,11 @@
 #include <net.h>
 #include <netaddress.h>
 #include <netbase.h>
+#include <netmessagemaker.h>
 #include <serialize.h>
 #include <span.h>
 #include <streams.h>
+#include <test/util/net.h>
 #include <test/util/setup_common.h>
 #include <util/strencodings.h>
 #include <util/string.h>
@@ -847,4 +849,140 @@ BOOST_AUTO_TEST_CASE(LocalAddress_BasicLifecycle)
     BOOST_CHECK_EQUAL(IsLocal(addr), false);
 }
 
+BOOST_AUTO_TEST_CASE(recv_buffer_pool)
+{
+    RecvBufferPool pool;
+    CDataStream stream{pool.Acquire(1000, SER_NETWORK, PROTOCOL_VERSION)};
+    BOOST_CHECK(stream.empty());
+    BOOST_CHECK(stream.capacity() >= 1000);
+    stream.resize(1000);
+    const auto* buffer{stream.data()};
+
+    // A released buffer is reused by the next request of the same size class
+    pool.Release(std::move(stream));
+    BOOST_CHECK_EQUAL(pool.Size(), 1U);
+    CDataStream reused{pool.Acquire(900, SER_NETWORK, INIT_PROTO_VERSION)};
+    BOOST_CHECK(reused.empty());
+    BOOST_CHECK(reused.data() == buffer);
+    BOOST_CHECK_EQUAL(reused.GetVersion(), INIT_PROTO_VERSION);
+    BOOST_CHECK_EQUAL(pool.Size(), 0U);
+
+    // but not by a larger one
+    pool.Release(std::move(reused));
+    CDataStream larger{pool.Acquire(5000, SER_NETWORK, PROTOCOL_VERSION)};
+    BOOST_CHECK(larger.capacity() >= 5000);
+    BOOST_CHECK_EQUAL(pool.Size(), 1U);
+
+    // Buffers for messages beyond the largest size class are never pooled
+    CDataStream huge{pool.Acquire(4 * RecvBufferPool::MAX_CLASS_SIZE, SER_NETWORK, PROTOCOL_VERSION)};
+    huge.resize(4 * RecvBufferPool::MAX_CLASS_SIZE);
+    pool.Release(std::move(huge));
+    BOOST_CHECK_EQUAL(pool.Size(), 1U);
+
+    // Each size class keeps a bounded number of buffers
+    for (int i = 0; i < 10; ++i) {
+        CDataStream big{SER_NETWORK, PROTOCOL_VERSION};
+        big.reserve(RecvBufferPool::MAX_CLASS_SIZE);
+        pool.Release(std::move(big));
+    }
+    BOOST_CHECK_EQUAL(pool.Size(), 1U + RecvBufferPool::MAX_BYTES_PER_CLASS / RecvBufferPool::MAX_CLASS_SIZE);
+}
+
+BOOST_AUTO_TEST_CASE(shared_payload_message)
+{
+    const std::vector<unsigned char> data(1000, 0x5a);
+    const auto payload = std::make_shared<const SharedPayload>(std::vector<unsigned char>(data));
+    BOOST_CHECK(payload->hash == Hash(data));
+
+    // A shared payload produces the same header as an owned one
+    CSerializedNetMsg owned;
+    owned.m_type = NetMsgType::CMPCTBLOCK;
+    owned.data = data;
+    CSerializedNetMsg shared = CNetMsgMaker::MakeShared(NetMsgType::CMPCTBLOCK, payload);
+    BOOST_CHECK(std::equal(shared.Payload().begin(), shared.Payload().end(), data.begin(), data.end()));
+    V1TransportSerializer serializer;
+    std::vector<unsigned char> owned_header, shared_header;
+    serializer.prepareForTransport(owned, owned_header);
+    serializer.prepareForTransport(shared, shared_header);
+    BOOST_CHECK(owned_header == shared_header);
+
+    // Every send queue refers to the same buffer instead of a copy
+    CAddrMan addrman;
+    ConnmanTestMsg connman{0x1337, 0x1337, addrman};
+    std::vector<std::unique_ptr<CNode>> nodes;
+    for (NodeId id = 0; id < 3; ++id) {
+        nodes.push_back(std::make_unique<CNode>(id, NODE_NETWORK, INVALID_SOCKET, CAddress{}, /* nKeyedNetGroupIn = */ 0,
+                                                /* nLocalHostNonceIn = */ 0, CAddress{}, /* pszDest = */ "",
+                                                ConnectionType::OUTBOUND_FULL_RELAY, /* inbound_onion = */ false));
+        connman.PushMessage(nodes.back().get(), CNetMsgMaker::MakeShared(NetMsgType::CMPCTBLOCK, payload));
+    }
+    for (const auto& node : nodes) {
+        LOCK(node->cs_vSend);
+        BOOST_REQUIRE_EQUAL(node->vSendMsg.size(), 2U);
+        BOOST_CHECK(node->vSendMsg.back()->data() == payload->data.data());
+    }
+}
+
+#ifndef WIN32
+BOOST_AUTO_TEST_CASE(socket_send_gathers_buffers)
+{
+    int fds[2];
+    BOOST_REQUIRE_EQUAL(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    CAddrMan addrman;
+    ConnmanTestMsg connman{0x1337, 0x1337, addrman};
+    CNode node{0, NODE_NETWORK, static_cast<SOCKET>(fds[0]), CAddress{}, /* nKeyedNetGroupIn = */ 0, /* nLocalHostNonceIn = */ 0,
+               CAddress{}, /* pszDest = */ "", ConnectionType::OUTBOUND_FULL_RELAY, /* inbound_onion = */ false};
+
+    const auto receive = [&](size_t size) {
+        std::vector<unsigned char> received(size);
+        size_t got = 0;
+        while (got < size) {
+            const ssize_t n = recv(fds[1], received.data() + got, size - got, 0);
+            BOOST_REQUIRE(n > 0);
+            got += n;
+        }
+        return received;
+    };
+
+    // More buffers than fit in a single sendmsg call, some of them the same
+    // shared buffer
+    const SendBuffer shared = std::make_shared<const std::vector<unsigned char>>(500, 0xab);
+    std::vector<unsigned char> expected;
+    {
+        LOCK(node.cs_vSend);
+        for (int i = 0; i < 100; ++i) {
+            const SendBuffer buf = i % 10 == 0 ? shared : std::make_shared<const std::vector<unsigned char>>(i + 1, uint8_t(i));
+            expected.insert(expected.end(), buf->begin(), buf->end());
+            node.nSendSize += buf->size();
+            node.vSendMsg.push_back(buf);
+        }
+        BOOST_CHECK_EQUAL(connman.SendQueuedData(node), expected.size());
+        BOOST_CHECK(node.vSendMsg.empty());
+        BOOST_CHECK_EQUAL(node.nSendSize, 0U);
+        BOOST_CHECK_EQUAL(node.nSendOffset, 0U);
+    }
+    BOOST_CHECK_EQUAL(shared.use_count(), 1);
+    BOOST_CHECK(receive(expected.size()) == expected);
+
+    // A buffer larger than the socket buffer is sent over several calls
+    expected.assign(4 << 20, 0);
+    for (size_t i = 0; i < expected.size(); ++i) expected[i] = uint8_t(i * 7);
+    std::vector<unsigned char> received;
+    {
+        LOCK(node.cs_vSend);
+        node.vSendMsg.push_back(std::make_shared<const std::vector<unsigned char>>(expected.begin(), expected.end() - 10));
+        node.vSendMsg.push_back(std::make_shared<const std::vector<unsigned char>>(expected.end() - 10, expected.end()));
+        node.nSendSize = expected.size();
+    }
+    while (received.size() < expected.size()) {
+        const size_t sent = WITH_LOCK(node.cs_vSend, return connman.SendQueuedData(node));
+        const auto chunk = receive(sent);
+        received.insert(received.end(), chunk.begin(), chunk.end());
+    }
+    BOOST_CHECK(received == expected);
+    BOOST_CHECK(WITH_LOCK(node.cs_vSend, return node.vSendMsg.empty()));
+    close(fds[1]);
+}
+#endif
+
 BOOST_AUTO_TEST_SUITE_END()
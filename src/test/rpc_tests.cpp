@@ -15,6 +15,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <rpc/client.h>
+#include <rpc/jsonwriter.h>
 #include <rpc/server.h>
 #include <rpc/util.h>
 
@@ -25,6 +26,7 @@
 #include <util/time.h>
 
 #include <any>
+#include <thread>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/test/unit_test.hpp>
@@ -485,4 +487,103 @@ BOOST_AUTO_TEST_CASE(help_example)
     BOOST_CHECK_NE(HelpExampleRpcNamed("foo", {{"arg", true}}), HelpExampleRpcNamed("foo", {{"arg", "true"}}));
 }
 
+BOOST_AUTO_TEST_CASE(rpc_batch_parallel)
+{
+    if (RPCIsInWarmup(nullptr)) SetRPCWarmupFinished();
+    JSONRPCRequest jreq;
+    jreq.context = &m_node;
+
+    UniValue batch(UniValue::VARR);
+    for (int i = 0; i < 100; ++i) {
+        UniValue request(UniValue::VOBJ);
+        request.pushKV("method", i % 10 == 0 ? "nosuchmethod" : i % 2 ? "echo" : "getblockcount");
+        UniValue params(UniValue::VARR);
+        if (i % 2) params.push_back(i);
+        request.pushKV("params", params);
+        request.pushKV("id", i);
+        batch.push_back(request);
+    }
+    const std::string serial = JSONRPCExecBatch(jreq, batch).write();
+    BOOST_CHECK_EQUAL(UniValue{}.read(serial), true);
+
+    // Helper tasks on separate threads
+    std::vector<std::thread> threads;
+    const RPCTaskRunner run_on_thread = [&](std::function<void()> task) {
+        threads.emplace_back(std::move(task));
+        return true;
+    };
+    BOOST_CHECK_EQUAL(JSONRPCExecBatch(jreq, batch, 4, run_on_thread).write(), serial);
+    BOOST_CHECK_EQUAL(threads.size(), 3U);
+    for (auto& thread : threads) thread.join();
+    threads.clear();
+
+    // Helper tasks that only run after the batch has completed
+    std::vector<std::function<void()>> deferred;
+    const RPCTaskRunner run_deferred = [&](std::function<void()> task) {
+        deferred.push_back(std::move(task));
+        return true;
+    };
+    BOOST_CHECK_EQUAL(JSONRPCExecBatch(jreq, batch, 8, run_deferred).write(), serial);
+    BOOST_CHECK_EQUAL(deferred.size(), 7U);
+    for (const auto& task : deferred) task();
+
+    // Helper tasks that cannot be scheduled
+    BOOST_CHECK_EQUAL(JSONRPCExecBatch(jreq, batch, 4, [](std::function<void()>) { return false; }).write(), serial);
+}
+
+BOOST_AUTO_TEST_CASE(rpc_jsonwriter)
+{
+    UniValue value;
+    BOOST_CHECK(value.read(R"({"a":[1,"two",true,null,{}],"b\u0001\"\\\u007f":{"c":[],"d":-1.5e3},"e":"caf\u00e9\n"})"));
+
+    for (size_t flush_size : {0, 1, 5, 1000}) {
+        std::string flushed;
+        unsigned int flushes{0};
+        JSONWriter writer{flush_size, [&](std::string& chunk) {
+            BOOST_CHECK(chunk.size() >= flush_size);
+            flushed += chunk;
+            chunk.clear();
+            ++flushes;
+        }};
+        writer.Raw("[");
+        writer.Value(value);
+        writer.Raw(",");
+        // The same value written member by member
+        writer.BeginObject();
+        writer.Key("a");
+        writer.BeginArray();
+        for (const UniValue& v : value["a"].getValues()) writer.Value(v);
+        writer.EndArray();
+        for (size_t i = 1; i < value.size(); ++i) {
+            writer.Key(value.getKeys()[i]);
+            writer.Value(value[i]);
+        }
+        writer.EndObject();
+        writer.Raw(",");
+        writer.BeginObject();
+        writer.Members(value);
+        writer.EndObject();
+        writer.Raw("]");
+        BOOST_CHECK_EQUAL(flushed + writer.Release(), "[" + value.write() + "," + value.write() + "," + value.write() + "]");
+        BOOST_CHECK_EQUAL(flushes > 0, flush_size < 1000);
+    }
+
+    // Escaping matches UniValue for every byte
+    std::string all;
+    for (int ch = 0; ch < 256; ++ch) all += char(ch);
+    std::string out;
+    JSONWriteString(all, out);
+    BOOST_CHECK_EQUAL(out, UniValue(all).write());
+
+    // Special characters at every offset around the word-sized scan blocks
+    for (const char* special : {"\"", "\\", "\n", "\x01", "\x7f", "\xc3\xa9"}) {
+        for (size_t pos = 0; pos <= 20; ++pos) {
+            const std::string str = std::string(pos, 'a') + special + std::string(20 - pos, 'b');
+            out.clear();
+            JSONWriteString(str, out);
+            BOOST_CHECK_EQUAL(out, UniValue(str).write());
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
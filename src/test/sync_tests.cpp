@@ -19,8 +19,12 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <chrono>
+#include <cstring>
+#include <future>
 #include <mutex>
 #include <stdexcept>
+#include <thread>
 
 namespace {
 template <typename MutexType>
@@ -152,4 +156,59 @@ BOOST_AUTO_TEST_CASE(inconsistent_lock_order_detected)
 #endif // DEBUG_LOCKORDER
 }
 
+BOOST_AUTO_TEST_CASE(lock_profiling)
+{
+    Mutex profiled_mutex;
+    const auto find_site = [] {
+        const LockSite* found{nullptr};
+        ForEachLockSite([&found](const LockSite& site) {
+            if (std::strcmp(site.name, "profiled_mutex") == 0) found = &site;
+        });
+        return found;
+    };
+
+    // Nothing is recorded while profiling is off
+    {
+        LOCK(profiled_mutex);
+    }
+    const LockSite* site{find_site()};
+    BOOST_REQUIRE(site);
+    BOOST_CHECK_EQUAL(site->acquisitions, 0U);
+
+    g_lock_profiling = true;
+    std::promise<void> locked;
+    std::thread holder{[&] {
+        LOCK(profiled_mutex);
+        locked.set_value();
+        std::this_thread::sleep_for(std::chrono::milliseconds{50});
+    }};
+    locked.get_future().wait();
+    {
+        LOCK(profiled_mutex);
+        site = find_site();
+    }
+    holder.join();
+    {
+        TRY_LOCK(profiled_mutex, lock);
+        BOOST_CHECK(lock.owns_lock());
+    }
+    g_lock_profiling = false;
+
+    uint64_t acquisitions{0}, contentions{0}, wait_ns{0}, hold_ns{0};
+    ForEachLockSite([&](const LockSite& s) {
+        if (std::strcmp(s.name, "profiled_mutex") != 0) return;
+        acquisitions += s.acquisitions;
+        contentions += s.contentions;
+        wait_ns += s.wait_ns;
+        hold_ns += s.hold_ns;
+    });
+    BOOST_CHECK_EQUAL(acquisitions, 3U);
+    BOOST_CHECK_EQUAL(contentions, 1U);
+    BOOST_CHECK(wait_ns > 0);
+    BOOST_CHECK(hold_ns >= uint64_t(std::chrono::nanoseconds{std::chrono::milliseconds{50}}.count()));
+
+    ResetLockSites();
+    BOOST_CHECK_EQUAL(site->acquisitions, 0U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -21,14 +21,30 @@
 #include <primitives/transaction.h>
 #include <script/script.h>
 #include <script/standard.h>
+#include <streams.h>
+#include <util/strencodings.h>
 #include <test/util/setup_common.h>
 #include <validation.h>
+#include <validationinterface.h>
 
 #include <boost/test/unit_test.hpp>
 
 
 BOOST_AUTO_TEST_SUITE(txvalidation_tests)
 
+/** Records the wtxids of the transactions added to and removed from the mempool, in order */
+struct MempoolEventsRecorder : public CValidationInterface {
+    std::vector<std::pair<bool, uint256>> m_events;
+    void TransactionAddedToMempool(const CTransactionRef& tx, uint64_t) override
+    {
+        m_events.emplace_back(true, tx->GetWitnessHash());
+    }
+    void TransactionRemovedFromMempool(const CTransactionRef& tx, MemPoolRemovalReason, uint64_t) override
+    {
+        m_events.emplace_back(false, tx->GetWitnessHash());
+    }
+};
+
 /**
  * Ensure that the mempool won't accept coinbase transactions.
  */
@@ -157,4 +173,164 @@ BOOST_FIXTURE_TEST_CASE(package_tests, TestChain100Setup)
     // Check that mempool size hasn't changed.
     BOOST_CHECK_EQUAL(m_node.mempool->size(), initialPoolSize);
 }
+
+BOOST_FIXTURE_TEST_CASE(package_submission_tests, TestChain100Setup)
+{
+    LOCK(cs_main);
+    unsigned int initialPoolSize = m_node.mempool->size();
+
+    // A parent paying no fee is rejected on its own, but the feerate failure is reconsiderable.
+    CKey parent_key;
+    parent_key.MakeNewKey(true);
+    CScript parent_locking_script = GetScriptForDestination(PKHash(parent_key.GetPubKey()));
+    auto mtx_parent = CreateValidMempoolTransaction(/* input_transaction */ m_coinbase_txns[0], /* vout */ 0,
+                                                    /* input_height */ 0, /* input_signing_key */ coinbaseKey,
+                                                    /* output_destination */ parent_locking_script,
+                                                    /* output_amount */ m_coinbase_txns[0]->vout[0].nValue, /* submit */ false);
+    CTransactionRef tx_parent = MakeTransactionRef(mtx_parent);
+    const auto result_parent = AcceptToMemoryPool(m_node.chainman->ActiveChainstate(), *m_node.mempool, tx_parent, /* bypass_limits */ false);
+    BOOST_CHECK(result_parent.m_result_type == MempoolAcceptResult::ResultType::INVALID);
+    BOOST_CHECK(result_parent.m_state.GetResult() == TxValidationResult::TX_RECONSIDERABLE);
+    BOOST_CHECK_EQUAL(m_node.mempool->size(), initialPoolSize);
+
+    // Packages submitted to the mempool must be a child with its parents.
+    auto mtx_unrelated = CreateValidMempoolTransaction(/* input_transaction */ m_coinbase_txns[1], /* vout */ 0,
+                                                       /* input_height */ 0, /* input_signing_key */ coinbaseKey,
+                                                       /* output_destination */ parent_locking_script,
+                                                       /* output_amount */ CAmount(49 * COIN), /* submit */ false);
+    CTransactionRef tx_unrelated = MakeTransactionRef(mtx_unrelated);
+    const auto result_unrelated = ProcessNewPackage(m_node.chainman->ActiveChainstate(), *m_node.mempool, {tx_parent, tx_unrelated}, /* test_accept */ false);
+    BOOST_CHECK(result_unrelated.m_state.IsInvalid());
+    BOOST_CHECK_EQUAL(result_unrelated.m_state.GetRejectReason(), "package-not-child-with-parents");
+    BOOST_CHECK_EQUAL(m_node.mempool->size(), initialPoolSize);
+
+    // A child paying for its parent is accepted together with it.
+    CKey child_key;
+    child_key.MakeNewKey(true);
+    CScript child_locking_script = GetScriptForDestination(PKHash(child_key.GetPubKey()));
+    auto mtx_child = CreateValidMempoolTransaction(/* input_transaction */ tx_parent, /* vout */ 0,
+                                                   /* input_height */ 101, /* input_signing_key */ parent_key,
+                                                   /* output_destination */ child_locking_script,
+                                                   /* output_amount */ tx_parent->vout[0].nValue - COIN, /* submit */ false);
+    CTransactionRef tx_child = MakeTransactionRef(mtx_child);
+    const auto result_cpfp = ProcessNewPackage(m_node.chainman->ActiveChainstate(), *m_node.mempool, {tx_parent, tx_child}, /* test_accept */ false);
+    BOOST_CHECK_MESSAGE(result_cpfp.m_state.IsValid(),
+                        "Package submission unexpectedly failed: " << result_cpfp.m_state.GetRejectReason());
+    BOOST_CHECK_EQUAL(result_cpfp.m_tx_results.size(), 2U);
+    BOOST_CHECK(m_node.mempool->exists(GenTxid(/* is_wtxid */ true, tx_parent->GetWitnessHash())));
+    BOOST_CHECK(m_node.mempool->exists(GenTxid(/* is_wtxid */ true, tx_child->GetWitnessHash())));
+    BOOST_CHECK_EQUAL(m_node.mempool->size(), initialPoolSize + 2);
+
+    // A child cannot be subsidized by a parent paying a higher feerate.
+    auto mtx_rich_parent = CreateValidMempoolTransaction(/* input_transaction */ tx_child, /* vout */ 0,
+                                                         /* input_height */ 101, /* input_signing_key */ child_key,
+                                                         /* output_destination */ parent_locking_script,
+                                                         /* output_amount */ tx_child->vout[0].nValue - COIN, /* submit */ false);
+    CTransactionRef tx_rich_parent = MakeTransactionRef(mtx_rich_parent);
+    auto mtx_free_child = CreateValidMempoolTransaction(/* input_transaction */ tx_rich_parent, /* vout */ 0,
+                                                        /* input_height */ 101, /* input_signing_key */ parent_key,
+                                                        /* output_destination */ child_locking_script,
+                                                        /* output_amount */ tx_rich_parent->vout[0].nValue, /* submit */ false);
+    CTransactionRef tx_free_child = MakeTransactionRef(mtx_free_child);
+    const auto result_subsidized = ProcessNewPackage(m_node.chainman->ActiveChainstate(), *m_node.mempool, {tx_rich_parent, tx_free_child}, /* test_accept */ false);
+    BOOST_CHECK(result_subsidized.m_state.IsInvalid());
+    BOOST_CHECK_EQUAL(result_subsidized.m_state.GetRejectReason(), "package-child-feerate-too-low");
+    BOOST_CHECK_EQUAL(m_node.mempool->size(), initialPoolSize + 2);
+
+    // When the script checks of a package fail, the failing transaction is identified.
+    auto mtx_bad_sig_child = CreateValidMempoolTransaction(/* input_transaction */ tx_rich_parent, /* vout */ 0,
+                                                           /* input_height */ 101, /* input_signing_key */ parent_key,
+                                                           /* output_destination */ child_locking_script,
+                                                           /* output_amount */ tx_rich_parent->vout[0].nValue - COIN, /* submit */ false);
+    mtx_bad_sig_child.vin[0].scriptSig = CScript() << OP_0 << ToByteVector(parent_key.GetPubKey());
+    CTransactionRef tx_bad_sig_child = MakeTransactionRef(mtx_bad_sig_child);
+    const auto result_bad_sig = ProcessNewPackage(m_node.chainman->ActiveChainstate(), *m_node.mempool, {tx_rich_parent, tx_bad_sig_child}, /* test_accept */ false);
+    BOOST_CHECK(result_bad_sig.m_state.IsInvalid());
+    BOOST_CHECK_EQUAL(result_bad_sig.m_state.GetResult(), PackageValidationResult::PCKG_TX);
+    auto it_bad_sig = result_bad_sig.m_tx_results.find(tx_bad_sig_child->GetWitnessHash());
+    BOOST_CHECK(it_bad_sig != result_bad_sig.m_tx_results.end());
+    BOOST_CHECK_EQUAL(it_bad_sig->second.m_state.GetResult(), TxValidationResult::TX_CONSENSUS);
+    BOOST_CHECK_EQUAL(m_node.mempool->size(), initialPoolSize + 2);
+
+    // A package that does not fit in the mempool is not left in it partially,
+    // and the failure is reconsiderable.
+    auto mtx_full_parent = CreateValidMempoolTransaction(/* input_transaction */ tx_child, /* vout */ 0,
+                                                         /* input_height */ 101, /* input_signing_key */ child_key,
+                                                         /* output_destination */ parent_locking_script,
+                                                         /* output_amount */ tx_child->vout[0].nValue, /* submit */ false);
+    CTransactionRef tx_full_parent = MakeTransactionRef(mtx_full_parent);
+    auto mtx_full_child = CreateValidMempoolTransaction(/* input_transaction */ tx_full_parent, /* vout */ 0,
+                                                        /* input_height */ 101, /* input_signing_key */ parent_key,
+                                                        /* output_destination */ child_locking_script,
+                                                        /* output_amount */ tx_full_parent->vout[0].nValue - COIN, /* submit */ false);
+    CTransactionRef tx_full_child = MakeTransactionRef(mtx_full_child);
+    auto events = std::make_shared<MempoolEventsRecorder>();
+    RegisterSharedValidationInterface(events);
+    gArgs.ForceSetArg("-maxmempool", "0");
+    const auto result_full = ProcessNewPackage(m_node.chainman->ActiveChainstate(), *m_node.mempool, {tx_full_parent, tx_full_child}, /* test_accept */ false);
+    gArgs.ForceSetArg("-maxmempool", ToString(DEFAULT_MAX_MEMPOOL_SIZE));
+    SyncWithValidationInterfaceQueue();
+    UnregisterSharedValidationInterface(events);
+    BOOST_CHECK(result_full.m_state.IsInvalid());
+    BOOST_CHECK_EQUAL(result_full.m_tx_results.size(), 2U);
+    for (const auto& [wtxid, tx_result] : result_full.m_tx_results) {
+        BOOST_CHECK(tx_result.m_result_type == MempoolAcceptResult::ResultType::INVALID);
+        BOOST_CHECK(tx_result.m_state.GetResult() == TxValidationResult::TX_RECONSIDERABLE);
+        BOOST_CHECK_EQUAL(tx_result.m_state.GetRejectReason(), "mempool full");
+    }
+    BOOST_CHECK(!m_node.mempool->exists(GenTxid(/* is_wtxid */ true, tx_full_parent->GetWitnessHash())));
+    BOOST_CHECK(!m_node.mempool->exists(GenTxid(/* is_wtxid */ true, tx_full_child->GetWitnessHash())));
+    // Every removal of a package transaction follows its addition
+    for (const auto& tx : {tx_full_parent, tx_full_child}) {
+        const auto added = std::find(events->m_events.begin(), events->m_events.end(), std::make_pair(true, tx->GetWitnessHash()));
+        const auto removed = std::find(events->m_events.begin(), events->m_events.end(), std::make_pair(false, tx->GetWitnessHash()));
+        BOOST_CHECK(added != events->m_events.end());
+        BOOST_CHECK(removed != events->m_events.end());
+        BOOST_CHECK(added < removed);
+    }
+}
+
+/**
+ * Ensure that LoadMempool accepts transactions stored before the transactions
+ * they spend from, with and without parallel script pre-verification.
+ */
+BOOST_FIXTURE_TEST_CASE(load_mempool_unsorted, TestChain100Setup)
+{
+    CScript locking_script = GetScriptForDestination(PKHash(coinbaseKey.GetPubKey()));
+    std::vector<CTransactionRef> chain;
+    CTransactionRef prev = m_coinbase_txns[0];
+    for (int i = 0; i < 4; ++i) {
+        auto mtx = CreateValidMempoolTransaction(/* input_transaction */ prev, /* vout */ 0,
+                                                 /* input_height */ i == 0 ? 0 : 101, /* input_signing_key */ coinbaseKey,
+                                                 /* output_destination */ locking_script,
+                                                 /* output_amount */ prev->vout[0].nValue - COIN, /* submit */ false);
+        // The last transaction has an invalid signature
+        if (i == 3) mtx.vin[0].scriptSig = CScript() << OP_0 << ToByteVector(coinbaseKey.GetPubKey());
+        prev = MakeTransactionRef(mtx);
+        chain.push_back(prev);
+    }
+
+    {
+        // Children first, as a file written by another implementation might be
+        CAutoFile file(fsbridge::fopen(gArgs.GetDataDirNet() / "mempool.dat", "wb"), SER_DISK, CLIENT_VERSION);
+        file << uint64_t{1} /* MEMPOOL_DUMP_VERSION */ << uint64_t{chain.size()};
+        for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+            file << **it << GetTime() << int64_t{0};
+        }
+        file << std::map<uint256, CAmount>{} << std::set<uint256>{};
+    }
+
+    for (const bool parallel : {true, false}) {
+        g_parallel_script_checks = parallel;
+        m_node.mempool->clear();
+        BOOST_CHECK(LoadMempool(*m_node.mempool, m_node.chainman->ActiveChainstate()));
+        BOOST_CHECK_EQUAL(m_node.mempool->size(), 3U);
+        for (int i = 0; i < 3; ++i) {
+            BOOST_CHECK(m_node.mempool->exists(chain[i]->GetHash()));
+        }
+        BOOST_CHECK(!m_node.mempool->exists(chain[3]->GetHash()));
+    }
+    g_parallel_script_checks = true;
+}
+
 BOOST_AUTO_TEST_SUITE_END()
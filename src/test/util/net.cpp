@@ -46,6 +46,6 @@ bool ConnmanTestMsg::ReceiveMsgFrom(CNode& node, CSerializedNetMsg& ser_msg) con
 
     bool complete;
     NodeReceiveMsgBytes(node, ser_msg_header, complete);
-    NodeReceiveMsgBytes(node, ser_msg.data, complete);
+    NodeReceiveMsgBytes(node, ser_msg.Payload(), complete);
     return complete;
 }
@@ -43,6 +43,8 @@ struct ConnmanTestMsg : public CConnman {
 
     void ProcessMessagesOnce(CNode& node) { m_msgproc->ProcessMessages(&node, flagInterruptMsgProc); }
 
+    size_t SendQueuedData(CNode& node) const EXCLUSIVE_LOCKS_REQUIRED(node.cs_vSend) { return SocketSendData(node); }
+
     void NodeReceiveMsgBytes(CNode& node, Span<const uint8_t> msg_bytes, bool& complete) const;
 
     bool ReceiveMsgFrom(CNode& node, CSerializedNetMsg& ser_msg) const;
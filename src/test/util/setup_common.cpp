@@ -22,7 +22,9 @@
 #include <consensus/consensus.h>
 #include <consensus/params.h>
 #include <consensus/validation.h>
+#include <crypto/chacha20.h>
 #include <crypto/sha256.h>
+#include <crypto/siphash.h>
 #include <init.h>
 #include <interfaces/chain.h>
 #include <miner.h>
@@ -119,6 +121,8 @@ BasicTestingSetup::BasicTestingSetup(const std::string& chainName, const std::ve
     AppInitParameterInteraction(*m_node.args);
     LogInstance().StartLogging();
     SHA256AutoDetect();
+    ChaCha20AutoDetect();
+    SipHashAutoDetect();
     ECC_Start();
     SetupEnvironment();
     SetupNetworking();
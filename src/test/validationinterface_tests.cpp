@@ -20,8 +20,14 @@
 #include <scheduler.h>
 #include <test/util/setup_common.h>
 #include <util/check.h>
+#include <util/thread.h>
+#include <util/time.h>
 #include <validationinterface.h>
 
+#include <atomic>
+#include <future>
+#include <vector>
+
 BOOST_FIXTURE_TEST_SUITE(validationinterface_tests, TestingSetup)
 
 struct TestSubscriberNoop final : public CValidationInterface {
@@ -103,4 +109,61 @@ BOOST_AUTO_TEST_CASE(unregister_all_during_call)
     BOOST_CHECK(destroyed);
 }
 
+class TestFlushSubscriber final : public CValidationInterface
+{
+public:
+    explicit TestFlushSubscriber(std::shared_future<void> wait = {}) : m_wait(std::move(wait)) {}
+    void ChainStateFlushed(const CBlockLocator& locator) override
+    {
+        if (m_wait.valid()) m_wait.wait();
+        m_seen.push_back(locator.vHave.size());
+    }
+    std::shared_future<void> m_wait;
+    std::vector<size_t> m_seen;
+};
+
+// A subscriber that is slow to process its notifications must not hold up
+// the others, while each of them still sees the notifications in order.
+BOOST_AUTO_TEST_CASE(subscriber_queues_independent)
+{
+    m_node.scheduler->m_extra_service_threads.emplace_back(util::TraceThread, "scheduler", [&] { m_node.scheduler->serviceQueue(); });
+
+    std::promise<void> release;
+    auto slow = std::make_shared<TestFlushSubscriber>(release.get_future().share());
+    auto fast = std::make_shared<TestFlushSubscriber>();
+    RegisterSharedValidationInterface(slow);
+    RegisterSharedValidationInterface(fast);
+
+    constexpr size_t NUM_EVENTS{20};
+    for (size_t i = 0; i < NUM_EVENTS; ++i) {
+        CBlockLocator locator;
+        locator.vHave.resize(i);
+        GetMainSignals().ChainStateFlushed(locator);
+    }
+
+    // The fast subscriber drains its queue while the slow one is stuck on
+    // its first notification
+    while (true) {
+        const ValidationQueueStats stats{GetMainSignals().GetQueueStats()};
+        BOOST_CHECK(stats.subscribers >= 2);
+        if (stats.callbacks_pending == NUM_EVENTS - 1 && stats.max_callbacks_pending == NUM_EVENTS - 1) break;
+        UninterruptibleSleep(std::chrono::milliseconds{10});
+    }
+    BOOST_CHECK(slow->m_seen.empty());
+
+    release.set_value();
+    SyncWithValidationInterfaceQueue();
+    BOOST_CHECK_EQUAL(GetMainSignals().CallbacksPending(), 0U);
+
+    for (const auto& sub : {slow, fast}) {
+        BOOST_REQUIRE_EQUAL(sub->m_seen.size(), NUM_EVENTS);
+        for (size_t i = 0; i < NUM_EVENTS; ++i) {
+            BOOST_CHECK_EQUAL(sub->m_seen[i], i);
+        }
+    }
+
+    UnregisterSharedValidationInterface(slow);
+    UnregisterSharedValidationInterface(fast);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -25,6 +25,7 @@
 #include <policy/settings.h>
 #include <reverse_iterator.h>
 #include <util/moneystr.h>
+#include <util/rbf.h>
 #include <util/system.h>
 #include <util/time.h>
 #include <validation.h>
@@ -56,6 +57,7 @@ void CTxMemPoolEntry::UpdateFeeDelta(int64_t newFeeDelta)
     nModFeesWithDescendants += newFeeDelta - feeDelta;
     nModFeesWithAncestors += newFeeDelta - feeDelta;
     feeDelta = newFeeDelta;
+    m_snapshot.reset();
 }
 
 void CTxMemPoolEntry::UpdateLockPoints(const LockPoints& lp)
@@ -73,8 +75,9 @@ size_t CTxMemPoolEntry::GetTxSize() const
 // descendants.
 void CTxMemPool::UpdateForDescendants(txiter updateIt, cacheMap &cachedDescendants, const std::set<uint256> &setExclude)
 {
-    CTxMemPoolEntry::Children stageEntries, descendants;
-    stageEntries = updateIt->GetMemPoolChildrenConst();
+    const CTxMemPoolEntry::Children& children = updateIt->GetMemPoolChildrenConst();
+    CTxMemPoolEntry::EntryRefs stageEntries(children.begin(), children.end());
+    CTxMemPoolEntry::EntryRefs descendants;
 
     while (!stageEntries.empty()) {
         const CTxMemPoolEntry& descendant = *stageEntries.begin();
@@ -121,6 +124,7 @@ void CTxMemPool::UpdateForDescendants(txiter updateIt, cacheMap &cachedDescendan
 void CTxMemPool::UpdateTransactionsFromBlock(const std::vector<uint256> &vHashesToUpdate)
 {
     AssertLockHeld(cs);
+    m_snapshot.reset();
     // For each entry in vHashesToUpdate, store the set of in-mempool, but not
     // in-vHashesToUpdate transactions, so that we don't have to recalculate
     // descendants when we come across a previously seen entry.
@@ -165,7 +169,7 @@ void CTxMemPool::UpdateTransactionsFromBlock(const std::vector<uint256> &vHashes
 
 bool CTxMemPool::CalculateMemPoolAncestors(const CTxMemPoolEntry &entry, setEntries &setAncestors, uint64_t limitAncestorCount, uint64_t limitAncestorSize, uint64_t limitDescendantCount, uint64_t limitDescendantSize, std::string &errString, bool fSearchForParents /* = true */) const
 {
-    CTxMemPoolEntry::Parents staged_ancestors;
+    CTxMemPoolEntry::EntryRefs staged_ancestors;
     const CTransaction &tx = entry.GetTx();
 
     if (fSearchForParents) {
@@ -186,7 +190,8 @@ bool CTxMemPool::CalculateMemPoolAncestors(const CTxMemPoolEntry &entry, setEntr
         // If we're not searching for parents, we require this to be an
         // entry in the mempool already.
         txiter it = mapTx.iterator_to(entry);
-        staged_ancestors = it->GetMemPoolParentsConst();
+        const CTxMemPoolEntry::Parents& parents = it->GetMemPoolParentsConst();
+        staged_ancestors.insert(parents.begin(), parents.end());
     }
 
     size_t totalSizeWithAncestors = entry.GetTxSize();
@@ -332,6 +337,7 @@ void CTxMemPoolEntry::UpdateDescendantState(int64_t modifySize, CAmount modifyFe
     nModFeesWithDescendants += modifyFee;
     nCountWithDescendants += modifyCount;
     assert(int64_t(nCountWithDescendants) > 0);
+    m_snapshot.reset();
 }
 
 void CTxMemPoolEntry::UpdateAncestorState(int64_t modifySize, CAmount modifyFee, int64_t modifyCount, int64_t modifySigOps)
@@ -343,6 +349,7 @@ void CTxMemPoolEntry::UpdateAncestorState(int64_t modifySize, CAmount modifyFee,
     assert(int64_t(nCountWithAncestors) > 0);
     nSigOpCostWithAncestors += modifySigOps;
     assert(int(nSigOpCostWithAncestors) >= 0);
+    m_snapshot.reset();
 }
 
 CTxMemPool::CTxMemPool(CBlockPolicyEstimator* estimator, int check_ratio)
@@ -409,6 +416,7 @@ void CTxMemPool::addUnchecked(const CTxMemPoolEntry &entry, setEntries &setAnces
     UpdateEntryForAncestors(newit, setAncestors);
 
     nTransactionsUpdated++;
+    m_snapshot.reset();
     totalTxSize += entry.GetTxSize();
     m_total_fee += entry.GetFee();
     if (minerPolicyEstimator) {
@@ -451,9 +459,10 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
     totalTxSize -= it->GetTxSize();
     m_total_fee -= it->GetFee();
     cachedInnerUsage -= it->DynamicMemoryUsage();
-    cachedInnerUsage -= memusage::DynamicUsage(it->GetMemPoolParentsConst()) + memusage::DynamicUsage(it->GetMemPoolChildrenConst());
+    cachedInnerUsage -= it->GetMemPoolParentsConst().DynamicMemoryUsage() + it->GetMemPoolChildrenConst().DynamicMemoryUsage();
     mapTx.erase(it);
     nTransactionsUpdated++;
+    m_snapshot.reset();
     if (minerPolicyEstimator) {minerPolicyEstimator->removeTx(hash, false);}
 }
 
@@ -618,6 +627,7 @@ void CTxMemPool::_clear()
     blockSinceLastRollingFeeBump = false;
     rollingMinimumFeeRate = 0;
     ++nTransactionsUpdated;
+    m_snapshot.reset();
 }
 
 void CTxMemPool::clear()
@@ -662,9 +672,9 @@ void CTxMemPool::check(CChainState& active_chainstate) const
         check_total_fee += it->GetFee();
         innerUsage += it->DynamicMemoryUsage();
         const CTransaction& tx = it->GetTx();
-        innerUsage += memusage::DynamicUsage(it->GetMemPoolParentsConst()) + memusage::DynamicUsage(it->GetMemPoolChildrenConst());
+        innerUsage += it->GetMemPoolParentsConst().DynamicMemoryUsage() + it->GetMemPoolChildrenConst().DynamicMemoryUsage();
         bool fDependsWait = false;
-        CTxMemPoolEntry::Parents setParentCheck;
+        CTxMemPoolEntry::EntryRefs setParentCheck;
         for (const CTxIn &txin : tx.vin) {
             // Check that every mempool transaction's inputs refer to available coins, or other mempool tx's.
             indexed_transaction_set::const_iterator it2 = mapTx.find(txin.prevout.hash);
@@ -710,7 +720,7 @@ void CTxMemPool::check(CChainState& active_chainstate) const
         assert(it->GetModFeesWithAncestors() == nFeesCheck);
 
         // Check children against mapNextTx
-        CTxMemPoolEntry::Children setChildrenCheck;
+        CTxMemPoolEntry::EntryRefs setChildrenCheck;
         auto iter = mapNextTx.lower_bound(COutPoint(it->GetTx().GetHash(), 0));
         uint64_t child_sizes = 0;
         for (; iter != mapNextTx.end() && iter->first->hash == it->GetTx().GetHash(); ++iter) {
@@ -834,6 +844,60 @@ std::vector<TxMempoolInfo> CTxMemPool::infoAll() const
     return ret;
 }
 
+TxMempoolEntrySnapshot CTxMemPool::MakeEntrySnapshot(const CTxMemPoolEntry& entry, bool bip125_replaceable) const
+{
+    AssertLockHeld(cs);
+    std::vector<uint256> parents;
+    parents.reserve(entry.GetMemPoolParentsConst().size());
+    for (const CTxMemPoolEntry& parent : entry.GetMemPoolParentsConst()) {
+        parents.push_back(parent.GetTx().GetHash());
+    }
+    std::vector<uint256> children;
+    children.reserve(entry.GetMemPoolChildrenConst().size());
+    for (const CTxMemPoolEntry& child : entry.GetMemPoolChildrenConst()) {
+        children.push_back(child.GetTx().GetHash());
+    }
+    return TxMempoolEntrySnapshot{
+        entry.GetSharedTx(), entry.GetFee(), entry.GetModifiedFee(), entry.GetTxSize(), entry.GetTxWeight(),
+        entry.GetTime(), entry.GetHeight(),
+        entry.GetCountWithDescendants(), entry.GetSizeWithDescendants(), entry.GetModFeesWithDescendants(),
+        entry.GetCountWithAncestors(), entry.GetSizeWithAncestors(), entry.GetModFeesWithAncestors(),
+        std::move(parents), std::move(children), bip125_replaceable, IsUnbroadcastTx(entry.GetTx().GetHash())};
+}
+
+TxMempoolEntrySnapshot CTxMemPool::GetEntrySnapshot(const CTxMemPoolEntry& entry) const
+{
+    AssertLockHeld(cs);
+    bool bip125_replaceable = SignalsOptInRBF(entry.GetTx());
+    if (!bip125_replaceable) {
+        setEntries ancestors;
+        uint64_t nNoLimit = std::numeric_limits<uint64_t>::max();
+        std::string dummy;
+        CalculateMemPoolAncestors(entry, ancestors, nNoLimit, nNoLimit, nNoLimit, nNoLimit, dummy, false);
+        bip125_replaceable = std::any_of(ancestors.begin(), ancestors.end(), [](txiter it) { return SignalsOptInRBF(it->GetTx()); });
+    }
+    return MakeEntrySnapshot(entry, bip125_replaceable);
+}
+
+std::shared_ptr<const MempoolSnapshot> CTxMemPool::GetSnapshot() const
+{
+    LOCK(cs);
+    if (m_snapshot) return m_snapshot;
+
+    auto snapshot = std::make_shared<MempoolSnapshot>();
+    snapshot->reserve(mapTx.size());
+    for (const CTxMemPoolEntry& entry : mapTx) {
+        // Only entries whose state changed since the last snapshot are copied
+        // again, the others are shared with it.
+        if (!entry.m_snapshot) {
+            entry.m_snapshot = std::make_shared<const TxMempoolEntrySnapshot>(GetEntrySnapshot(entry));
+        }
+        snapshot->push_back(entry.m_snapshot);
+    }
+    m_snapshot = snapshot;
+    return m_snapshot;
+}
+
 CTransactionRef CTxMemPool::get(const uint256& hash) const
 {
     LOCK(cs);
@@ -879,6 +943,7 @@ void CTxMemPool::PrioritiseTransaction(const uint256& hash, const CAmount& nFeeD
                 mapTx.modify(descendantIt, update_ancestor_state(0, nFeeDelta, 0, 0));
             }
             ++nTransactionsUpdated;
+            m_snapshot.reset();
         }
     }
     LogPrintf("PrioritiseTransaction: %s feerate += %s\n", hash.ToString(), FormatMoney(nFeeDelta));
@@ -974,6 +1039,9 @@ void CTxMemPool::RemoveUnbroadcastTx(const uint256& txid, const bool unchecked)
 
     if (m_unbroadcast_txids.erase(txid))
     {
+        auto it = mapTx.find(txid);
+        if (it != mapTx.end()) it->m_snapshot.reset();
+        m_snapshot.reset();
         LogPrint(BCLog::MEMPOOL, "Removed %i from set of unbroadcast txns%s\n", txid.GetHex(), (unchecked ? " before confirmation that txn was sent out" : ""));
     }
 }
@@ -1015,23 +1083,29 @@ void CTxMemPool::addUnchecked(const CTxMemPoolEntry &entry, bool validFeeEstimat
 void CTxMemPool::UpdateChild(txiter entry, txiter child, bool add)
 {
     AssertLockHeld(cs);
-    CTxMemPoolEntry::Children s;
-    if (add && entry->GetMemPoolChildren().insert(*child).second) {
-        cachedInnerUsage += memusage::IncrementalDynamicUsage(s);
-    } else if (!add && entry->GetMemPoolChildren().erase(*child)) {
-        cachedInnerUsage -= memusage::IncrementalDynamicUsage(s);
+    CTxMemPoolEntry::Children& children = entry->GetMemPoolChildren();
+    cachedInnerUsage -= children.DynamicMemoryUsage();
+    if (add) {
+        children.insert(*child);
+    } else {
+        children.erase(*child);
     }
+    cachedInnerUsage += children.DynamicMemoryUsage();
+    entry->m_snapshot.reset();
 }
 
 void CTxMemPool::UpdateParent(txiter entry, txiter parent, bool add)
 {
     AssertLockHeld(cs);
-    CTxMemPoolEntry::Parents s;
-    if (add && entry->GetMemPoolParents().insert(*parent).second) {
-        cachedInnerUsage += memusage::IncrementalDynamicUsage(s);
-    } else if (!add && entry->GetMemPoolParents().erase(*parent)) {
-        cachedInnerUsage -= memusage::IncrementalDynamicUsage(s);
+    CTxMemPoolEntry::Parents& parents = entry->GetMemPoolParents();
+    cachedInnerUsage -= parents.DynamicMemoryUsage();
+    if (add) {
+        parents.insert(*parent);
+    } else {
+        parents.erase(*parent);
     }
+    cachedInnerUsage += parents.DynamicMemoryUsage();
+    entry->m_snapshot.reset();
 }
 
 CFeeRate CTxMemPool::GetMinFee(size_t sizelimit) const {
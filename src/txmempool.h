@@ -18,8 +18,10 @@
 #ifndef BITCOIN_TXMEMPOOL_H
 #define BITCOIN_TXMEMPOOL_H
 
+#include <algorithm>
 #include <atomic>
 #include <map>
+#include <memory>
 #include <optional>
 #include <set>
 #include <string>
@@ -29,7 +31,9 @@
 #include <amount.h>
 #include <coins.h>
 #include <indirectmap.h>
+#include <memusage.h>
 #include <policy/feerate.h>
+#include <prevector.h>
 #include <primitives/transaction.h>
 #include <random.h>
 #include <sync.h>
@@ -78,6 +82,80 @@ struct CompareIteratorByHash {
     }
 };
 
+/**
+ * Set of mempool entries ordered by txid, used for the direct in-mempool
+ * parents and children of a CTxMemPoolEntry.
+ *
+ * Entries are stored as pointers in a sorted prevector: up to two relatives
+ * (the common case) need no allocation at all, and larger sets need a single
+ * one instead of a tree node per edge.
+ */
+template <typename Entry>
+class MemPoolEntryRefSet
+{
+private:
+    typedef prevector<2, const Entry*> container_type;
+    container_type m_entries;
+
+    static bool CompareByHash(const Entry* a, const Entry* b)
+    {
+        return a->GetTx().GetHash() < b->GetTx().GetHash();
+    }
+
+    typename container_type::iterator LowerBound(const Entry& entry)
+    {
+        return std::lower_bound(m_entries.begin(), m_entries.end(), &entry, CompareByHash);
+    }
+
+public:
+    class const_iterator
+    {
+    private:
+        typename container_type::const_iterator m_it;
+
+    public:
+        typedef std::ptrdiff_t difference_type;
+        typedef Entry value_type;
+        typedef const Entry* pointer;
+        typedef const Entry& reference;
+        typedef std::forward_iterator_tag iterator_category;
+
+        explicit const_iterator(typename container_type::const_iterator it) : m_it(it) {}
+        const Entry& operator*() const { return **m_it; }
+        const Entry* operator->() const { return *m_it; }
+        const_iterator& operator++() { ++m_it; return *this; }
+        const_iterator operator++(int) { const_iterator copy(*this); ++m_it; return copy; }
+        bool operator==(const const_iterator& other) const { return m_it == other.m_it; }
+        bool operator!=(const const_iterator& other) const { return m_it != other.m_it; }
+    };
+
+    const_iterator begin() const { return const_iterator(m_entries.begin()); }
+    const_iterator end() const { return const_iterator(m_entries.end()); }
+    size_t size() const { return m_entries.size(); }
+    bool empty() const { return m_entries.empty(); }
+
+    /** Add an entry. Returns false if it was already present. */
+    bool insert(const Entry& entry)
+    {
+        const auto it = LowerBound(entry);
+        if (it != m_entries.end() && *it == &entry) return false;
+        m_entries.insert(it, &entry);
+        return true;
+    }
+
+    /** Remove an entry. Returns the number of entries removed (0 or 1). */
+    size_t erase(const Entry& entry)
+    {
+        const auto it = LowerBound(entry);
+        if (it == m_entries.end() || *it != &entry) return 0;
+        m_entries.erase(it);
+        if (m_entries.size() <= 2) m_entries.shrink_to_fit();
+        return 1;
+    }
+
+    size_t DynamicMemoryUsage() const { return memusage::DynamicUsage(m_entries); }
+};
+
 /** \class CTxMemPoolEntry
  *
  * CTxMemPoolEntry stores data about the corresponding transaction, as well
@@ -90,13 +168,17 @@ struct CompareIteratorByHash {
  *
  */
 
+struct TxMempoolEntrySnapshot;
+
 class CTxMemPoolEntry
 {
 public:
     typedef std::reference_wrapper<const CTxMemPoolEntry> CTxMemPoolEntryRef;
     // two aliases, should the types ever diverge
-    typedef std::set<CTxMemPoolEntryRef, CompareIteratorByHash> Parents;
-    typedef std::set<CTxMemPoolEntryRef, CompareIteratorByHash> Children;
+    typedef MemPoolEntryRefSet<CTxMemPoolEntry> Parents;
+    typedef MemPoolEntryRefSet<CTxMemPoolEntry> Children;
+    //! Ordered set of entries, used for staging entries while walking the graph
+    typedef std::set<CTxMemPoolEntryRef, CompareIteratorByHash> EntryRefs;
 
 private:
     const CTransactionRef tx;
@@ -171,6 +253,8 @@ public:
 
     mutable size_t vTxHashesIdx; //!< Index in mempool's vTxHashes
     mutable Epoch::Marker m_epoch_marker; //!< epoch when last touched, useful for graph algorithms
+    //! Copy of this entry's state published by CTxMemPool::GetSnapshot(), reset whenever the state changes
+    mutable std::shared_ptr<const TxMempoolEntrySnapshot> m_snapshot;
 };
 
 // Helpers for modifying CTxMemPool::mapTx, which is a boost multi_index.
@@ -401,6 +485,38 @@ struct TxMempoolInfo
     int64_t nFeeDelta;
 };
 
+/**
+ * Copy of the state of a mempool entry and its links to other entries, which
+ * can be read without holding the mempool lock.
+ */
+struct TxMempoolEntrySnapshot
+{
+    CTransactionRef tx;
+    CAmount fee;
+    CAmount modified_fee;
+    size_t vsize;
+    size_t weight;
+    std::chrono::seconds time;
+    unsigned int height;
+    uint64_t count_with_descendants;
+    uint64_t size_with_descendants;
+    CAmount mod_fees_with_descendants;
+    uint64_t count_with_ancestors;
+    uint64_t size_with_ancestors;
+    CAmount mod_fees_with_ancestors;
+    /** Txids of the in-mempool parents, sorted */
+    std::vector<uint256> parents;
+    /** Txids of the in-mempool children, sorted */
+    std::vector<uint256> children;
+    /** Whether the transaction or any of its in-mempool ancestors signals BIP125 replaceability */
+    bool bip125_replaceable;
+    /** Whether the transaction is in the unbroadcast set */
+    bool unbroadcast;
+};
+
+/** Entries of a mempool snapshot. Entries that did not change are shared between snapshots. */
+typedef std::vector<std::shared_ptr<const TxMempoolEntrySnapshot>> MempoolSnapshot;
+
 /** Reason why a transaction was removed from the mempool,
  * this is passed to the notification signal.
  */
@@ -511,6 +627,11 @@ protected:
 
     bool m_is_loaded GUARDED_BY(cs){false};
 
+    //! Snapshot of all entries returned by GetSnapshot(), reset whenever the mempool changes
+    mutable std::shared_ptr<const MempoolSnapshot> m_snapshot GUARDED_BY(cs);
+
+    TxMempoolEntrySnapshot MakeEntrySnapshot(const CTxMemPoolEntry& entry, bool bip125_replaceable) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+
 public:
 
     static const int ROLLING_FEE_HALFLIFE = 60 * 60 * 12; // public only for testing
@@ -765,6 +886,17 @@ public:
     TxMempoolInfo info(const GenTxid& gtxid) const;
     std::vector<TxMempoolInfo> infoAll() const;
 
+    /**
+     * Return a read-only copy of the state of all entries, which callers can
+     * iterate without holding cs. The same copy is handed out until the
+     * mempool changes. The next one is then published from the immutable
+     * per-entry copies, of which only those of the changed entries are made
+     * again. The copies are not counted in DynamicMemoryUsage().
+     */
+    std::shared_ptr<const MempoolSnapshot> GetSnapshot() const;
+    /** Return a copy of the state of a single entry. */
+    TxMempoolEntrySnapshot GetEntrySnapshot(const CTxMemPoolEntry& entry) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+
     size_t DynamicMemoryUsage() const;
 
     /** Adds a transaction to the unbroadcast set */
@@ -773,7 +905,11 @@ public:
         LOCK(cs);
         // Sanity check the transaction is in the mempool & insert into
         // unbroadcast set.
-        if (exists(txid)) m_unbroadcast_txids.insert(txid);
+        auto it = mapTx.find(txid);
+        if (it != mapTx.end() && m_unbroadcast_txids.insert(txid).second) {
+            it->m_snapshot.reset();
+            m_snapshot.reset();
+        }
     };
 
     /** Removes a transaction from the unbroadcast set */
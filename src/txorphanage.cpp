@@ -20,6 +20,7 @@
 #include <logging.h>
 #include <policy/policy.h>
 
+#include <algorithm>
 #include <cassert>
 
 /** Expiration time for orphan transactions in seconds */
@@ -51,9 +52,11 @@ bool TxOrphanage::AddTx(const CTransactionRef& tx, NodeId peer)
         return false;
     }
 
-    auto ret = m_orphans.emplace(hash, OrphanTx{tx, peer, GetTime() + ORPHAN_TX_EXPIRE_TIME, m_orphan_list.size()});
+    PeerOrphans& peer_orphans = m_peer_orphans[peer];
+    auto ret = m_orphans.emplace(hash, OrphanTx{tx, peer, GetTime() + ORPHAN_TX_EXPIRE_TIME, sz, peer_orphans.orphans.size()});
     assert(ret.second);
-    m_orphan_list.push_back(ret.first);
+    peer_orphans.orphans.push_back(ret.first);
+    peer_orphans.total_weight += sz;
     // Allow for lookups in the orphan pool by wtxid, as well as txid
     m_wtxid_to_orphan_it.emplace(tx->GetWitnessHash(), ret.first);
     for (const CTxIn& txin : tx->vin) {
@@ -81,16 +84,21 @@ int TxOrphanage::EraseTx(const uint256& txid)
             m_outpoint_to_orphan_it.erase(itPrev);
     }
 
-    size_t old_pos = it->second.list_pos;
-    assert(m_orphan_list[old_pos] == it);
-    if (old_pos + 1 != m_orphan_list.size()) {
-        // Unless we're deleting the last entry in m_orphan_list, move the last
+    const auto peer_it = m_peer_orphans.find(it->second.fromPeer);
+    assert(peer_it != m_peer_orphans.end());
+    std::vector<OrphanMap::iterator>& peer_list = peer_it->second.orphans;
+    size_t old_pos = it->second.peer_list_pos;
+    assert(peer_list[old_pos] == it);
+    if (old_pos + 1 != peer_list.size()) {
+        // Unless we're deleting the last entry in the peer's list, move the last
         // entry to the position we're deleting.
-        auto it_last = m_orphan_list.back();
-        m_orphan_list[old_pos] = it_last;
-        it_last->second.list_pos = old_pos;
+        auto it_last = peer_list.back();
+        peer_list[old_pos] = it_last;
+        it_last->second.peer_list_pos = old_pos;
     }
-    m_orphan_list.pop_back();
+    peer_list.pop_back();
+    peer_it->second.total_weight -= it->second.weight;
+    if (peer_list.empty()) m_peer_orphans.erase(peer_it);
     m_wtxid_to_orphan_it.erase(it->second.tx->GetWitnessHash());
 
     m_orphans.erase(it);
@@ -102,19 +110,22 @@ void TxOrphanage::EraseForPeer(NodeId peer)
     AssertLockHeld(g_cs_orphans);
 
     int nErased = 0;
-    std::map<uint256, OrphanTx>::iterator iter = m_orphans.begin();
-    while (iter != m_orphans.end())
-    {
-        std::map<uint256, OrphanTx>::iterator maybeErase = iter++; // increment to avoid iterator becoming invalid
-        if (maybeErase->second.fromPeer == peer)
-        {
-            nErased += EraseTx(maybeErase->second.tx->GetHash());
-        }
+    // EraseTx removes the peer's entry along with its last orphan
+    while (m_peer_orphans.count(peer)) {
+        nErased += EraseTx(m_peer_orphans.at(peer).orphans.back()->first);
     }
     if (nErased > 0) LogPrint(BCLog::MEMPOOL, "Erased %d orphan tx from peer=%d\n", nErased, peer);
 }
 
-unsigned int TxOrphanage::LimitOrphans(unsigned int max_orphans)
+void TxOrphanage::EvictRandomFromPeer(NodeId peer, FastRandomContext& rng)
+{
+    AssertLockHeld(g_cs_orphans);
+
+    const std::vector<OrphanMap::iterator>& peer_list = m_peer_orphans.at(peer).orphans;
+    EraseTx(peer_list[rng.randrange(peer_list.size())]->first);
+}
+
+unsigned int TxOrphanage::LimitOrphans(unsigned int max_orphans, unsigned int max_peer_weight)
 {
     AssertLockHeld(g_cs_orphans);
 
@@ -140,11 +151,24 @@ unsigned int TxOrphanage::LimitOrphans(unsigned int max_orphans)
         if (nErased > 0) LogPrint(BCLog::MEMPOOL, "Erased %d orphan tx due to expiration\n", nErased);
     }
     FastRandomContext rng;
+    // Keep the orphans of each peer within the peer's budget
+    std::vector<NodeId> peers_over_budget;
+    for (const auto& [peer, peer_orphans] : m_peer_orphans) {
+        if (peer_orphans.total_weight > max_peer_weight) peers_over_budget.push_back(peer);
+    }
+    for (const NodeId peer : peers_over_budget) {
+        while (PeerWeight(peer) > max_peer_weight) {
+            EvictRandomFromPeer(peer, rng);
+            ++nEvicted;
+        }
+    }
     while (m_orphans.size() > max_orphans)
     {
-        // Evict a random orphan:
-        size_t randompos = rng.randrange(m_orphan_list.size());
-        EraseTx(m_orphan_list[randompos]->first);
+        // Evict a random orphan of the peer which announced the most; their
+        // weight is already bounded per peer above
+        const auto largest = std::max_element(m_peer_orphans.begin(), m_peer_orphans.end(),
+            [](const auto& a, const auto& b) { return a.second.orphans.size() < b.second.orphans.size(); });
+        EvictRandomFromPeer(largest->first, rng);
         ++nEvicted;
     }
     return nEvicted;
@@ -163,6 +187,33 @@ void TxOrphanage::AddChildrenToWorkSet(const CTransaction& tx, std::set<uint256>
     }
 }
 
+std::vector<std::pair<CTransactionRef, NodeId>> TxOrphanage::GetChildren(const CTransaction& parent) const
+{
+    AssertLockHeld(g_cs_orphans);
+
+    std::set<OrphanMap::iterator, IteratorComparator> children;
+    for (unsigned int i = 0; i < parent.vout.size(); i++) {
+        const auto it_by_prev = m_outpoint_to_orphan_it.find(COutPoint(parent.GetHash(), i));
+        if (it_by_prev != m_outpoint_to_orphan_it.end()) {
+            children.insert(it_by_prev->second.begin(), it_by_prev->second.end());
+        }
+    }
+    std::vector<std::pair<CTransactionRef, NodeId>> ret;
+    ret.reserve(children.size());
+    for (const auto& child : children) {
+        ret.emplace_back(child->second.tx, child->second.fromPeer);
+    }
+    return ret;
+}
+
+unsigned int TxOrphanage::PeerWeight(NodeId peer) const
+{
+    AssertLockHeld(g_cs_orphans);
+
+    const auto it = m_peer_orphans.find(peer);
+    return it == m_peer_orphans.end() ? 0 : it->second.total_weight;
+}
+
 bool TxOrphanage::HaveTx(const GenTxid& gtxid) const
 {
     LOCK(g_cs_orphans);
@@ -20,6 +20,7 @@
 #include <net.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
+#include <random.h>
 #include <sync.h>
 
 /** Guards orphan transactions and extra txs for compact blocks */
@@ -28,7 +29,9 @@ extern RecursiveMutex g_cs_orphans;
 /** A class to track orphan transactions (failed on TX_MISSING_INPUTS)
  * Since we cannot distinguish orphans from bad transactions with
  * non-existent inputs, we heavily limit the number of orphans
- * we keep and the duration we keep them for.
+ * we keep and the duration we keep them for. The orphans announced
+ * by each peer are accounted separately, so that a single peer
+ * cannot crowd out the orphans of the others.
  */
 class TxOrphanage {
 public:
@@ -52,19 +55,28 @@ public:
     /** Erase all orphans included in or invalidated by a new block */
     void EraseForBlock(const CBlock& block) LOCKS_EXCLUDED(::g_cs_orphans);
 
-    /** Limit the orphanage to the given maximum */
-    unsigned int LimitOrphans(unsigned int max_orphans) EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans);
+    /** Limit the orphanage to the given maximum number of orphans, and the orphans
+     *  announced by each peer to the given total weight. Orphans over the count
+     *  limit are evicted from the peers which announced the most first. */
+    unsigned int LimitOrphans(unsigned int max_orphans, unsigned int max_peer_weight) EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans);
 
     /** Add any orphans that list a particular tx as a parent into a peer's work set
      * (ie orphans that may have found their final missing parent, and so should be reconsidered for the mempool) */
     void AddChildrenToWorkSet(const CTransaction& tx, std::set<uint256>& orphan_work_set) const EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans);
 
+    /** Get the orphans spending an output of a transaction, and the peers which announced them */
+    std::vector<std::pair<CTransactionRef, NodeId>> GetChildren(const CTransaction& parent) const EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans);
+
+    /** Total weight of the orphans announced by a peer */
+    unsigned int PeerWeight(NodeId peer) const EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans);
+
 protected:
     struct OrphanTx {
         CTransactionRef tx;
         NodeId fromPeer;
         int64_t nTimeExpire;
-        size_t list_pos;
+        unsigned int weight;
+        size_t peer_list_pos;
     };
 
     /** Map from txid to orphan transaction record. Limited by
@@ -86,8 +98,19 @@ protected:
      *  to remove orphan transactions from the m_orphans */
     std::map<COutPoint, std::set<OrphanMap::iterator, IteratorComparator>> m_outpoint_to_orphan_it GUARDED_BY(g_cs_orphans);
 
-    /** Orphan transactions in vector for quick random eviction */
-    std::vector<OrphanMap::iterator> m_orphan_list GUARDED_BY(g_cs_orphans);
+    /** Orphans announced by a single peer */
+    struct PeerOrphans {
+        /** The peer's orphan transactions in vector for quick random eviction */
+        std::vector<OrphanMap::iterator> orphans;
+        /** Total weight of the peer's orphan transactions */
+        unsigned int total_weight{0};
+    };
+
+    /** Orphan transactions by the peer which announced them */
+    std::map<NodeId, PeerOrphans> m_peer_orphans GUARDED_BY(g_cs_orphans);
+
+    /** Evict a random orphan announced by the given peer */
+    void EvictRandomFromPeer(NodeId peer, FastRandomContext& rng) EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans);
 
     /** Index from wtxid into the m_orphans to lookup orphan
      *  transactions using their witness ids. */
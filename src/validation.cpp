@@ -66,6 +66,7 @@
 #include <numeric>
 #include <optional>
 #include <string>
+#include <unordered_map>
 
 #include <boost/algorithm/string/replace.hpp>
 
@@ -420,7 +421,8 @@ static void UpdateMempoolForReorg(CChainState& active_chainstate, CTxMemPool& me
 * */
 static bool CheckInputsFromMempoolAndCache(const CTransaction& tx, TxValidationState& state,
                 const CCoinsViewCache& view, const CTxMemPool& pool,
-                unsigned int flags, PrecomputedTransactionData& txdata, CCoinsViewCache& coins_tip)
+                unsigned int flags, PrecomputedTransactionData& txdata, CCoinsViewCache& coins_tip,
+                const std::vector<CTransactionRef>& package_txns = {})
                 EXCLUSIVE_LOCKS_REQUIRED(cs_main, pool.cs)
 {
     AssertLockHeld(cs_main);
@@ -435,11 +437,17 @@ static bool CheckInputsFromMempoolAndCache(const CTransaction& tx, TxValidationS
         Assume(!coin.IsSpent());
         if (coin.IsSpent()) return false;
 
-        // If the Coin is available, there are 2 possibilities:
+        // If the Coin is available, there are 3 possibilities:
         // it is available in our current ChainstateActive UTXO set,
-        // or it's a UTXO provided by a transaction in our mempool.
+        // or it's a UTXO provided by a transaction in our mempool,
+        // or by a transaction of the package being submitted.
         // Ensure the scriptPubKeys in Coins from CoinsView are correct.
-        const CTransactionRef& txFrom = pool.get(txin.prevout.hash);
+        CTransactionRef txFrom = pool.get(txin.prevout.hash);
+        if (!txFrom) {
+            const auto it = std::find_if(package_txns.begin(), package_txns.end(),
+                                         [&](const CTransactionRef& ptx) { return ptx->GetHash() == txin.prevout.hash; });
+            if (it != package_txns.end()) txFrom = *it;
+        }
         if (txFrom) {
             assert(txFrom->GetHash() == txin.prevout.hash);
             assert(txFrom->vout.size() > txin.prevout.n);
@@ -456,6 +464,9 @@ static bool CheckInputsFromMempoolAndCache(const CTransaction& tx, TxValidationS
     return CheckInputScripts(tx, state, view, flags, /* cacheSigStore = */ true, /* cacheFullSciptStore = */ true, txdata);
 }
 
+/** Script checks of block connection and of package acceptance, both done under cs_main */
+static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
+
 namespace {
 
 class MemPoolAccept
@@ -486,6 +497,12 @@ public:
         const bool m_test_accept;
         /** Disable BIP125 RBFing; disallow all conflicts with mempool transactions. */
         const bool disallow_mempool_conflicts;
+        /**
+         * Submitting a package to the mempool: check the feerate of the package as
+         * a whole rather than of each transaction, and only limit the mempool size
+         * once all of its transactions have been added.
+         */
+        const bool m_package_submission;
     };
 
     // Single transaction acceptance
@@ -518,6 +535,9 @@ private:
         const CTransactionRef& m_ptx;
         const uint256& m_hash;
         TxValidationState m_state;
+        /** Script verification data computed by PolicyScriptChecks and reused by
+         *  ConsensusScriptChecks */
+        PrecomputedTransactionData m_precomputed_txdata;
     };
 
     // Run the policy checks on a given transaction, excluding any script checks.
@@ -530,27 +550,45 @@ private:
     // only invoke this on transactions that have otherwise passed policy checks.
     bool PolicyScriptChecks(const ATMPArgs& args, Workspace& ws, PrecomputedTransactionData& txdata) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
 
+    // Run the policy script checks of all transactions in a package at once on
+    // the script check queue. Returns false if any check failed, without telling
+    // which; PolicyScriptChecks() must then be run on each transaction to find out.
+    bool PackageScriptChecks(std::vector<Workspace>& workspaces) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
+
     // Re-run the script checks, using consensus flags, and try to cache the
     // result in the scriptcache. This should be done after
     // PolicyScriptChecks(). This requires that all inputs either be in our
-    // utxo set or in the mempool.
-    bool ConsensusScriptChecks(const ATMPArgs& args, Workspace& ws, PrecomputedTransactionData &txdata) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
+    // utxo set, in the mempool or created by one of package_txns.
+    bool ConsensusScriptChecks(const ATMPArgs& args, Workspace& ws, PrecomputedTransactionData &txdata,
+                               const std::vector<CTransactionRef>& package_txns = {}) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
 
     // Try to add the transaction to the mempool, removing any conflicts first.
     // Returns true if the transaction is in the mempool after any size
     // limiting is performed, false otherwise.
     bool Finalize(const ATMPArgs& args, Workspace& ws) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
 
+    // Check the mempool chain limits for a package that passed PreChecks, as
+    // if it was a single transaction spending the in-mempool ancestors of all
+    // of its transactions.
+    bool CheckPackageLimits(const std::vector<Workspace>& workspaces, size_t package_size, PackageValidationState& package_state) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
+
+    // Add all transactions of a package that passed the policy checks to the
+    // mempool, in order. Returns true if all of them are in the mempool after
+    // size limiting is performed. Otherwise none of them is left in the mempool
+    // and false is returned.
+    bool SubmitPackage(const ATMPArgs& args, std::vector<Workspace>& workspaces, PackageValidationState& package_state,
+                       std::map<const uint256, const MempoolAcceptResult>& results) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
+
     // Compare a package's feerate against minimum allowed.
     bool CheckFeeRate(size_t package_size, CAmount package_fee, TxValidationState& state) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs)
     {
         CAmount mempoolRejectFee = m_pool.GetMinFee(gArgs.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000).GetFee(package_size);
         if (mempoolRejectFee > 0 && package_fee < mempoolRejectFee) {
-            return state.Invalid(TxValidationResult::TX_MEMPOOL_POLICY, "mempool min fee not met", strprintf("%d < %d", package_fee, mempoolRejectFee));
+            return state.Invalid(TxValidationResult::TX_RECONSIDERABLE, "mempool min fee not met", strprintf("%d < %d", package_fee, mempoolRejectFee));
         }
 
         if (package_fee < ::minRelayTxFee.GetFee(package_size)) {
-            return state.Invalid(TxValidationResult::TX_MEMPOOL_POLICY, "min relay fee not met", strprintf("%d < %d", package_fee, ::minRelayTxFee.GetFee(package_size)));
+            return state.Invalid(TxValidationResult::TX_RECONSIDERABLE, "min relay fee not met", strprintf("%d < %d", package_fee, ::minRelayTxFee.GetFee(package_size)));
         }
         return true;
     }
@@ -752,8 +790,8 @@ bool MemPoolAccept::PreChecks(ATMPArgs& args, Workspace& ws)
                 strprintf("%d", nSigOpsCost));
 
     // No transactions are allowed below minRelayTxFee except from disconnected
-    // blocks
-    if (!bypass_limits && !CheckFeeRate(nSize, nModifiedFees, state)) return false;
+    // blocks. The feerate of a package is checked as a whole instead.
+    if (!bypass_limits && !args.m_package_submission && !CheckFeeRate(nSize, nModifiedFees, state)) return false;
 
     const CTxMemPool::setEntries setIterConflicting = m_pool.GetIterSet(setConflicts);
     // Calculate in-mempool ancestors, up to a limit.
@@ -973,7 +1011,22 @@ bool MemPoolAccept::PolicyScriptChecks(const ATMPArgs& args, Workspace& ws, Prec
     return true;
 }
 
-bool MemPoolAccept::ConsensusScriptChecks(const ATMPArgs& args, Workspace& ws, PrecomputedTransactionData& txdata)
+bool MemPoolAccept::PackageScriptChecks(std::vector<Workspace>& workspaces)
+{
+    CCheckQueueControl<CScriptCheck> control(&scriptcheckqueue);
+    for (Workspace& ws : workspaces) {
+        std::vector<CScriptCheck> checks;
+        TxValidationState state_dummy; // Failures are reported by PolicyScriptChecks
+        if (!CheckInputScripts(*ws.m_ptx, state_dummy, m_view, STANDARD_SCRIPT_VERIFY_FLAGS, true, false, ws.m_precomputed_txdata, &checks)) {
+            return false;
+        }
+        control.Add(checks);
+    }
+    return control.Wait();
+}
+
+bool MemPoolAccept::ConsensusScriptChecks(const ATMPArgs& args, Workspace& ws, PrecomputedTransactionData& txdata,
+                                          const std::vector<CTransactionRef>& package_txns)
 {
     const CTransaction& tx = *ws.m_ptx;
     const uint256& hash = ws.m_hash;
@@ -998,7 +1051,7 @@ bool MemPoolAccept::ConsensusScriptChecks(const ATMPArgs& args, Workspace& ws, P
     assert(std::addressof(::ChainActive()) == std::addressof(m_active_chainstate.m_chain));
     unsigned int currentBlockScriptVerifyFlags = GetBlockScriptFlags(m_active_chainstate.m_chain.Tip(), chainparams.GetConsensus());
     assert(std::addressof(::ChainstateActive().CoinsTip()) == std::addressof(m_active_chainstate.CoinsTip()));
-    if (!CheckInputsFromMempoolAndCache(tx, state, m_view, m_pool, currentBlockScriptVerifyFlags, txdata, m_active_chainstate.CoinsTip())) {
+    if (!CheckInputsFromMempoolAndCache(tx, state, m_view, m_pool, currentBlockScriptVerifyFlags, txdata, m_active_chainstate.CoinsTip(), package_txns)) {
         return error("%s: BUG! PLEASE REPORT THIS! CheckInputScripts failed against latest-block but not STANDARD flags %s, %s",
                 __func__, hash.ToString(), state.ToString());
     }
@@ -1044,8 +1097,9 @@ bool MemPoolAccept::Finalize(const ATMPArgs& args, Workspace& ws)
     // Store transaction in memory
     m_pool.addUnchecked(*entry, setAncestors, validForFeeEstimation);
 
-    // trim mempool and check if tx was trimmed
-    if (!bypass_limits) {
+    // trim mempool and check if tx was trimmed (packages are trimmed once all
+    // their transactions are added, see SubmitPackage)
+    if (!bypass_limits && !args.m_package_submission) {
         assert(std::addressof(::ChainstateActive().CoinsTip()) == std::addressof(m_active_chainstate.CoinsTip()));
         LimitMempoolSize(m_pool, m_active_chainstate.CoinsTip(), gArgs.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000, std::chrono::hours{gArgs.GetArg("-mempoolexpiry", DEFAULT_MEMPOOL_EXPIRY)});
         if (!m_pool.exists(hash))
@@ -1067,11 +1121,9 @@ MempoolAcceptResult MemPoolAccept::AcceptSingleTransaction(const CTransactionRef
     // scripts (ie, other policy checks pass). We perform the inexpensive
     // checks first and avoid hashing and signature verification unless those
     // checks pass, to mitigate CPU exhaustion denial-of-service attacks.
-    PrecomputedTransactionData txdata;
-
-    if (!PolicyScriptChecks(args, ws, txdata)) return MempoolAcceptResult::Failure(ws.m_state);
+    if (!PolicyScriptChecks(args, ws, ws.m_precomputed_txdata)) return MempoolAcceptResult::Failure(ws.m_state);
 
-    if (!ConsensusScriptChecks(args, ws, txdata)) return MempoolAcceptResult::Failure(ws.m_state);
+    if (!ConsensusScriptChecks(args, ws, ws.m_precomputed_txdata)) return MempoolAcceptResult::Failure(ws.m_state);
 
     // Tx was accepted, but not added
     if (args.m_test_accept) {
@@ -1129,6 +1181,13 @@ PackageMempoolAcceptResult MemPoolAccept::AcceptMultipleTransactions(const std::
             workspaces.emplace_back(Workspace(tx));
         }
     }
+    // A package is only submitted as a child and its parents, so that the
+    // fees of the child can pay for its parents but not for unrelated
+    // transactions.
+    if (args.m_package_submission && !IsChildWithParents(txns)) {
+        package_state.Invalid(PackageValidationResult::PCKG_POLICY, "package-not-child-with-parents");
+        return PackageMempoolAcceptResult(package_state, {});
+    }
     std::map<const uint256, const MempoolAcceptResult> results;
     {
         // Don't allow any conflicting transactions, i.e. spending the same inputs, in a package.
@@ -1167,9 +1226,35 @@ PackageMempoolAcceptResult MemPoolAccept::AcceptMultipleTransactions(const std::
         m_viewmempool.PackageAddTransaction(ws.m_ptx);
     }
 
+    if (args.m_package_submission) {
+        const CAmount package_fees = std::accumulate(workspaces.cbegin(), workspaces.cend(), CAmount{0},
+                                     [](CAmount sum, const auto& ws) { return sum + ws.m_modified_fees; });
+        const size_t package_size = std::accumulate(workspaces.cbegin(), workspaces.cend(), size_t{0},
+                                    [](size_t sum, const auto& ws) { return sum + ws.m_entry->GetTxSize(); });
+        TxValidationState fee_state;
+        if (!args.m_bypass_limits && !CheckFeeRate(package_size, package_fees, fee_state)) {
+            package_state.Invalid(PackageValidationResult::PCKG_POLICY, "package-fee-too-low", fee_state.GetRejectReason());
+            return PackageMempoolAcceptResult(package_state, std::move(results));
+        }
+        // The parents may pay for themselves, but must not pay for the child.
+        const Workspace& child_ws = workspaces.back();
+        if (CFeeRate(child_ws.m_modified_fees, child_ws.m_entry->GetTxSize()) < CFeeRate(package_fees, package_size)) {
+            package_state.Invalid(PackageValidationResult::PCKG_POLICY, "package-child-feerate-too-low");
+            return PackageMempoolAcceptResult(package_state, std::move(results));
+        }
+        if (!CheckPackageLimits(workspaces, package_size, package_state)) {
+            return PackageMempoolAcceptResult(package_state, std::move(results));
+        }
+    }
+
+    // Spread the script checks of the whole package over the script check
+    // threads. Only if this fails are the transactions checked one by one, to
+    // find the one that failed.
+    const bool scripts_checked{g_parallel_script_checks && workspaces.size() > 1 && PackageScriptChecks(workspaces)};
+
     for (Workspace& ws : workspaces) {
-        PrecomputedTransactionData txdata;
-        if (!PolicyScriptChecks(args, ws, txdata)) {
+        PrecomputedTransactionData& txdata = ws.m_precomputed_txdata;
+        if (!scripts_checked && !PolicyScriptChecks(args, ws, txdata)) {
             // Exit early to avoid doing pointless work. Update the failed tx result; the rest are unfinished.
             package_state.Invalid(PackageValidationResult::PCKG_TX, "transaction failed");
             results.emplace(ws.m_ptx->GetWitnessHash(), MempoolAcceptResult::Failure(ws.m_state));
@@ -1183,9 +1268,121 @@ PackageMempoolAcceptResult MemPoolAccept::AcceptMultipleTransactions(const std::
         }
     }
 
+    if (!args.m_test_accept) {
+        SubmitPackage(args, workspaces, package_state, results);
+    }
+
     return PackageMempoolAcceptResult(package_state, std::move(results));
 }
 
+bool MemPoolAccept::CheckPackageLimits(const std::vector<Workspace>& workspaces, size_t package_size, PackageValidationState& package_state)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(m_pool.cs);
+
+    CTxMemPool::setEntries ancestors;
+    for (const Workspace& ws : workspaces) {
+        ancestors.insert(ws.m_ancestors.cbegin(), ws.m_ancestors.cend());
+    }
+    size_t ancestors_size = package_size;
+    for (CTxMemPool::txiter it : ancestors) {
+        ancestors_size += it->GetTxSize();
+    }
+    if (ancestors.size() + workspaces.size() > m_limit_ancestors || ancestors_size > m_limit_ancestor_size) {
+        return package_state.Invalid(PackageValidationResult::PCKG_POLICY, "package-mempool-limits", "exceeds ancestor limits");
+    }
+    for (CTxMemPool::txiter it : ancestors) {
+        if (it->GetCountWithDescendants() + workspaces.size() > m_limit_descendants ||
+            it->GetSizeWithDescendants() + package_size > m_limit_descendant_size) {
+            return package_state.Invalid(PackageValidationResult::PCKG_POLICY, "package-mempool-limits",
+                                         strprintf("exceeds descendant limits of %s", it->GetTx().GetHash().ToString()));
+        }
+    }
+    return true;
+}
+
+bool MemPoolAccept::SubmitPackage(const ATMPArgs& args, std::vector<Workspace>& workspaces, PackageValidationState& package_state,
+                                  std::map<const uint256, const MempoolAcceptResult>& results)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(m_pool.cs);
+
+    // Run the consensus script checks of all transactions before adding any
+    // of them, so that nothing has to be taken out again if one fails.
+    std::vector<CTransactionRef> package_txns;
+    for (const Workspace& ws : workspaces) package_txns.push_back(ws.m_ptx);
+    for (Workspace& ws : workspaces) {
+        if (!ConsensusScriptChecks(args, ws, ws.m_precomputed_txdata, package_txns)) {
+            package_state.Invalid(PackageValidationResult::PCKG_TX, "transaction failed");
+            results.emplace(ws.m_ptx->GetWitnessHash(), MempoolAcceptResult::Failure(ws.m_state));
+            return false;
+        }
+    }
+
+    bool all_submitted = true;
+    // Add the transactions in order, so that the parents of each one are in the
+    // mempool when its ancestors are calculated.
+    size_t submitted = 0;
+    for (Workspace& ws : workspaces) {
+        std::string err_string;
+        if (!m_pool.CalculateMemPoolAncestors(*ws.m_entry, ws.m_ancestors, m_limit_ancestors, m_limit_ancestor_size,
+                                              m_limit_descendants, m_limit_descendant_size, err_string)) {
+            // CheckPackageLimits should have prevented this.
+            ws.m_state.Invalid(TxValidationResult::TX_MEMPOOL_POLICY, "too-long-mempool-chain", err_string);
+        } else if (Finalize(args, ws)) {
+            ++submitted;
+            continue;
+        }
+        LogPrintf("%s: failed to submit package transaction %s: %s\n", __func__, ws.m_hash.ToString(), ws.m_state.ToString());
+        package_state.Invalid(PackageValidationResult::PCKG_TX, "transaction failed");
+        results.emplace(ws.m_ptx->GetWitnessHash(), MempoolAcceptResult::Failure(ws.m_state));
+        all_submitted = false;
+        break;
+    }
+
+    // Announce every transaction which entered the mempool before any of them
+    // can be removed again, so that listeners see each removal after its add.
+    for (size_t i = 0; i < submitted; ++i) {
+        GetMainSignals().TransactionAddedToMempool(workspaces[i].m_ptx, m_pool.GetAndIncrementSequence());
+    }
+
+    bool trimmed = false;
+    if (all_submitted && !args.m_bypass_limits) {
+        LimitMempoolSize(m_pool, m_active_chainstate.CoinsTip(), gArgs.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000, std::chrono::hours{gArgs.GetArg("-mempoolexpiry", DEFAULT_MEMPOOL_EXPIRY)});
+        for (size_t i = 0; i < submitted; ++i) {
+            if (!m_pool.exists(workspaces[i].m_hash)) {
+                trimmed = true;
+                package_state.Invalid(PackageValidationResult::PCKG_TX, "transaction failed");
+                all_submitted = false;
+                break;
+            }
+        }
+    }
+
+    if (!all_submitted) {
+        // The package is accepted as a whole or not at all: take out the
+        // transactions that did make it in (removing a parent also removes its
+        // in-package descendants).
+        for (size_t i = 0; i < submitted; ++i) {
+            m_pool.removeRecursive(*workspaces[i].m_ptx, MemPoolRemovalReason::SIZELIMIT);
+        }
+    }
+
+    for (size_t i = 0; i < submitted; ++i) {
+        Workspace& ws = workspaces[i];
+        if (all_submitted) {
+            results.emplace(ws.m_ptx->GetWitnessHash(),
+                            MempoolAcceptResult::Success(std::move(ws.m_replaced_transactions), ws.m_base_fees));
+        } else if (trimmed) {
+            // The package did not pay enough to stay in a full mempool, but
+            // may be accepted once the mempool minimum fee drops.
+            ws.m_state.Invalid(TxValidationResult::TX_RECONSIDERABLE, "mempool full");
+            results.emplace(ws.m_ptx->GetWitnessHash(), MempoolAcceptResult::Failure(ws.m_state));
+        }
+    }
+    return all_submitted;
+}
+
 } // anon namespace
 
 /** (try to) add transaction to memory pool with a specified acceptance time **/
@@ -1197,7 +1394,8 @@ static MempoolAcceptResult AcceptToMemoryPoolWithTime(const CChainParams& chainp
 {
     std::vector<COutPoint> coins_to_uncache;
     MemPoolAccept::ATMPArgs args { chainparams, nAcceptTime, bypass_limits, coins_to_uncache,
-                                   test_accept, /* disallow_mempool_conflicts */ false };
+                                   test_accept, /* disallow_mempool_conflicts */ false,
+                                   /* m_package_submission */ false };
 
     assert(std::addressof(::ChainstateActive()) == std::addressof(active_chainstate));
     const MempoolAcceptResult result = MemPoolAccept(pool, active_chainstate).AcceptSingleTransaction(tx, args);
@@ -1227,22 +1425,26 @@ PackageMempoolAcceptResult ProcessNewPackage(CChainState& active_chainstate, CTx
                                                    const Package& package, bool test_accept)
 {
     AssertLockHeld(cs_main);
-    assert(test_accept); // Only allow package accept dry-runs (testmempoolaccept RPC).
     assert(!package.empty());
     assert(std::all_of(package.cbegin(), package.cend(), [](const auto& tx){return tx != nullptr;}));
 
     std::vector<COutPoint> coins_to_uncache;
     const CChainParams& chainparams = Params();
     MemPoolAccept::ATMPArgs args { chainparams, GetTime(), /* bypass_limits */ false, coins_to_uncache,
-                                   test_accept, /* disallow_mempool_conflicts */ true };
+                                   test_accept, /* disallow_mempool_conflicts */ true,
+                                   /* m_package_submission */ !test_accept };
     assert(std::addressof(::ChainstateActive()) == std::addressof(active_chainstate));
     const PackageMempoolAcceptResult result = MemPoolAccept(pool, active_chainstate).AcceptMultipleTransactions(package, args);
 
     // Uncache coins pertaining to transactions that were not submitted to the mempool.
     // Ensure the cache is still within its size limits.
-    for (const COutPoint& hashTx : coins_to_uncache) {
-        active_chainstate.CoinsTip().Uncache(hashTx);
+    if (test_accept || !result.m_state.IsValid()) {
+        for (const COutPoint& hashTx : coins_to_uncache) {
+            active_chainstate.CoinsTip().Uncache(hashTx);
+        }
     }
+    BlockValidationState state_dummy;
+    active_chainstate.FlushStateToDisk(chainparams, state_dummy, FlushStateMode::PERIODIC);
     return result;
 }
 
@@ -1687,10 +1889,12 @@ DisconnectResult CChainState::DisconnectBlock(const CBlock& block, const CBlockI
     return fClean ? DISCONNECT_OK : DISCONNECT_UNCLEAN;
 }
 
-static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
+/** Number of worker threads started for scriptcheckqueue, also used for loading the mempool */
+static int g_script_check_threads{0};
 
 void StartScriptCheckWorkerThreads(int threads_num)
 {
+    g_script_check_threads = threads_num;
     scriptcheckqueue.StartWorkerThreads(threads_num);
 }
 
@@ -4642,6 +4846,125 @@ bool CChainState::ResizeCoinsCaches(size_t coinstip_size, size_t coinsdb_size)
 
 static const uint64_t MEMPOOL_DUMP_VERSION = 1;
 
+/** Number of mempool.dat entries whose scripts are pre-verified together while loading. */
+static constexpr size_t MEMPOOL_LOAD_BATCH_SIZE{1000};
+
+namespace {
+/** A transaction read from mempool.dat along with its persisted metadata. */
+struct MempoolLoadEntry {
+    CTransactionRef tx;
+    int64_t nTime;
+    int64_t nFeeDelta;
+};
+
+/**
+ * Script check run while loading mempool.dat. It only serves to populate the
+ * signature cache ahead of AcceptToMemoryPool, so a failing check must not
+ * stop the queue from evaluating the checks of unrelated transactions.
+ */
+class MempoolLoadScriptCheck
+{
+private:
+    CScriptCheck m_check;
+
+public:
+    MempoolLoadScriptCheck() = default;
+    MempoolLoadScriptCheck(const CTxOut& out, const CTransaction& tx, unsigned int nIn, unsigned int flags, PrecomputedTransactionData* txdata) :
+        m_check(out, tx, nIn, flags, true /* cacheStore */, txdata) { }
+
+    bool operator()()
+    {
+        (void)m_check();
+        return true;
+    }
+
+    void swap(MempoolLoadScriptCheck& check) { m_check.swap(check.m_check); }
+};
+} // namespace
+
+/**
+ * Order entries so that every transaction comes after the entries it spends
+ * from, keeping the file order otherwise. DumpMempool already writes entries
+ * in this order, so this is normally a no-op.
+ */
+static std::vector<MempoolLoadEntry> SortMempoolLoadEntries(std::vector<MempoolLoadEntry>&& entries)
+{
+    std::unordered_map<uint256, size_t, SaltedTxidHasher> positions;
+    positions.reserve(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        positions.emplace(entries[i].tx->GetHash(), i);
+    }
+
+    std::vector<MempoolLoadEntry> sorted;
+    sorted.reserve(entries.size());
+    std::vector<bool> visited(entries.size(), false);
+    // Depth-first walk over in-file parents; (entry position, next input to inspect)
+    std::vector<std::pair<size_t, size_t>> stack;
+    for (size_t root = 0; root < entries.size(); ++root) {
+        if (visited[root]) continue;
+        visited[root] = true;
+        stack.emplace_back(root, 0);
+        while (!stack.empty()) {
+            const size_t pos = stack.back().first;
+            const CTransaction& tx = *entries[pos].tx;
+            if (stack.back().second < tx.vin.size()) {
+                const auto it = positions.find(tx.vin[stack.back().second++].prevout.hash);
+                if (it != positions.end() && !visited[it->second]) {
+                    visited[it->second] = true;
+                    stack.emplace_back(it->second, 0);
+                }
+            } else {
+                sorted.push_back(std::move(entries[pos]));
+                stack.pop_back();
+            }
+        }
+    }
+    return sorted;
+}
+
+/**
+ * Fetch the outputs spent by entries[begin, end) into the coins cache and
+ * create the script checks for every transaction whose inputs are all known,
+ * either from the UTXO set or from other entries of the file.
+ */
+static std::vector<MempoolLoadScriptCheck> PrepareMempoolLoadChecks(CCoinsViewCache& coins_tip,
+                                                                    const std::vector<MempoolLoadEntry>& entries,
+                                                                    const std::unordered_map<uint256, CTransactionRef, SaltedTxidHasher>& loaded_txs,
+                                                                    size_t begin, size_t end,
+                                                                    std::vector<PrecomputedTransactionData>& txsdata)
+    EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    AssertLockHeld(cs_main);
+    txsdata.clear();
+    txsdata.resize(end - begin);
+    std::vector<MempoolLoadScriptCheck> checks;
+    for (size_t i = begin; i < end; ++i) {
+        const CTransaction& tx = *entries[i].tx;
+        std::vector<CTxOut> spent_outputs;
+        spent_outputs.reserve(tx.vin.size());
+        for (const CTxIn& txin : tx.vin) {
+            const auto it = loaded_txs.find(txin.prevout.hash);
+            if (it != loaded_txs.end()) {
+                if (txin.prevout.n >= it->second->vout.size()) break;
+                spent_outputs.push_back(it->second->vout[txin.prevout.n]);
+            } else {
+                const Coin& coin = coins_tip.AccessCoin(txin.prevout);
+                if (coin.IsSpent()) break;
+                spent_outputs.push_back(coin.out);
+            }
+        }
+        // Transactions with missing inputs are left to AcceptToMemoryPool
+        if (spent_outputs.size() != tx.vin.size()) continue;
+
+        PrecomputedTransactionData& txdata = txsdata[i - begin];
+        txdata.Init(tx, std::move(spent_outputs));
+        for (unsigned int n = 0; n < tx.vin.size(); ++n) {
+            checks.emplace_back(txdata.m_spent_outputs[n], tx, n, STANDARD_SCRIPT_VERIFY_FLAGS, &txdata);
+        }
+    }
+    return checks;
+}
+
 bool LoadMempool(CTxMemPool& pool, CChainState& active_chainstate, FopenFn mockable_fopen_function)
 {
     const CChainParams& chainparams = Params();
@@ -4668,41 +4991,95 @@ bool LoadMempool(CTxMemPool& pool, CChainState& active_chainstate, FopenFn mocka
         }
         uint64_t num;
         file >> num;
+
+        // Deserialize all entries up front, so no file I/O happens while
+        // cs_main is held below.
+        std::vector<MempoolLoadEntry> entries;
         while (num--) {
-            CTransactionRef tx;
-            int64_t nTime;
-            int64_t nFeeDelta;
-            file >> tx;
-            file >> nTime;
-            file >> nFeeDelta;
-
-            CAmount amountdelta = nFeeDelta;
+            MempoolLoadEntry entry;
+            file >> entry.tx;
+            file >> entry.nTime;
+            file >> entry.nFeeDelta;
+
+            CAmount amountdelta = entry.nFeeDelta;
             if (amountdelta) {
-                pool.PrioritiseTransaction(tx->GetHash(), amountdelta);
+                pool.PrioritiseTransaction(entry.tx->GetHash(), amountdelta);
             }
-            if (nTime > nNow - nExpiryTimeout) {
-                LOCK(cs_main);
-                assert(std::addressof(::ChainstateActive()) == std::addressof(active_chainstate));
-                if (AcceptToMemoryPoolWithTime(chainparams, pool, active_chainstate, tx, nTime, false /* bypass_limits */,
-                                               false /* test_accept */).m_result_type == MempoolAcceptResult::ResultType::VALID) {
-                    ++count;
-                } else {
-                    // mempool may contain the transaction already, e.g. from
-                    // wallet(s) having loaded it while we were processing
-                    // mempool transactions; consider these as valid, instead of
-                    // failed, but mark them as 'already there'
-                    if (pool.exists(tx->GetHash())) {
-                        ++already_there;
-                    } else {
-                        ++failed;
-                    }
-                }
+            if (entry.nTime > nNow - nExpiryTimeout) {
+                entries.push_back(std::move(entry));
             } else {
                 ++expired;
             }
             if (ShutdownRequested())
                 return false;
         }
+        entries = SortMempoolLoadEntries(std::move(entries));
+
+        std::unordered_map<uint256, CTransactionRef, SaltedTxidHasher> loaded_txs;
+        loaded_txs.reserve(entries.size());
+        for (const MempoolLoadEntry& entry : entries) {
+            loaded_txs.emplace(entry.tx->GetHash(), entry.tx);
+        }
+
+        {
+            // While one batch is accepted to the mempool, the scripts of the
+            // next one are verified in parallel, so that AcceptToMemoryPool
+            // finds their signatures in the signature cache.
+            CCheckQueue<MempoolLoadScriptCheck> queue(128);
+            if (g_parallel_script_checks) queue.StartWorkerThreads(g_script_check_threads);
+            std::optional<CCheckQueueControl<MempoolLoadScriptCheck>> control;
+            std::vector<PrecomputedTransactionData> txsdata;
+            const auto start_batch = [&](size_t begin) {
+                if (!g_parallel_script_checks || begin >= entries.size()) return;
+                const size_t end = std::min(begin + MEMPOOL_LOAD_BATCH_SIZE, entries.size());
+                std::vector<MempoolLoadScriptCheck> checks;
+                {
+                    LOCK(cs_main);
+                    checks = PrepareMempoolLoadChecks(active_chainstate.CoinsTip(), entries, loaded_txs, begin, end, txsdata);
+                }
+                control.emplace(&queue);
+                control->Add(checks);
+            };
+
+            bool shutdown{false};
+            start_batch(0);
+            for (size_t begin = 0; begin < entries.size() && !shutdown; begin += MEMPOOL_LOAD_BATCH_SIZE) {
+                const size_t end = std::min(begin + MEMPOOL_LOAD_BATCH_SIZE, entries.size());
+                if (control) {
+                    control->Wait();
+                    control.reset();
+                }
+                start_batch(end);
+
+                for (size_t i = begin; i < end; ++i) {
+                    const CTransactionRef& tx = entries[i].tx;
+                    LOCK(cs_main);
+                    assert(std::addressof(::ChainstateActive()) == std::addressof(active_chainstate));
+                    if (AcceptToMemoryPoolWithTime(chainparams, pool, active_chainstate, tx, entries[i].nTime, false /* bypass_limits */,
+                                                   false /* test_accept */).m_result_type == MempoolAcceptResult::ResultType::VALID) {
+                        ++count;
+                    } else {
+                        // mempool may contain the transaction already, e.g. from
+                        // wallet(s) having loaded it while we were processing
+                        // mempool transactions; consider these as valid, instead of
+                        // failed, but mark them as 'already there'
+                        if (pool.exists(tx->GetHash())) {
+                            ++already_there;
+                        } else {
+                            ++failed;
+                        }
+                    }
+                    if (ShutdownRequested()) {
+                        shutdown = true;
+                        break;
+                    }
+                }
+            }
+            control.reset();
+            queue.StopWorkerThreads();
+            if (shutdown) return false;
+        }
+
         std::map<uint256, CAmount> mapDeltas;
         file >> mapDeltas;
 
@@ -92,6 +92,7 @@ static const int64_t DEFAULT_MAX_TIP_AGE = 24 * 60 * 60;
 static const bool DEFAULT_CHECKPOINTS_ENABLED = true;
 static const bool DEFAULT_TXINDEX = false;
 static constexpr bool DEFAULT_COINSTATSINDEX{false};
+static constexpr bool DEFAULT_BLOCKSTATSINDEX{false};
 static const char* const DEFAULT_BLOCKFILTERINDEX = "0";
 /** Default for -persistmempool */
 static const bool DEFAULT_PERSIST_MEMPOOL = true;
@@ -246,11 +247,16 @@ MempoolAcceptResult AcceptToMemoryPool(CChainState& active_chainstate, CTxMemPoo
                                        bool bypass_limits, bool test_accept=false) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
 /**
-* Atomically test acceptance of a package. If the package only contains one tx, package rules still apply.
+* Test acceptance of a package, or submit it to the mempool. If the package only contains one tx,
+* package rules still apply.
 * @param[in]    txns                Group of transactions which may be independent or contain
 *                                   parent-child dependencies. The transactions must not conflict, i.e.
 *                                   must not spend the same inputs, even if it would be a valid BIP125
 *                                   replace-by-fee. Parents must appear before children.
+* @param[in]    test_accept         When true, run validation checks but don't submit to mempool.
+*                                   When false, the package must be a child with its parents
+*                                   (IsChildWithParents), and its feerate is checked as a whole so
+*                                   that the child can pay for parents below the minimum feerate.
 * @returns a PackageMempoolAcceptResult which includes a MempoolAcceptResult for each transaction.
 * If a transaction fails, validation will exit early and some results may be missing.
 */
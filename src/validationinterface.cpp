@@ -24,9 +24,134 @@
 #include <primitives/transaction.h>
 #include <scheduler.h>
 
+#include <algorithm>
+#include <atomic>
 #include <future>
+#include <list>
 #include <unordered_map>
 #include <utility>
+#include <vector>
+
+/**
+ * Queue of callbacks that are run one at a time and in order on the
+ * scheduler. Separate queues do not wait for each other, so they can make
+ * progress in parallel when the scheduler has more than one thread.
+ */
+class ValidationCallbackQueue : public std::enable_shared_from_this<ValidationCallbackQueue>
+{
+private:
+    CScheduler& m_scheduler;
+    Mutex m_mutex;
+    std::list<std::function<void()>> m_pending GUARDED_BY(m_mutex);
+    //! Whether a ProcessQueue() call is scheduled or running, or the queue is held by Suspend()
+    bool m_scheduled GUARDED_BY(m_mutex){false};
+    //! Whether to stop processing callbacks after the current one
+    bool m_suspended GUARDED_BY(m_mutex){false};
+    //! Whether processing stopped because of m_suspended
+    bool m_held GUARDED_BY(m_mutex){false};
+
+    //! Release the queue, or schedule the next callback
+    void Continue()
+    {
+        {
+            LOCK(m_mutex);
+            if (m_suspended) {
+                m_held = true;
+                return;
+            }
+            if (m_pending.empty()) {
+                m_scheduled = false;
+                return;
+            }
+        }
+        Schedule();
+    }
+
+    void ProcessQueue()
+    {
+        std::function<void()> callback;
+        {
+            LOCK(m_mutex);
+            if (m_pending.empty()) {
+                m_scheduled = false;
+                return;
+            }
+            callback = std::move(m_pending.front());
+            m_pending.pop_front();
+        }
+
+        // Continue even if callback() throws. Only one callback runs per
+        // scheduled task, so that a long queue does not starve the other
+        // queues and scheduler tasks.
+        struct RAIIContinue {
+            ValidationCallbackQueue& queue;
+            ~RAIIContinue() { queue.Continue(); }
+        } raii_continue{*this};
+
+        callback();
+    }
+
+    void Schedule()
+    {
+        m_scheduler.schedule([self = shared_from_this()] { self->ProcessQueue(); }, std::chrono::system_clock::now());
+    }
+
+public:
+    explicit ValidationCallbackQueue(CScheduler& scheduler) : m_scheduler(scheduler) {}
+
+    void Add(std::function<void()> func)
+    {
+        {
+            LOCK(m_mutex);
+            m_pending.emplace_back(std::move(func));
+            if (m_scheduled) return;
+            m_scheduled = true;
+        }
+        Schedule();
+    }
+
+    //! Stop processing callbacks once the one currently running returns,
+    //! until Resume() is called
+    void Suspend()
+    {
+        LOCK(m_mutex);
+        m_suspended = true;
+    }
+
+    void Resume()
+    {
+        {
+            LOCK(m_mutex);
+            m_suspended = false;
+            if (!m_held) return;
+            m_held = false;
+        }
+        Continue();
+    }
+
+    //! Run all pending callbacks on the calling thread. The scheduler must not
+    //! have any threads servicing it.
+    void EmptyQueue()
+    {
+        assert(!m_scheduler.AreThreadsServicingQueue());
+        while (true) {
+            std::function<void()> callback;
+            {
+                LOCK(m_mutex);
+                if (m_pending.empty()) return;
+                callback = std::move(m_pending.front());
+                m_pending.pop_front();
+            }
+            callback();
+        }
+    }
+
+    size_t CallbacksPending()
+    {
+        LOCK(m_mutex);
+        return m_pending.size();
+    }
+};
 
 //! The MainSignalsInstance manages a list of shared_ptr<CValidationInterface>
 //! callbacks.
@@ -34,31 +159,100 @@
 //! A std::unordered_map is used to track what callbacks are currently
 //! registered, and a std::list is to used to store the callbacks that are
 //! currently registered as well as any callbacks that are just unregistered
-//! and about to be deleted when they are done executing.
+//! and about to be deleted when they are done executing or have no more
+//! notifications queued.
+//!
+//! Events are first put on a single ordered queue. When an event comes up
+//! there, it is handed to the queue of every subscriber registered at that
+//! time, so a subscriber registered while older events are still queued
+//! receives them, as with a single queue. From there each subscriber
+//! processes its notifications in order, without waiting for the others.
 struct MainSignalsInstance {
 private:
     Mutex m_mutex;
-    //! List entries consist of a callback pointer and reference count. The
-    //! count is equal to the number of current executions of that entry, plus 1
-    //! if it's registered. It cannot be 0 because that would imply it is
-    //! unregistered and also not being executed (so shouldn't exist).
-    struct ListEntry { std::shared_ptr<CValidationInterface> callbacks; int count = 1; };
+    //! List entries consist of a callback pointer, its queue and a reference
+    //! count. The count is equal to the number of current executions and
+    //! queued notifications of that entry, plus 1 if it's registered. It
+    //! cannot be 0 because that would imply it is unregistered and also not
+    //! being executed (so shouldn't exist).
+    struct ListEntry {
+        std::shared_ptr<CValidationInterface> callbacks;
+        std::shared_ptr<ValidationCallbackQueue> queue;
+        int count = 1;
+        bool registered = true;
+    };
     std::list<ListEntry> m_list GUARDED_BY(m_mutex);
     std::unordered_map<CValidationInterface*, std::list<ListEntry>::iterator> m_map GUARDED_BY(m_mutex);
 
-public:
-    // We are not allowed to assume the scheduler only runs in one thread,
-    // but must ensure all callbacks happen in-order, so we end up creating
-    // our own queue here :(
-    SingleThreadedSchedulerClient m_schedulerClient;
+    CScheduler& m_scheduler;
+    //! Events in the order they were generated, not yet handed to subscribers
+    const std::shared_ptr<ValidationCallbackQueue> m_queue;
+
+    void Release(std::list<ListEntry>::iterator it) EXCLUSIVE_LOCKS_REQUIRED(m_mutex)
+    {
+        if (!--it->count) m_list.erase(it);
+    }
 
-    explicit MainSignalsInstance(CScheduler *pscheduler) : m_schedulerClient(pscheduler) {}
+    //! Hand f to the queue of every registered subscriber. Subscribers that
+    //! are unregistered by the time their notification runs are skipped.
+    template<typename F> void Dispatch(const F& f)
+    {
+        LOCK(m_mutex);
+        for (const auto& entry : m_map) {
+            const auto it = entry.second;
+            ++it->count;
+            it->queue->Add([this, it, f] {
+                bool registered = WITH_LOCK(m_mutex, return it->registered);
+                if (registered) f(*it->callbacks);
+                LOCK(m_mutex);
+                Release(it);
+            });
+        }
+    }
+
+    //! Call func once every subscriber queue has finished the notifications
+    //! handed to it so far. No further events are dispatched until then.
+    void DispatchBarrier(const std::function<void()>& func)
+    {
+        struct Barrier {
+            std::atomic<size_t> remaining;
+            std::function<void()> func;
+        };
+        WAIT_LOCK(m_mutex, lock);
+        if (m_list.empty()) {
+            REVERSE_LOCK(lock);
+            func();
+            return;
+        }
+        auto barrier = std::make_shared<Barrier>();
+        barrier->remaining = m_list.size();
+        barrier->func = func;
+        m_queue->Suspend();
+        for (auto it = m_list.begin(); it != m_list.end(); ++it) {
+            ++it->count;
+            it->queue->Add([this, it, barrier] {
+                if (--barrier->remaining == 0) {
+                    barrier->func();
+                    m_queue->Resume();
+                }
+                LOCK(m_mutex);
+                Release(it);
+            });
+        }
+    }
+
+public:
+    explicit MainSignalsInstance(CScheduler& scheduler)
+        : m_scheduler(scheduler), m_queue(std::make_shared<ValidationCallbackQueue>(scheduler)) {}
 
     void Register(std::shared_ptr<CValidationInterface> callbacks)
     {
         LOCK(m_mutex);
         auto inserted = m_map.emplace(callbacks.get(), m_list.end());
-        if (inserted.second) inserted.first->second = m_list.emplace(m_list.end());
+        if (inserted.second) {
+            inserted.first->second = m_list.emplace(m_list.end());
+            inserted.first->second->queue = std::make_shared<ValidationCallbackQueue>(m_scheduler);
+        }
         inserted.first->second->callbacks = std::move(callbacks);
     }
 
@@ -67,7 +261,8 @@ public:
         LOCK(m_mutex);
         auto it = m_map.find(callbacks);
         if (it != m_map.end()) {
-            if (!--it->second->count) m_list.erase(it->second);
+            it->second->registered = false;
+            Release(it->second);
             m_map.erase(it);
         }
     }
@@ -80,7 +275,8 @@ public:
     {
         LOCK(m_mutex);
         for (const auto& entry : m_map) {
-            if (!--entry.second->count) m_list.erase(entry.second);
+            entry.second->registered = false;
+            Release(entry.second);
         }
         m_map.clear();
     }
@@ -89,6 +285,10 @@ public:
     {
         WAIT_LOCK(m_mutex, lock);
         for (auto it = m_list.begin(); it != m_list.end();) {
+            if (!it->registered) {
+                ++it;
+                continue;
+            }
             ++it->count;
             {
                 REVERSE_LOCK(lock);
@@ -97,6 +297,56 @@ public:
             it = --it->count ? std::next(it) : m_list.erase(it);
         }
     }
+
+    //! Queue an event, which calls f with each subscriber
+    template<typename F> void Enqueue(F f)
+    {
+        m_queue->Add([this, f = std::move(f)] { Dispatch(f); });
+    }
+
+    void AddBarrier(std::function<void()> func)
+    {
+        m_queue->Add([this, func = std::move(func)] { DispatchBarrier(func); });
+    }
+
+    void EmptyQueues()
+    {
+        do {
+            for (const auto& queue : GetQueues()) queue->EmptyQueue();
+        } while (GetQueueStats().callbacks_pending > 0);
+    }
+
+    //! Number of events not yet dispatched, plus the number of notifications
+    //! waiting in the longest subscriber queue
+    size_t CallbacksPending()
+    {
+        const ValidationQueueStats stats{GetQueueStats()};
+        return m_queue->CallbacksPending() + stats.max_callbacks_pending;
+    }
+
+    ValidationQueueStats GetQueueStats()
+    {
+        ValidationQueueStats stats;
+        stats.subscribers = WITH_LOCK(m_mutex, return m_map.size());
+        stats.callbacks_pending = m_queue->CallbacksPending();
+        for (const auto& queue : GetQueues()) {
+            if (queue == m_queue) continue;
+            const size_t pending{queue->CallbacksPending()};
+            stats.callbacks_pending += pending;
+            stats.max_callbacks_pending = std::max(stats.max_callbacks_pending, pending);
+        }
+        return stats;
+    }
+
+    std::vector<std::shared_ptr<ValidationCallbackQueue>> GetQueues()
+    {
+        LOCK(m_mutex);
+        std::vector<std::shared_ptr<ValidationCallbackQueue>> queues{m_queue};
+        for (const auto& entry : m_list) {
+            queues.push_back(entry.queue);
+        }
+        return queues;
+    }
 };
 
 static CMainSignals g_signals;
@@ -104,7 +354,7 @@ static CMainSignals g_signals;
 void CMainSignals::RegisterBackgroundSignalScheduler(CScheduler& scheduler)
 {
     assert(!m_internals);
-    m_internals.reset(new MainSignalsInstance(&scheduler));
+    m_internals.reset(new MainSignalsInstance(scheduler));
 }
 
 void CMainSignals::UnregisterBackgroundSignalScheduler()
@@ -115,14 +365,20 @@ void CMainSignals::UnregisterBackgroundSignalScheduler()
 void CMainSignals::FlushBackgroundCallbacks()
 {
     if (m_internals) {
-        m_internals->m_schedulerClient.EmptyQueue();
+        m_internals->EmptyQueues();
     }
 }
 
 size_t CMainSignals::CallbacksPending()
 {
     if (!m_internals) return 0;
-    return m_internals->m_schedulerClient.CallbacksPending();
+    return m_internals->CallbacksPending();
+}
+
+ValidationQueueStats CMainSignals::GetQueueStats()
+{
+    if (!m_internals) return {};
+    return m_internals->GetQueueStats();
 }
 
 CMainSignals& GetMainSignals()
@@ -166,7 +422,7 @@ void UnregisterAllValidationInterfaces()
 
 void CallFunctionInValidationInterfaceQueue(std::function<void()> func)
 {
-    g_signals.m_internals->m_schedulerClient.AddToProcessQueue(std::move(func));
+    g_signals.m_internals->AddBarrier(std::move(func));
 }
 
 void SyncWithValidationInterfaceQueue()
@@ -184,14 +440,14 @@ void SyncWithValidationInterfaceQueue()
 // evaluating arguments when logging is not enabled.
 //
 // NOTE: The lambda captures all local variables by value.
-#define ENQUEUE_AND_LOG_EVENT(event, fmt, name, ...)           \
-    do {                                                       \
-        auto local_name = (name);                              \
-        LOG_EVENT("Enqueuing " fmt, local_name, __VA_ARGS__);  \
-        m_internals->m_schedulerClient.AddToProcessQueue([=] { \
-            LOG_EVENT(fmt, local_name, __VA_ARGS__);           \
-            event();                                           \
-        });                                                    \
+#define ENQUEUE_AND_LOG_EVENT(event, fmt, name, ...)                       \
+    do {                                                                   \
+        auto local_name = (name);                                          \
+        LOG_EVENT("Enqueuing " fmt, local_name, __VA_ARGS__);              \
+        m_internals->Enqueue([=](CValidationInterface& callbacks) {        \
+            LOG_EVENT(fmt, local_name, __VA_ARGS__);                       \
+            event(callbacks);                                              \
+        });                                                                \
     } while (0)
 
 #define LOG_EVENT(fmt, ...) \
@@ -202,8 +458,8 @@ void CMainSignals::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockInd
     // the chain actually updates. One way to ensure this is for the caller to invoke this signal
     // in the same critical section where the chain is updated
 
-    auto event = [pindexNew, pindexFork, fInitialDownload, this] {
-        m_internals->Iterate([&](CValidationInterface& callbacks) { callbacks.UpdatedBlockTip(pindexNew, pindexFork, fInitialDownload); });
+    auto event = [pindexNew, pindexFork, fInitialDownload](CValidationInterface& callbacks) {
+        callbacks.UpdatedBlockTip(pindexNew, pindexFork, fInitialDownload);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: new block hash=%s fork block hash=%s (in IBD=%s)", __func__,
                           pindexNew->GetBlockHash().ToString(),
@@ -212,8 +468,8 @@ void CMainSignals::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockInd
 }
 
 void CMainSignals::TransactionAddedToMempool(const CTransactionRef& tx, uint64_t mempool_sequence) {
-    auto event = [tx, mempool_sequence, this] {
-        m_internals->Iterate([&](CValidationInterface& callbacks) { callbacks.TransactionAddedToMempool(tx, mempool_sequence); });
+    auto event = [tx, mempool_sequence](CValidationInterface& callbacks) {
+        callbacks.TransactionAddedToMempool(tx, mempool_sequence);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: txid=%s wtxid=%s", __func__,
                           tx->GetHash().ToString(),
@@ -221,8 +477,8 @@ void CMainSignals::TransactionAddedToMempool(const CTransactionRef& tx, uint64_t
 }
 
 void CMainSignals::TransactionRemovedFromMempool(const CTransactionRef& tx, MemPoolRemovalReason reason, uint64_t mempool_sequence) {
-    auto event = [tx, reason, mempool_sequence, this] {
-        m_internals->Iterate([&](CValidationInterface& callbacks) { callbacks.TransactionRemovedFromMempool(tx, reason, mempool_sequence); });
+    auto event = [tx, reason, mempool_sequence](CValidationInterface& callbacks) {
+        callbacks.TransactionRemovedFromMempool(tx, reason, mempool_sequence);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: txid=%s wtxid=%s", __func__,
                           tx->GetHash().ToString(),
@@ -230,8 +486,8 @@ void CMainSignals::TransactionRemovedFromMempool(const CTransactionRef& tx, MemP
 }
 
 void CMainSignals::BlockConnected(const std::shared_ptr<const CBlock> &pblock, const CBlockIndex *pindex) {
-    auto event = [pblock, pindex, this] {
-        m_internals->Iterate([&](CValidationInterface& callbacks) { callbacks.BlockConnected(pblock, pindex); });
+    auto event = [pblock, pindex](CValidationInterface& callbacks) {
+        callbacks.BlockConnected(pblock, pindex);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: block hash=%s block height=%d", __func__,
                           pblock->GetHash().ToString(),
@@ -240,8 +496,8 @@ void CMainSignals::BlockConnected(const std::shared_ptr<const CBlock> &pblock, c
 
 void CMainSignals::BlockDisconnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindex)
 {
-    auto event = [pblock, pindex, this] {
-        m_internals->Iterate([&](CValidationInterface& callbacks) { callbacks.BlockDisconnected(pblock, pindex); });
+    auto event = [pblock, pindex](CValidationInterface& callbacks) {
+        callbacks.BlockDisconnected(pblock, pindex);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: block hash=%s block height=%d", __func__,
                           pblock->GetHash().ToString(),
@@ -249,8 +505,8 @@ void CMainSignals::BlockDisconnected(const std::shared_ptr<const CBlock>& pblock
 }
 
 void CMainSignals::ChainStateFlushed(const CBlockLocator &locator) {
-    auto event = [locator, this] {
-        m_internals->Iterate([&](CValidationInterface& callbacks) { callbacks.ChainStateFlushed(locator); });
+    auto event = [locator](CValidationInterface& callbacks) {
+        callbacks.ChainStateFlushed(locator);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: block hash=%s", __func__,
                           locator.IsNull() ? "null" : locator.vHave.front().ToString());
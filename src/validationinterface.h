@@ -188,6 +188,16 @@ protected:
     friend class CMainSignals;
 };
 
+/** Depth of the validation interface callback queues */
+struct ValidationQueueStats {
+    //! Number of registered subscribers
+    size_t subscribers{0};
+    //! Callbacks waiting to run, summed over all subscriber queues
+    size_t callbacks_pending{0};
+    //! Callbacks waiting to run in the longest subscriber queue
+    size_t max_callbacks_pending{0};
+};
+
 struct MainSignalsInstance;
 class CMainSignals {
 private:
@@ -206,8 +216,9 @@ public:
     /** Call any remaining callbacks on the calling thread */
     void FlushBackgroundCallbacks();
 
+    /** Number of callbacks waiting to run for the subscriber that is furthest behind */
     size_t CallbacksPending();
-
+    ValidationQueueStats GetQueueStats();
 
     void UpdatedBlockTip(const CBlockIndex *, const CBlockIndex *, bool fInitialDownload);
     void TransactionAddedToMempool(const CTransactionRef&, uint64_t mempool_sequence);
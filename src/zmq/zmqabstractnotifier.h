@@ -18,12 +18,15 @@
 #define BITCOIN_ZMQ_ZMQABSTRACTNOTIFIER_H
 
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <string>
 
 class CBlockIndex;
 class CTransaction;
 class CZMQAbstractNotifier;
+class CZMQPublishQueue;
 
 using CZMQNotifierFactory = std::unique_ptr<CZMQAbstractNotifier> (*)();
 
@@ -51,6 +54,9 @@ public:
             outbound_message_high_water_mark = sndhwm;
         }
     }
+    void SetPublishQueue(CZMQPublishQueue* queue) { m_publish_queue = queue; }
+    //! Number of messages that were not published, e.g. because the publish queue was full
+    uint64_t GetDroppedMessages() const { return m_dropped_messages; }
 
     virtual bool Initialize(void *pcontext) = 0;
     virtual void Shutdown() = 0;
@@ -73,6 +79,8 @@ protected:
     std::string type;
     std::string address;
     int outbound_message_high_water_mark; // aka SNDHWM
+    CZMQPublishQueue* m_publish_queue{nullptr}; //!< if set, messages are sent from its thread
+    std::atomic<uint64_t> m_dropped_messages{0};
 };
 
 #endif // BITCOIN_ZMQ_ZMQABSTRACTNOTIFIER_H
@@ -23,6 +23,8 @@
 #include <validation.h>
 #include <util/system.h>
 
+#include <algorithm>
+
 CZMQNotificationInterface::CZMQNotificationInterface() : pcontext(nullptr)
 {
 }
@@ -67,6 +69,11 @@ CZMQNotificationInterface* CZMQNotificationInterface::Create()
     if (!notifiers.empty())
     {
         std::unique_ptr<CZMQNotificationInterface> notificationInterface(new CZMQNotificationInterface());
+        const int64_t queue_size = gArgs.GetArg("-zmqqueuesize", DEFAULT_ZMQ_QUEUE_SIZE);
+        notificationInterface->m_publish_queue = std::make_unique<CZMQPublishQueue>(std::max<int64_t>(queue_size, 1));
+        for (auto& notifier : notifiers) {
+            notifier->SetPublishQueue(notificationInterface->m_publish_queue.get());
+        }
         notificationInterface->notifiers = std::move(notifiers);
 
         if (notificationInterface->Initialize()) {
@@ -104,6 +111,8 @@ bool CZMQNotificationInterface::Initialize()
         }
     }
 
+    m_publish_queue->Start();
+
     return true;
 }
 
@@ -113,6 +122,8 @@ void CZMQNotificationInterface::Shutdown()
     LogPrint(BCLog::ZMQ, "zmq: Shutdown notification interface\n");
     if (pcontext)
     {
+        // Publish what is still queued before the sockets are closed
+        if (m_publish_queue) m_publish_queue->Stop();
         for (auto& notifier : notifiers) {
             LogPrint(BCLog::ZMQ, "zmq: Shutdown notifier %s at %s\n", notifier->GetType(), notifier->GetAddress());
             notifier->Shutdown();
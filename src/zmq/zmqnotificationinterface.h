@@ -18,15 +18,20 @@
 #define BITCOIN_ZMQ_ZMQNOTIFICATIONINTERFACE_H
 
 #include <validationinterface.h>
+#include <cstddef>
 #include <list>
 #include <memory>
 
 class CBlockIndex;
 class CZMQAbstractNotifier;
+class CZMQPublishQueue;
 
 class CZMQNotificationInterface final : public CValidationInterface
 {
 public:
+    //! Maximum number of notifications waiting to be published before new ones are dropped
+    static constexpr size_t DEFAULT_ZMQ_QUEUE_SIZE{10000};
+
     virtual ~CZMQNotificationInterface();
 
     std::list<const CZMQAbstractNotifier*> GetActiveNotifiers() const;
@@ -48,6 +53,7 @@ private:
     CZMQNotificationInterface();
 
     void *pcontext;
+    std::unique_ptr<CZMQPublishQueue> m_publish_queue;
     std::list<std::unique_ptr<CZMQAbstractNotifier>> notifiers;
 };
 
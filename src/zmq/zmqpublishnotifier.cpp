@@ -22,6 +22,7 @@
 #include <rpc/server.h>
 #include <streams.h>
 #include <util/system.h>
+#include <util/thread.h>
 #include <validation.h> // For cs_main
 #include <zmq/zmqutil.h>
 
@@ -148,6 +149,9 @@ void CZMQAbstractPublishNotifier::Shutdown()
     // Early return if Initialize was not called
     if (!psocket) return;
 
+    // make sure the publisher thread is done with this notifier before the socket goes away
+    if (m_publish_queue) m_publish_queue->Discard(this);
+
     int count = mapPublishNotifiers.count(address);
 
     // remove this notifier from the list of publishers using this address
@@ -174,23 +178,117 @@ void CZMQAbstractPublishNotifier::Shutdown()
     psocket = nullptr;
 }
 
-bool CZMQAbstractPublishNotifier::SendZmqMessage(const char *command, const void* data, size_t size)
+bool CZMQAbstractPublishNotifier::PublishZmqMessage(const char* command, const void* data, size_t size, uint32_t sequence)
 {
     assert(psocket);
 
     /* send three parts, command & data & a LE 4byte sequence number */
     unsigned char msgseq[sizeof(uint32_t)];
-    WriteLE32(msgseq, nSequence);
+    WriteLE32(msgseq, sequence);
     int rc = zmq_send_multipart(psocket, command, strlen(command), data, size, msgseq, (size_t)sizeof(uint32_t), nullptr);
-    if (rc == -1)
-        return false;
+    return rc != -1;
+}
+
+bool CZMQAbstractPublishNotifier::QueueZmqMessage(const char* command, std::vector<unsigned char>&& data, CZMQPublishQueue::Loader&& load)
+{
+    /* the sequence number is consumed even if the message is dropped, so that subscribers can detect the loss */
+    const uint32_t sequence = nSequence++;
+
+    if (!m_publish_queue) {
+        if (load && !load(data)) return false;
+        return PublishZmqMessage(command, data.data(), data.size(), sequence);
+    }
+
+    if (m_failed) return false;
+
+    if (!m_publish_queue->Push({this, command, std::move(data), std::move(load), sequence})) {
+        if (m_dropped_messages++ == 0) {
+            LogPrintf("zmq: Publish queue full, dropping %s notifications to %s\n", command, address);
+        }
+    }
+    return true;
+}
+
+bool CZMQAbstractPublishNotifier::SendZmqMessage(const char *command, const void* data, size_t size)
+{
+    const unsigned char* begin = static_cast<const unsigned char*>(data);
+    return QueueZmqMessage(command, std::vector<unsigned char>(begin, begin + size), nullptr);
+}
+
+bool CZMQAbstractPublishNotifier::SendZmqMessage(const char* command, CZMQPublishQueue::Loader load)
+{
+    return QueueZmqMessage(command, {}, std::move(load));
+}
+
+void CZMQPublishQueue::Start()
+{
+    assert(!m_thread.joinable());
+    m_thread = std::thread(&util::TraceThread, "zmqpub", [this] { ThreadPublish(); });
+}
 
-    /* increment memory only sequence number after sending */
-    nSequence++;
+void CZMQPublishQueue::Stop()
+{
+    {
+        LOCK(m_mutex);
+        m_stop = true;
+    }
+    m_cond.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+}
 
+bool CZMQPublishQueue::Push(Message&& msg)
+{
+    {
+        LOCK(m_mutex);
+        if (m_stop || m_queue.size() >= m_max_size) return false;
+        m_queue.push_back(std::move(msg));
+    }
+    m_cond.notify_all();
     return true;
 }
 
+void CZMQPublishQueue::Discard(const CZMQAbstractPublishNotifier* notifier)
+{
+    WAIT_LOCK(m_mutex, lock);
+    for (auto it = m_queue.begin(); it != m_queue.end();) {
+        if (it->notifier == notifier) {
+            it = m_queue.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    m_cond.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return !m_publishing; });
+}
+
+void CZMQPublishQueue::ThreadPublish()
+{
+    std::deque<Message> batch;
+    while (true) {
+        {
+            WAIT_LOCK(m_mutex, lock);
+            m_publishing = false;
+            m_cond.notify_all();
+            m_cond.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_stop || !m_queue.empty(); });
+            // Anything queued before Stop() is still published
+            if (m_queue.empty()) return;
+            // Take everything that is queued, so the validation interface thread
+            // only contends for the lock once per batch rather than per message
+            batch.swap(m_queue);
+            m_publishing = true;
+        }
+
+        for (Message& msg : batch) {
+            CZMQAbstractPublishNotifier& notifier = *msg.notifier;
+            if ((msg.load && !msg.load(msg.data)) ||
+                !notifier.PublishZmqMessage(msg.command, msg.data.data(), msg.data.size(), msg.sequence)) {
+                ++notifier.m_dropped_messages;
+                notifier.m_failed = true;
+            }
+        }
+        batch.clear();
+    }
+}
+
 bool CZMQPublishHashBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
 {
     uint256 hash = pindex->GetBlockHash();
@@ -215,9 +313,10 @@ bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
 {
     LogPrint(BCLog::ZMQ, "zmq: Publish rawblock %s to %s\n", pindex->GetBlockHash().GetHex(), this->address);
 
-    const Consensus::Params& consensusParams = Params().GetConsensus();
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
-    {
+    // The block is read from disk and serialized by the publisher thread
+    return SendZmqMessage(MSG_RAWBLOCK, [pindex](std::vector<unsigned char>& data) {
+        const Consensus::Params& consensusParams = Params().GetConsensus();
+        CVectorWriter ss(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags(), data, 0);
         LOCK(cs_main);
         CBlock block;
         if(!ReadBlockFromDisk(block, pindex, consensusParams))
@@ -227,9 +326,8 @@ bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
         }
 
         ss << block;
-    }
-
-    return SendZmqMessage(MSG_RAWBLOCK, &(*ss.begin()), ss.size());
+        return true;
+    });
 }
 
 bool CZMQPublishRawTransactionNotifier::NotifyTransaction(const CTransaction &transaction)
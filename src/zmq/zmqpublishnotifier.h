@@ -17,14 +17,77 @@
 #ifndef BITCOIN_ZMQ_ZMQPUBLISHNOTIFIER_H
 #define BITCOIN_ZMQ_ZMQPUBLISHNOTIFIER_H
 
+#include <sync.h>
 #include <zmq/zmqabstractnotifier.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <vector>
+
 class CBlockIndex;
+class CZMQAbstractPublishNotifier;
+
+/**
+ * Bounded queue of outgoing notifications, published by a dedicated thread so
+ * that serializing, reading blocks from disk and sending do not hold up the
+ * validation interface queue. When the queue is full, new notifications are
+ * dropped; their sequence numbers are still consumed, so subscribers see a gap.
+ */
+class CZMQPublishQueue
+{
+public:
+    //! Produces the message body on the publisher thread
+    using Loader = std::function<bool(std::vector<unsigned char>&)>;
+
+    struct Message {
+        CZMQAbstractPublishNotifier* notifier;
+        const char* command;
+        std::vector<unsigned char> data;
+        Loader load; //!< if set, fills data before sending
+        uint32_t sequence;
+    };
+
+    explicit CZMQPublishQueue(size_t max_size) : m_max_size(max_size) {}
+    ~CZMQPublishQueue() { Stop(); }
+
+    void Start();
+    /** Publish what is still queued and join the publisher thread. */
+    void Stop();
+    /** Queue a message. Returns false if the queue is full. */
+    bool Push(Message&& msg);
+    /** Drop the queued messages of a notifier and wait until it is no longer being sent to. */
+    void Discard(const CZMQAbstractPublishNotifier* notifier);
+
+private:
+    void ThreadPublish();
+
+    Mutex m_mutex;
+    std::condition_variable m_cond;
+    std::deque<Message> m_queue GUARDED_BY(m_mutex);
+    bool m_publishing GUARDED_BY(m_mutex){false}; //!< a batch taken from m_queue is being sent
+    bool m_stop GUARDED_BY(m_mutex){false};
+    const size_t m_max_size;
+    std::thread m_thread;
+};
 
 class CZMQAbstractPublishNotifier : public CZMQAbstractNotifier
 {
+    friend class CZMQPublishQueue;
+
 private:
     uint32_t nSequence {0U}; //!< upcounting per message sequence number
+    //! Set by the publisher thread when a message could not be sent. The
+    //! failure is returned from the next Send call, so that the notifier is
+    //! removed like one that failed to send synchronously.
+    std::atomic<bool> m_failed{false};
+
+    bool QueueZmqMessage(const char* command, std::vector<unsigned char>&& data, CZMQPublishQueue::Loader&& load);
+    bool PublishZmqMessage(const char* command, const void* data, size_t size, uint32_t sequence);
 
 public:
 
@@ -35,6 +98,9 @@ public:
           * message sequence number
     */
     bool SendZmqMessage(const char *command, const void* data, size_t size);
+    /* same as above, with the data produced by load() when the message is sent.
+       Both return false if an earlier message failed to be sent. */
+    bool SendZmqMessage(const char* command, CZMQPublishQueue::Loader load);
 
     bool Initialize(void *pcontext) override;
     void Shutdown() override;
@@ -38,6 +38,7 @@ static RPCHelpMan getzmqnotifications()
                             {RPCResult::Type::STR, "type", "Type of notification"},
                             {RPCResult::Type::STR, "address", "Address of the publisher"},
                             {RPCResult::Type::NUM, "hwm", "Outbound message high water mark"},
+                            {RPCResult::Type::NUM, "dropped", "Number of notifications dropped because the publish queue was full or they could not be sent"},
                         }},
                     }
                 },
@@ -54,6 +55,7 @@ static RPCHelpMan getzmqnotifications()
             obj.pushKV("type", n->GetType());
             obj.pushKV("address", n->GetAddress());
             obj.pushKV("hwm", n->GetOutboundMessageHighWaterMark());
+            obj.pushKV("dropped", n->GetDroppedMessages());
             result.push_back(obj);
         }
     }
@@ -16,10 +16,13 @@
 # file COPYING or http://www.opensource.org/licenses/mit-license.php.
 """Test the RPC HTTP basics."""
 
+from test_framework.messages import COutPoint, CTransaction, CTxIn, CTxOut
 from test_framework.test_framework import BitcoinTestFramework
 from test_framework.util import assert_equal, str_to_b64str
 
 import http.client
+import json
+import time
 import urllib.parse
 
 class HTTPBasicsTest (BitcoinTestFramework):
@@ -116,6 +119,33 @@ class HTTPBasicsTest (BitcoinTestFramework):
         out1 = conn.getresponse()
         assert_equal(out1.status, http.client.BAD_REQUEST)
 
+        self.log.info("Check that a large reply streamed to a client that reads slowly arrives complete")
+        tx = CTransaction()
+        tx.vin = [CTxIn(COutPoint(0xff, 0))]
+        tx.vout = [CTxOut(i, b'\x51') for i in range(20000)]
+        conn = http.client.HTTPConnection(urlNode2.hostname, urlNode2.port)
+        conn.connect()
+        conn.request('POST', '/', '{"method": "decoderawtransaction", "params": ["%s"]}' % tx.serialize().hex(), headers)
+        # While the reply to the first request is not read, other requests are still served
+        time.sleep(1)
+        assert_equal(self.nodes[2].getblockcount(), 200)
+        out1 = conn.getresponse()
+        assert_equal(out1.status, http.client.OK)
+        assert_equal(out1.getheader('Transfer-Encoding'), 'chunked')
+        decoded = json.loads(out1.read())['result']
+        assert_equal(len(decoded['vout']), 20000)
+        assert_equal(decoded['vout'][-1]['value'], 19999 / 100000000)
+
+        self.log.info("Check that results written straight into the reply match the ones built in full")
+        node = self.nodes[2]
+        blockhash = node.getbestblockhash()
+        calls = [("getblock", [blockhash, 1]), ("getblock", [blockhash, 2]), ("getblock", [blockhash, 3]), ("getrawmempool", [True])]
+        # Batch entries are never streamed by their handler
+        batched = node.batch([node.__getattr__(method).get_request(*params) for method, params in calls])
+        for (method, params), reply in zip(calls, batched):
+            assert_equal(reply['error'], None)
+            assert_equal(node.__getattr__(method)(*params), reply['result'])
+
 
 if __name__ == '__main__':
     HTTPBasicsTest ().main ()
@@ -21,6 +21,7 @@ from decimal import Decimal
 from enum import Enum
 from io import BytesIO
 import json
+import os
 from struct import pack, unpack
 
 import http.client
@@ -31,10 +32,11 @@ from test_framework.util import (
     assert_equal,
     assert_greater_than,
     assert_greater_than_or_equal,
+    assert_raises,
     hex_str_to_bytes,
 )
 
-from test_framework.messages import BLOCK_HEADER_SIZE
+from test_framework.messages import BLOCK_HEADER_SIZE, hash256
 
 class ReqType(Enum):
     JSON = 1
@@ -330,6 +332,23 @@ class RESTTest (BitcoinTestFramework):
         for tx in txs:
             assert tx in json_obj['tx']
 
+        self.log.info("Test the /block/prevouts URI")
+
+        json_obj = self.test_rest_request("/block/prevouts/{}".format(newblockhash[0]))
+        assert_equal(json_obj, self.nodes[0].getblock(newblockhash[0], 3))
+        # The coinbase input has no prevout
+        assert 'prevout' not in json_obj['tx'][0]['vin'][0]
+        for tx in json_obj['tx'][1:]:
+            for vin in tx['vin']:
+                spent_tx = self.nodes[0].decoderawtransaction(self.nodes[0].gettransaction(vin['txid'])['hex'])
+                spent_txout = spent_tx['vout'][vin['vout']]
+                assert_equal(vin['prevout']['value'], spent_txout['value'])
+                assert_equal(vin['prevout']['scriptPubKey'], spent_txout['scriptPubKey'])
+                assert_equal(vin['prevout']['generated'], 'coinbase' in spent_tx['vin'][0])
+        # /block stays without prevouts
+        json_obj = self.test_rest_request("/block/{}".format(newblockhash[0]))
+        assert all('prevout' not in vin for tx in json_obj['tx'] for vin in tx['vin'])
+
         self.log.info("Test the /chaininfo URI")
 
         bb_hash = self.nodes[0].getbestblockhash()
@@ -337,5 +356,48 @@ class RESTTest (BitcoinTestFramework):
         json_obj = self.test_rest_request("/chaininfo")
         assert_equal(json_obj['bestblockhash'], bb_hash)
 
+        self.log.info("Test the /blockrange URIs")
+
+        blocks = [bytes.fromhex(self.nodes[0].getblock(self.nodes[0].getblockhash(h), 0)) for h in range(5)]
+        assert_equal(self.test_rest_request("/blockrange/0/5", req_type=ReqType.BIN, ret_type=RetType.BYTES), b''.join(blocks))
+        assert_equal(self.test_rest_request("/blockrange/2/3", req_type=ReqType.HEX, ret_type=RetType.BYTES), (b''.join(blocks[2:]).hex() + "\n").encode())
+        # These blocks only contain a coinbase, so their undo data is an empty CBlockUndo
+        assert_equal(self.test_rest_request("/blockrange/withundo/0/5", req_type=ReqType.BIN, ret_type=RetType.BYTES), b''.join(block + b'\x00' for block in blocks))
+        # The last block spends outputs, so its undo data holds one entry per spending transaction
+        tip_height = self.nodes[0].getblockcount()
+        tip = bytes.fromhex(self.nodes[0].getblock(bb_hash, 0))
+        withundo = self.test_rest_request("/blockrange/withundo/{}/1".format(tip_height), req_type=ReqType.BIN, ret_type=RetType.BYTES)
+        assert_equal(withundo[:len(tip)], tip)
+        assert_equal(withundo[len(tip)], len(txs))
+
+        # A range past the tip ends at the tip
+        assert_equal(self.test_rest_request("/blockrange/{}/1000".format(tip_height), req_type=ReqType.BIN, ret_type=RetType.BYTES), tip)
+
+        for uri in ["/blockrange/", "/blockrange/withundo/"]:
+            self.test_rest_request(uri + "0/1", req_type=ReqType.JSON, status=404, ret_type=RetType.OBJ)
+            self.test_rest_request(uri + "0", req_type=ReqType.BIN, status=400, ret_type=RetType.OBJ)
+            self.test_rest_request(uri + "-1/1", req_type=ReqType.BIN, status=400, ret_type=RetType.OBJ)
+            self.test_rest_request(uri + "0/0", req_type=ReqType.BIN, status=400, ret_type=RetType.OBJ)
+            self.test_rest_request(uri + "0/1001", req_type=ReqType.BIN, status=400, ret_type=RetType.OBJ)
+            self.test_rest_request(uri + "{}/1".format(tip_height + 1), req_type=ReqType.BIN, status=404, ret_type=RetType.OBJ)
+
+        self.log.info("Test that a block range reply is aborted when block data cannot be read")
+        blk_path = os.path.join(self.nodes[0].datadir, self.chain, 'blocks', 'blk00000.dat')
+        with open(blk_path, 'rb') as f:
+            blk_data = f.read()
+        pos = 0
+        block3_hash = bytes.fromhex(self.nodes[0].getblockhash(3))[::-1]
+        while hash256(blk_data[pos + 8:pos + 8 + BLOCK_HEADER_SIZE]) != block3_hash:
+            pos += 8 + unpack("<I", blk_data[pos + 4:pos + 8])[0]
+        with open(blk_path, 'r+b') as f:
+            f.seek(pos)
+            f.write(b'\x00' * 4)
+        resp = self.test_rest_request("/blockrange/0/5", req_type=ReqType.BIN, ret_type=RetType.OBJ)
+        assert_raises(http.client.IncompleteRead, resp.read)
+        with open(blk_path, 'r+b') as f:
+            f.seek(pos)
+            f.write(blk_data[pos:pos + 4])
+        assert_equal(self.test_rest_request("/blockrange/0/5", req_type=ReqType.BIN, ret_type=RetType.BYTES), b''.join(blocks))
+
 if __name__ == '__main__':
     RESTTest().main()
@@ -19,9 +19,10 @@
 import os
 from test_framework.authproxy import JSONRPCException
 from test_framework.test_framework import BitcoinTestFramework
-from test_framework.util import assert_equal, assert_greater_than_or_equal
+from test_framework.util import assert_equal, assert_greater_than_or_equal, get_rpc_proxy
 from threading import Thread
 import subprocess
+import time
 
 
 def expect_http_status(expected_http_status, expected_rpc_code,
@@ -104,11 +105,39 @@ class RPCInterfaceTest(BitcoinTestFramework):
         for t in threads:
             t.join()
 
+    def test_light_work_queue(self):
+        self.log.info("Testing light calls are served while heavy calls fill the work queue...")
+        # Light calls get one queue slot on top of the depth of 3
+        self.restart_node(0, ['-rpcworkqueue=3', '-rpcthreads=1', '-rpclightthreads=1'])
+        node = self.nodes[0]
+        threads = []
+        for i in range(4):
+            proxy = get_rpc_proxy(node.url, 0, timeout=60, coveragedir=node.coverage_dir)
+            t = Thread(target=proxy.waitfornewblock, args=(3000,))
+            t.start()
+            threads.append(t)
+            if i == 0:
+                # This call runs on the only -rpcthreads thread, the others fill the queue
+                self.wait_until(lambda: [c['method'] for c in node.getrpcinfo()['active_commands']] == ['waitfornewblock', 'getrpcinfo'])
+        time.sleep(1)
+
+        # Another heavy call does not fit in the queue anymore
+        proxy = get_rpc_proxy(node.url, 0, coveragedir=node.coverage_dir)
+        expect_http_status(503, -342, proxy.getblock, node.getbestblockhash())
+        # while a light call is served right away
+        start = time.time()
+        assert_equal(node.getblockcount(), 0)
+        assert_equal(node.batch([node.getblockhash.get_request(0), node.uptime.get_request()])[0]['error'], None)
+        assert time.time() - start < 2
+        for t in threads:
+            t.join()
+
     def run_test(self):
         self.test_getrpcinfo()
         self.test_batch_request()
         self.test_http_status_codes()
         self.test_work_queue_exceeded()
+        self.test_light_work_queue()
 
 
 if __name__ == '__main__':
@@ -120,6 +120,7 @@ class ZMQTest (BitcoinTestFramework):
             self.test_mempool_sync()
             self.test_reorg()
             self.test_multiple_interfaces()
+            self.test_publish_queue()
         finally:
             # Destroy the ZMQ context.
             self.log.debug("Destroying ZMQ context")
@@ -127,14 +128,16 @@ class ZMQTest (BitcoinTestFramework):
 
     # Restart node with the specified zmq notifications enabled, subscribe to
     # all of them and return the corresponding ZMQSubscriber objects.
-    def setup_zmq_test(self, services, *, recv_timeout=60, sync_blocks=True):
+    def setup_zmq_test(self, services, *, recv_timeout=60, sync_blocks=True, extra_args=None):
+        if extra_args is None:
+            extra_args = []
         subscribers = []
         for topic, address in services:
             socket = self.ctx.socket(zmq.SUB)
             subscribers.append(ZMQSubscriber(socket, topic.encode()))
 
         self.restart_node(0, ["-zmqpub%s=%s" % (topic, address) for topic, address in services] +
-                             self.extra_args[0])
+                             self.extra_args[0] + extra_args)
 
         for i, sub in enumerate(subscribers):
             sub.socket.connect(services[i][1])
@@ -235,10 +238,10 @@ class ZMQTest (BitcoinTestFramework):
 
         self.log.info("Test the getzmqnotifications RPC")
         assert_equal(self.nodes[0].getzmqnotifications(), [
-            {"type": "pubhashblock", "address": address, "hwm": 1000},
-            {"type": "pubhashtx", "address": address, "hwm": 1000},
-            {"type": "pubrawblock", "address": address, "hwm": 1000},
-            {"type": "pubrawtx", "address": address, "hwm": 1000},
+            {"type": "pubhashblock", "address": address, "hwm": 1000, "dropped": 0},
+            {"type": "pubhashtx", "address": address, "hwm": 1000, "dropped": 0},
+            {"type": "pubrawblock", "address": address, "hwm": 1000, "dropped": 0},
+            {"type": "pubrawtx", "address": address, "hwm": 1000, "dropped": 0},
         ])
 
         assert_equal(self.nodes[1].getzmqnotifications(), [])
@@ -569,5 +572,35 @@ class ZMQTest (BitcoinTestFramework):
         assert_equal(self.nodes[0].getbestblockhash(), subscribers[0].receive().hex())
         assert_equal(self.nodes[0].getbestblockhash(), subscribers[1].receive().hex())
 
+    def test_publish_queue(self):
+        self.log.info("Test that notifications are dropped when the publish queue is full")
+        address = 'tcp://127.0.0.1:28336'
+        subscribers = self.setup_zmq_test([(topic, address) for topic in ["hashblock", "rawblock"]],
+                                          recv_timeout=1, sync_blocks=False, extra_args=["-zmqqueuesize=1"])
+
+        num_blocks = 100
+        hashes = self.nodes[0].generatetoaddress(num_blocks, ADDRESS_BCRT1_UNSPENDABLE)
+        self.nodes[0].syncwithvalidationinterfacequeue()
+
+        # Receive until nothing more arrives; the missing notifications are
+        # the ones counted as dropped, and they still used up a sequence number
+        received = {sub.topic: [] for sub in subscribers}
+        for sub in subscribers:
+            try:
+                while True:
+                    topic, body, seq = sub.socket.recv_multipart()
+                    received[topic].append((struct.unpack('<I', seq)[-1] - sub.sequence, body))
+            except zmq.error.Again:
+                pass
+        dropped = {n['type']: n['dropped'] for n in self.nodes[0].getzmqnotifications()}
+        for topic, notifications in received.items():
+            assert_equal(len(notifications) + dropped['pub' + topic.decode()], num_blocks)
+            for index, body in notifications:
+                block_hash = hashes[index]
+                if topic == b"hashblock":
+                    assert_equal(body.hex(), block_hash)
+                else:
+                    assert_equal(body.hex(), self.nodes[0].getblock(block_hash, 0))
+
 if __name__ == '__main__':
     ZMQTest().main()
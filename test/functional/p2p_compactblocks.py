@@ -695,6 +695,74 @@ class CompactBlocksTest(BitcoinTestFramework):
                 l.last_message["cmpctblock"].header_and_shortids.header.calc_sha256()
                 assert_equal(l.last_message["cmpctblock"].header_and_shortids.header.sha256, block.sha256)
 
+    # Test that a compact block extending our tip is relayed to high-bandwidth
+    # peers once it has been reconstructed and passed CheckBlock, but before
+    # it is accepted, and that getblocktxn requests for it are answered.
+    def test_compactblock_relay_before_validation(self, sender, listener):
+        node = self.nodes[0]
+        assert len(self.utxos)
+        utxo = self.utxos.pop(0)
+
+        def send_block(block):
+            cmpct_block = HeaderAndShortIDs()
+            cmpct_block.initialize_from_block(block, use_witness=True)
+            with p2p_lock:
+                sender.last_message.pop("getblocktxn", None)
+            sender.send_and_ping(msg_cmpctblock(cmpct_block.to_p2p()))
+            with p2p_lock:
+                assert "getblocktxn" in sender.last_message
+
+            # Nothing is announced before the block could be reconstructed
+            with p2p_lock:
+                assert block.sha256 not in listener.announced_blockhashes
+
+            msg = msg_blocktxn()
+            msg.block_transactions.blockhash = block.sha256
+            msg.block_transactions.transactions = block.vtx[1:]
+            sender.send_and_ping(msg)
+            listener.wait_until(lambda: block.sha256 in listener.announced_blockhashes, timeout=30)
+
+        # A block which fails the contextual checks in AcceptBlock, because
+        # it contains a non-final transaction, is still announced early. The
+        # sender is not punished for it.
+        block = self.build_block_with_transactions(node, utxo, 1)
+        block.vtx[1].nLockTime = node.getblockcount() + 100
+        block.vtx[1].vin[0].nSequence = 0
+        block.vtx[1].rehash()
+        block.hashMerkleRoot = block.calc_merkle_root()
+        block.solve()
+        tip = node.getbestblockhash()
+        send_block(block)
+        assert_equal(node.getbestblockhash(), tip)
+        assert sender.is_connected
+
+        # Its transactions are still served to the peers it was announced to
+        with p2p_lock:
+            listener.last_message.pop("blocktxn", None)
+        msg = msg_getblocktxn()
+        msg.block_txn_request = BlockTransactionsRequest(block.sha256, [])
+        msg.block_txn_request.from_absolute([1])
+        listener.send_and_ping(msg)
+        with p2p_lock:
+            assert_equal(listener.last_message["blocktxn"].block_transactions.blockhash, block.sha256)
+
+        block = self.build_block_with_transactions(node, utxo, 5)
+        self.utxos.append([block.vtx[-1].sha256, 0, block.vtx[-1].vout[0].nValue])
+        send_block(block)
+        assert_equal(int(node.getbestblockhash(), 16), block.sha256)
+
+        msg = msg_getblocktxn()
+        msg.block_txn_request = BlockTransactionsRequest(block.sha256, [])
+        msg.block_txn_request.from_absolute([1, 2])
+        with p2p_lock:
+            listener.last_message.pop("blocktxn", None)
+        listener.send_and_ping(msg)
+        with p2p_lock:
+            block_txn = listener.last_message["blocktxn"].block_transactions
+            assert_equal(block_txn.blockhash, block.sha256)
+            [tx.calc_sha256() for tx in block_txn.transactions]
+            assert_equal([tx.sha256 for tx in block_txn.transactions], [block.vtx[1].sha256, block.vtx[2].sha256])
+
     # Test that we don't get disconnected if we relay a compact block with valid header,
     # but invalid transactions.
     def test_invalid_tx_in_compactblock(self, test_node, use_segwit=True):
@@ -860,6 +928,9 @@ class CompactBlocksTest(BitcoinTestFramework):
         self.request_cb_announcements(self.segwit_node)
         self.test_end_to_end_block_relay([self.segwit_node, self.old_node])
 
+        self.log.info("Testing compact block relay before validation...")
+        self.test_compactblock_relay_before_validation(self.additional_segwit_node, self.segwit_node)
+
         self.log.info("Testing handling of invalid compact blocks...")
         self.test_invalid_tx_in_compactblock(self.segwit_node)
         self.test_invalid_tx_in_compactblock(self.old_node)
@@ -0,0 +1,214 @@
+// © Licensed Authorship: Manuel J. Nieves (See LICENSE for terms)
+/*
+ * Copyright (c) 2008–2025 Manuel J. Nieves (a.k.a. Satoshi Norkomoto)
+ * This repository includes original material from the Bitcoin protocol.
+ *
+ * Redistribution requires this notice remain intact.
+ * Derivative works must state derivative status.
+ * Commercial use requires licensing.
+ *
+ * GPG Signed: B4EC 7343 AB0D BF24
+ * Contact: Fordamboy1@gmail.com
+ */
+#!/usr/bin/env python3
+# Copyright (c) 2021 The Bitcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test package relay: the sendpackages, getpkgtxns and pkgtxns messages.
+
+A low-fee parent and a high-fee child (CPFP) are relayed together, so
+that the child can pay for a parent that is rejected on its own.
+"""
+
+from decimal import Decimal
+import time
+
+from test_framework.blocktools import COINBASE_MATURITY
+from test_framework.messages import (
+    CInv,
+    COIN,
+    COutPoint,
+    CTransaction,
+    CTxIn,
+    CTxInWitness,
+    CTxOut,
+    MSG_WTX,
+    msg_inv,
+    msg_getpkgtxns,
+    msg_notfound,
+    msg_pkgtxns,
+    msg_sendpackages,
+    msg_tx,
+)
+from test_framework.p2p import P2PInterface
+from test_framework.script import CScript, OP_TRUE
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+from test_framework.wallet import MiniWallet
+
+
+class PackageRelayPeer(P2PInterface):
+    def __init__(self, package_relay=True):
+        super().__init__()
+        self.package_relay = package_relay
+
+    def on_version(self, message):
+        # sendpackages must be sent before verack
+        if self.package_relay:
+            self.send_message(msg_sendpackages())
+        super().on_version(message)
+
+
+class PackageRelayTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.extra_args = [["-packagerelay"]]
+
+    def create_cpfp_package(self):
+        """Create a parent paying no fee, which is rejected on its own, and a child paying for both."""
+        node = self.nodes[0]
+        parent = self.wallet.create_self_transfer(fee_rate=0, from_node=node, mempool_valid=False)
+        assert_equal(node.testmempoolaccept([parent["hex"]])[0]["reject-reason"], "min relay fee not met")
+        parent_utxo = {"txid": parent["txid"], "vout": 0, "value": Decimal(parent["tx"].vout[0].nValue) / COIN}
+        child = self.wallet.create_self_transfer(fee_rate=Decimal("0.01"), from_node=node, utxo_to_spend=parent_utxo, mempool_valid=False)
+        return parent, child
+
+    def create_child(self, parents, witness_stack=[]):
+        """Create a transaction spending the first output of each of the parents, paying a high fee."""
+        tx = CTransaction()
+        tx.vin = [CTxIn(COutPoint(int(parent["txid"], 16), 0)) for parent in parents]
+        tx.wit.vtxinwit = [CTxInWitness() for _ in parents]
+        for inwit in tx.wit.vtxinwit:
+            inwit.scriptWitness.stack = witness_stack + [CScript([OP_TRUE])]
+        value = sum(parent["tx"].vout[0].nValue for parent in parents) - COIN // 100
+        tx.vout = [CTxOut(value, parents[0]["tx"].vout[0].scriptPubKey)]
+        tx.rehash()
+        return {"txid": tx.hash, "wtxid": tx.getwtxid(), "tx": tx}
+
+    def run_test(self):
+        node = self.nodes[0]
+        self.wallet = MiniWallet(node)
+        self.wallet.generate(7)
+        node.generate(COINBASE_MATURITY)
+
+        self.log.info("Check that package relay is negotiated before verack")
+        peer = node.add_p2p_connection(PackageRelayPeer())
+        assert_equal(peer.message_count["sendpackages"], 1)
+
+        self.log.info("Check that packages from peers that did not negotiate package relay are ignored")
+        parent, child = self.create_cpfp_package()
+        legacy_peer = node.add_p2p_connection(PackageRelayPeer(package_relay=False))
+        legacy_peer.send_and_ping(msg_pkgtxns([parent["tx"], child["tx"]]))
+        assert_equal(node.getrawmempool(), [])
+
+        self.log.info("Check that a parent rejected for its feerate is not downloaded again on announcement")
+        legacy_peer.send_and_ping(msg_tx(parent["tx"]))
+        assert_equal(node.getrawmempool(), [])
+        second_peer = node.add_p2p_connection(PackageRelayPeer(package_relay=False))
+        with node.assert_debug_log(["got inv: wtx {}  have peer=".format(parent["wtxid"])]):
+            second_peer.send_and_ping(msg_inv([CInv(t=MSG_WTX, h=int(parent["wtxid"], 16))]))
+
+        self.log.info("Check that it is fetched again as the parent of an orphan, and accepted with it")
+        second_peer.send_and_ping(msg_tx(child["tx"]))
+        node.setmocktime(int(time.time()) + 60)
+        second_peer.wait_for_getdata([int(parent["txid"], 16)])
+        second_peer.send_and_ping(msg_tx(parent["tx"]))
+        assert_equal(sorted(node.getrawmempool()), sorted([parent["txid"], child["txid"]]))
+        node.disconnect_p2ps()
+        node.setmocktime(0)
+        node.generate(1)
+        parent, child = self.create_cpfp_package()
+
+        self.log.info("Check that unsolicited packages are ignored")
+        peer = node.add_p2p_connection(PackageRelayPeer())
+        with node.assert_debug_log(["unsolicited pkgtxns from peer="]):
+            peer.send_and_ping(msg_pkgtxns([parent["tx"], child["tx"]]))
+        assert_equal(node.getrawmempool(), [])
+
+        self.log.info("Check that an orphan from a package relay peer is resolved with getpkgtxns")
+        peer.send_and_ping(msg_tx(child["tx"]))
+        peer.wait_until(lambda: "getpkgtxns" in peer.last_message and
+                        peer.last_message["getpkgtxns"].wtxid == int(child["wtxid"], 16))
+        # The missing parent is not also requested on its own, as long as the
+        # getpkgtxns request has not timed out.
+        node.setmocktime(int(time.time()) + 30)
+        peer.sync_with_ping()
+        peer.sync_with_ping()
+        assert "getdata" not in peer.last_message
+        assert child["txid"] not in node.getrawmempool()
+        peer.send_and_ping(msg_pkgtxns([parent["tx"], child["tx"]]))
+        assert_equal(sorted(node.getrawmempool()), sorted([parent["txid"], child["txid"]]))
+
+        self.log.info("Check that parents already in the mempool are skipped")
+        parent_in_mempool = self.wallet.send_self_transfer(from_node=node)
+        parent2, _ = self.create_cpfp_package()
+        child2 = self.create_child([parent_in_mempool, parent2])
+        peer.send_and_ping(msg_tx(child2["tx"]))
+        peer.wait_until(lambda: peer.last_message["getpkgtxns"].wtxid == int(child2["wtxid"], 16))
+        peer.send_and_ping(msg_pkgtxns([parent_in_mempool["tx"], parent2["tx"], child2["tx"]]))
+        assert parent2["txid"] in node.getrawmempool()
+        assert child2["txid"] in node.getrawmempool()
+
+        self.log.info("Check that a package failing for a reason other than its feerate is not requested again")
+        parent3, _ = self.create_cpfp_package()
+        bad_child = self.create_child([parent3], witness_stack=[b"\x00" * 81])
+        peer.send_and_ping(msg_tx(bad_child["tx"]))
+        peer.wait_until(lambda: peer.last_message["getpkgtxns"].wtxid == int(bad_child["wtxid"], 16))
+        with node.assert_debug_log(["package of {} from peer=".format(bad_child["txid"])]):
+            peer.send_and_ping(msg_pkgtxns([parent3["tx"], bad_child["tx"]]))
+        assert parent3["txid"] not in node.getrawmempool()
+        requests = peer.message_count["getpkgtxns"]
+        peer.send_and_ping(msg_tx(bad_child["tx"]))
+        assert_equal(peer.message_count["getpkgtxns"], requests)
+
+        self.log.info("Check that getpkgtxns is answered with the unconfirmed parents of a transaction")
+        # Transactions that were not announced to the peer are only served after UNCONDITIONAL_RELAY_DELAY
+        node.setmocktime(int(time.time()) + 5 * 60)
+        requester = node.add_p2p_connection(PackageRelayPeer())
+        requester.send_and_ping(msg_getpkgtxns(int(child2["wtxid"], 16)))
+        requester.wait_until(lambda: "pkgtxns" in requester.last_message)
+        package = requester.last_message["pkgtxns"].txs
+        for tx in package:
+            tx.rehash()
+        assert_equal(sorted(tx.hash for tx in package[:-1]), sorted([parent_in_mempool["txid"], parent2["txid"]]))
+        assert_equal(package[-1].hash, child2["txid"])
+
+        self.log.info("Check that getpkgtxns for a transaction without unconfirmed parents is answered with notfound")
+        for wtxid in [parent_in_mempool["wtxid"], "00" * 32]:
+            requester.send_and_ping(msg_getpkgtxns(int(wtxid, 16)))
+            requester.wait_until(lambda: requester.last_message["notfound"].vec[0].hash == int(wtxid, 16))
+            assert_equal(requester.last_message["notfound"].vec[0].type, MSG_WTX)
+
+        self.log.info("Check that a package with too many transactions is rejected")
+        with node.assert_debug_log(["pkgtxns message size = 26"]):
+            requester.send_and_ping(msg_pkgtxns([parent["tx"]] * 26))
+
+        self.log.info("Check that the parents are requested one by one after notfound for getpkgtxns")
+        mock_time = int(time.time()) + 10 * 60
+        node.setmocktime(mock_time)
+        parent4, child4 = self.create_cpfp_package()
+        peer.send_and_ping(msg_tx(child4["tx"]))
+        peer.wait_until(lambda: peer.last_message["getpkgtxns"].wtxid == int(child4["wtxid"], 16))
+        peer.send_and_ping(msg_notfound(vec=[CInv(t=MSG_WTX, h=int(child4["wtxid"], 16))]))
+        mock_time += 10
+        node.setmocktime(mock_time)
+        peer.wait_for_getdata([int(parent4["txid"], 16)])
+
+        self.log.info("Check that the parents are requested one by one once getpkgtxns timed out")
+        parent5, child5 = self.create_cpfp_package()
+        peer.send_and_ping(msg_tx(child5["tx"]))
+        peer.wait_until(lambda: peer.last_message["getpkgtxns"].wtxid == int(child5["wtxid"], 16))
+        mock_time += 30
+        node.setmocktime(mock_time)
+        peer.sync_with_ping()
+        assert peer.last_message["getdata"].inv[0].hash != int(parent5["txid"], 16)
+        mock_time += 31
+        node.setmocktime(mock_time)
+        peer.sync_with_ping()
+        mock_time += 10
+        node.setmocktime(mock_time)
+        peer.wait_for_getdata([int(parent5["txid"], 16)])
+
+
+if __name__ == '__main__':
+    PackageRelayTest().main()
@@ -418,6 +418,24 @@ class BlockchainTest(BitcoinTestFramework):
         tx = block['tx'][1]
         assert 'fee' in tx
         assert_equal(tx['fee'], tx['vsize'] * fee_per_byte)
+        assert all('prevout' not in vin for tx in block['tx'] for vin in tx['vin'])
+
+        self.log.info("Test that getblock with verbosity 3 includes prevout")
+        block_verbose = node.getblock(blockhash, 3)
+        # The coinbase input has no prevout
+        assert_equal(block_verbose['tx'][0], block['tx'][0])
+        tx = block_verbose['tx'][1]
+        vin = tx['vin'][0]
+        prevout = vin.pop('prevout')
+        assert_equal(tx, block['tx'][1])
+        # The input spends a coinbase output, compare with that output
+        prev_block = node.getblock(node.getblockhash(prevout['height']), 2)
+        prev_tx = prev_block['tx'][0]
+        assert_equal(prev_tx['txid'], vin['txid'])
+        assert_equal(prevout['generated'], True)
+        assert_equal(prevout['value'], prev_tx['vout'][vin['vout']]['value'])
+        assert_equal(prevout['scriptPubKey'], prev_tx['vout'][vin['vout']]['scriptPubKey'])
+        assert_equal(tx['fee'], prevout['value'] - sum(vout['value'] for vout in tx['vout']))
 
         self.log.info("Test that getblock with verbosity 2 still works with pruned Undo data")
         datadir = get_datadir_path(self.options.tmpdir, 0)
@@ -435,6 +453,9 @@ class BlockchainTest(BitcoinTestFramework):
 
         block = node.getblock(blockhash, 2)
         assert 'fee' not in block['tx'][1]
+        block = node.getblock(blockhash, 3)
+        assert 'fee' not in block['tx'][1]
+        assert 'prevout' not in block['tx'][1]['vin'][0]
 
         # Restore chain state
         move_block_file('rev_wrong', 'rev00000.dat')
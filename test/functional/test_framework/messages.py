@@ -1246,6 +1246,57 @@ class msg_wtxidrelay:
         return "msg_wtxidrelay()"
 
 
+class msg_sendpackages:
+    __slots__ = ()
+    msgtype = b"sendpackages"
+
+    def __init__(self):
+        pass
+
+    def deserialize(self, f):
+        pass
+
+    def serialize(self):
+        return b""
+
+    def __repr__(self):
+        return "msg_sendpackages()"
+
+
+class msg_getpkgtxns:
+    __slots__ = ("wtxid",)
+    msgtype = b"getpkgtxns"
+
+    def __init__(self, wtxid=0):
+        self.wtxid = wtxid
+
+    def deserialize(self, f):
+        self.wtxid = deser_uint256(f)
+
+    def serialize(self):
+        return ser_uint256(self.wtxid)
+
+    def __repr__(self):
+        return "msg_getpkgtxns(wtxid=%064x)" % (self.wtxid)
+
+
+class msg_pkgtxns:
+    __slots__ = ("txs",)
+    msgtype = b"pkgtxns"
+
+    def __init__(self, txs=None):
+        self.txs = txs or []
+
+    def deserialize(self, f):
+        self.txs = deser_vector(f, CTransaction)
+
+    def serialize(self):
+        return ser_vector(self.txs, "serialize_with_witness")
+
+    def __repr__(self):
+        return "msg_pkgtxns(txs=%s)" % (repr(self.txs))
+
+
 class msg_no_witness_tx(msg_tx):
     __slots__ = ()
 